@@ -33,10 +33,47 @@
   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+  16-oct-2026 agent   bulk word conversion
   06-jan-2022 JH      created
 
  */
 #include "bytebuffer.hpp"
 
-// all methods in hpp, for better inlining
+// most methods in hpp, for better inlining.
+// Here only the bulk word conversion.
+
+// host memory order of uint16_t
+static const bool host_is_little_endian = (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) ;
+
+// copy words from "src" to "dst" and exchange bytes in each
+static void words_copy_swapped(uint8_t *dst, const uint8_t *src, unsigned word_count)
+{
+    for (unsigned i = 0; i < word_count; i++) {
+        dst[2 * i] = src[2 * i + 1] ;
+        dst[2 * i + 1] = src[2 * i] ;
+    }
+}
+
+// PDP11 and little endian words have LSB first,
+// so only big endian buffers or a big endian host need swapping.
+static bool words_need_swap(enum endianness_e endianness)
+{
+    return (endianness == endianness_big) == host_is_little_endian ;
+}
+
+void byte_buffer_words_from_bytes(uint16_t *words, const uint8_t *bytes, unsigned word_count, enum endianness_e endianness)
+{
+    if (words_need_swap(endianness))
+        words_copy_swapped((uint8_t *)words, bytes, word_count) ;
+    else
+        memcpy(words, bytes, 2 * word_count) ;
+}
+
+void byte_buffer_words_to_bytes(uint8_t *bytes, const uint16_t *words, unsigned word_count, enum endianness_e endianness)
+{
+    if (words_need_swap(endianness))
+        words_copy_swapped(bytes, (const uint8_t *)words, word_count) ;
+    else
+        memcpy(bytes, words, 2 * word_count) ;
+}
 
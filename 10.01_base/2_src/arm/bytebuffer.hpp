@@ -33,6 +33,8 @@
   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+  16-oct-2026 agent   bulk word access
+  16-oct-2026 agent   move semantics, byte_buffer_view_c
   06-jan-2022 JH      created
 
  */
@@ -49,6 +51,10 @@
 
 #include "utils.hpp" // endianness
 
+// Copy "word_count" 16 bit words between host uint16_t[] and the byte
+// layout of "endianness". Unaligned "bytes" allowed.
+void byte_buffer_words_from_bytes(uint16_t *words, const uint8_t *bytes, unsigned word_count, enum endianness_e endianness) ;
+void byte_buffer_words_to_bytes(uint8_t *bytes, const uint16_t *words, unsigned word_count, enum endianness_e endianness) ;
 
 // most code here, so much inlining
 class byte_buffer_c
@@ -105,6 +111,38 @@ public:
         return *this ;
     }
 
+    // move constructor: take over data, "other" is empty then.
+    // noexcept: std::vector<> moves elements on growth
+    byte_buffer_c(byte_buffer_c&& other) noexcept
+    {
+        endianness = other.endianness ;
+        zero_byte_val = other.zero_byte_val ;
+        _data = other._data ;
+        _size = other._size ;
+        other._data = nullptr ;
+        other._size = 0 ;
+    }
+
+    // move assignment
+    byte_buffer_c& operator=(byte_buffer_c&& other) noexcept
+    {
+        if (this == &other)
+            return *this ;
+        if (_data != nullptr)
+            free(_data) ;
+        endianness = other.endianness ;
+        zero_byte_val = other.zero_byte_val ;
+        _data = other._data ;
+        _size = other._size ;
+        other._data = nullptr ;
+        other._size = 0 ;
+        return *this ;
+    }
+
+    enum endianness_e get_endianness() const {
+        return endianness ;
+    }
+
     bool is_empty() const {
         return (_size == 0) ;
     }
@@ -135,9 +173,11 @@ public:
 
 
     // several ways to set an empty or filled buffer
-    void set_data(uint8_t *src_data, unsigned src_size)
+    void set_data(const uint8_t *src_data, unsigned src_size)
     {
         set_size(src_size) ;
+        if (src_size == 0)
+            return ;
         assert(_data != nullptr) ;
         memcpy(_data, src_data, src_size);
     }
@@ -274,7 +314,115 @@ public:
         set_word_at_byte_offset(2 * _word_offset, val) ;
     }
 
+    // bulk word access, in buffer endianness
+    void get_words_at_byte_offset(uint32_t _byte_offset, uint16_t *words, unsigned word_count) const
+    {
+        assert(_byte_offset + 2 * word_count <= _size) ;
+        byte_buffer_words_from_bytes(words, _data + _byte_offset, word_count, endianness) ;
+    }
+    void set_words_at_byte_offset(uint32_t _byte_offset, const uint16_t *words, unsigned word_count)
+    {
+        assert(_byte_offset + 2 * word_count <= _size) ;
+        byte_buffer_words_to_bytes(_data + _byte_offset, words, word_count, endianness) ;
+    }
+    void get_words_at_word_offset(uint32_t _word_offset, uint16_t *words, unsigned word_count) const
+    {
+        get_words_at_byte_offset(2 * _word_offset, words, word_count) ;
+    }
+    void set_words_at_word_offset(uint32_t _word_offset, const uint16_t *words, unsigned word_count)
+    {
+        set_words_at_byte_offset(2 * _word_offset, words, word_count) ;
+    }
+
+
+} ;
+
+
+// Read-only window on bytes owned by someone else:
+// a byte_buffer_c, or image data in memory (storageimage_base_c::get_bytes_view()).
+// Valid as long as the viewed memory is, never frees.
+class byte_buffer_view_c
+{
+private:
+    enum endianness_e endianness ;
+    const uint8_t *_data ;
+    uint32_t _size ;
+
+public:
+    byte_buffer_view_c()
+    {
+        _data = nullptr ;
+        _size = 0 ;
+        endianness = endianness_pdp11 ;
+    }
+
+    byte_buffer_view_c(const uint8_t *data, uint32_t size, enum endianness_e _endianness = endianness_pdp11)
+    {
+        _data = data ;
+        _size = size ;
+        endianness = _endianness ;
+    }
+
+    // whole buffer
+    byte_buffer_view_c(const byte_buffer_c &bb)
+        : byte_buffer_view_c(bb.data_ptr(), bb.size(), bb.get_endianness()) {}
 
+    // "size" bytes from "byte_offset"
+    byte_buffer_view_c subview(uint32_t byte_offset, uint32_t size) const
+    {
+        assert(byte_offset + size <= _size) ;
+        return byte_buffer_view_c(_data + byte_offset, size, endianness) ;
+    }
+
+    bool is_empty() const {
+        return (_size == 0) ;
+    }
+
+    const uint8_t *data_ptr() const {
+        return _data ;
+    }
+
+    unsigned size() const {
+        return _size ;
+    }
+
+    uint8_t operator [](unsigned _byte_offset) const {
+        assert(_byte_offset < _size) ;
+        return _data[_byte_offset];
+    }
+
+    bool is_zero_data(uint8_t val) const
+    {
+        for (unsigned i = 0 ; i < _size ; i++)
+            if (_data[i] != val)
+                return false;
+        return true;
+    }
+
+    // PDP11 endianness
+    uint16_t get_word_at_byte_offset(uint32_t _byte_offset) const
+    {
+        assert(_byte_offset + 1 < _size) ;
+        assert(endianness == endianness_pdp11) ; // todo: implement other?
+        const uint8_t *addr = _data + _byte_offset ;
+        // LSB first
+        return (uint16_t)addr[0] | (uint16_t)(addr[1] << 8);
+    }
+
+    uint16_t get_word_at_word_offset(uint32_t _word_offset) const
+    {
+        return get_word_at_byte_offset(2 * _word_offset) ;
+    }
+
+    void get_words_at_byte_offset(uint32_t _byte_offset, uint16_t *words, unsigned word_count) const
+    {
+        assert(_byte_offset + 2 * word_count <= _size) ;
+        byte_buffer_words_from_bytes(words, _data + _byte_offset, word_count, endianness) ;
+    }
+    void get_words_at_word_offset(uint32_t _word_offset, uint16_t *words, unsigned word_count) const
+    {
+        get_words_at_byte_offset(2 * _word_offset, words, word_count) ;
+    }
 } ;
 
 #endif // __BYTEBUFFER_HPP_
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ oct-2026     agent   no realtime priorities with virtual PRU
  12-nov-2018  JH      entered beta phase
 
  Abstract device, with or without QBUS/UNIBUS registers.
@@ -45,6 +46,7 @@
 #include "utils.hpp"
 #include "logger.hpp"
 #include "timeout.hpp"
+#include "pru.hpp"
 #include "device.hpp"
 
 // declare device list of class separate
@@ -210,6 +212,11 @@ void device_c::worker_init_realtime_priority(enum worker_priority_e priority)
 	// /proc/sys/kernel/sched_rt_period_us containing 1000000 and /proc/sys/kernel/sched_rt_runtime_us containing 950000
 	// See https://www.kernel.org/doc/Documentation/scheduler/sched-rt-group.txt
 
+	// The virtual PRU is an ordinary thread, polling the mailbox.
+	// RT workers spinning in mailbox_execute() would starve it on single core hosts.
+	if (pru && pru->is_virtual())
+		priority = none_rt;
+
 	switch (priority) {
 	case rt_max:
 		// 1. assert path exists
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   virtual PRU: GPIO registers in process memory
  21-may-2019  JH      added UNIBUS signals
  12-nov-2018  JH      entered beta phase
  */
@@ -87,9 +88,13 @@ void gpios_c::bank_map_registers(unsigned bank_idx, unsigned unmapped_start_addr
     bank->registerrange_addr_unmapped = unmapped_start_addr; // info only
     INFO("GPIO%d registers at %X - %X (size = %X)", bank_idx, unmapped_start_addr,
          unmapped_start_addr + GPIO_SIZE - 1, GPIO_SIZE);
-    bank->registerrange_start_addr = (uint8_t *) mmap(0, GPIO_SIZE, PROT_READ | PROT_WRITE,
-                                     MAP_SHARED, memory_filedescriptor, unmapped_start_addr);
-    if (bank->registerrange_start_addr == MAP_FAILED)
+    if (pru->is_virtual())
+        // no hardware: registers are just memory cells
+        bank->registerrange_start_addr = (uint8_t *) calloc(1, GPIO_SIZE);
+    else
+        bank->registerrange_start_addr = (uint8_t *) mmap(0, GPIO_SIZE, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED, memory_filedescriptor, unmapped_start_addr);
+    if (bank->registerrange_start_addr == MAP_FAILED || bank->registerrange_start_addr == NULL)
         FATAL("Unable to map GPIO%d", bank_idx);
 
     bank->oe_addr = (uint32_t *) (bank->registerrange_start_addr + GPIO_OE_ADDROFFSET);
@@ -134,6 +139,9 @@ void gpios_c::export_pin(gpio_config_t *pin)
     FILE *f;
     struct stat statbuff;
 
+    if (pru->is_virtual())
+        return;
+
     sprintf(fname, "/sys/class/gpio/export");
     f = fopen(fname, "w");
     if (!f)
@@ -238,6 +246,8 @@ void gpios_c::init()
 // frequency = 0: stable 0 level on timer5 pin
 void gpios_c::set_frequency(unsigned frequency)
 {
+    if (pru->is_virtual())
+        return; // no timer5
     // timer5 is programmed to toggle the output on each timer reload
 
     // map registers
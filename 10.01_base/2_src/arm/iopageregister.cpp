@@ -43,8 +43,8 @@ int iopageregisters_connect(void)
 {
 	void *pru_shared_dataram;
 	// get pointer to RAM
-	if (prussdrv_map_prumem(PRU_DEVICEREGISTER_RAM_ID, &pru_shared_dataram)) {
-		fprintf(stderr, "prussdrv_map_prumem() failed\n");
+	if (pru->map_prumem(PRU_DEVICEREGISTER_RAM_ID, &pru_shared_dataram)) {
+		fprintf(stderr, "map_prumem() failed\n");
 		return -1;
 
 	}
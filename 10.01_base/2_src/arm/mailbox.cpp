@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ oct-2026     agent   mailbox_lock()
  12-nov-2018  JH      entered beta phase
  */
 
@@ -45,8 +46,8 @@ int mailbox_connect(void)
 {
 	void *pru_shared_dataram;
 	// get pointer to RAM
-	if (prussdrv_map_prumem(PRU_MAILBOX_RAM_ID, &pru_shared_dataram)) {
-		printf("ERROR: prussdrv_map_prumem() failed\n");
+	if (pru->map_prumem(PRU_MAILBOX_RAM_ID, &pru_shared_dataram)) {
+		printf("ERROR: map_prumem() failed\n");
 		return -1;
 
 	}
@@ -106,7 +107,20 @@ void mailbox_test1()
  */
 //uint32_t xxx;
 
-pthread_mutex_t arm2pru_mutex = PTHREAD_MUTEX_INITIALIZER ;
+// recursive: mailbox_lock() holds it while payload is set up for mailbox_execute()
+pthread_mutex_t arm2pru_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP ;
+
+// reserve mailbox for setup of opcode parameters and mailbox_execute().
+// Needed if opcode data are shared by parallel threads.
+void mailbox_lock(void)
+{
+	pthread_mutex_lock(&arm2pru_mutex) ;
+}
+
+void mailbox_unlock(void)
+{
+	pthread_mutex_unlock(&arm2pru_mutex) ;
+}
 
 bool  mailbox_execute(uint8_t request) 
 {
@@ -115,12 +129,13 @@ bool  mailbox_execute(uint8_t request)
 
 	__sync_synchronize();
 	while (mailbox->arm2pru_req != ARM2PRU_NONE)
-		; // wait to complete
+		pru->busywait_yield(); // wait to complete
 
 	mailbox->arm2pru_req = request; // go!
 
 	// wait until ACKed	
-	while (mailbox->arm2pru_req == request);
+	while (mailbox->arm2pru_req == request)
+		pru->busywait_yield();
 	/*
 	do {
 		xxx = mailbox->arm2pru_req;
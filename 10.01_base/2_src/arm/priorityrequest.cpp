@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   dma_request_c::wait()
  jul-2019     JH      start: multiple parallel arbitration levels	 
  */
 
@@ -85,6 +86,21 @@ dma_request_c::~dma_request_c()
 	}
 }
 
+// wait for end of a DMA(), started with blocking=false.
+// Returns immediately if already complete, or canceled by INIT.
+// result: false on QBUS/UNIBUS timeout
+bool dma_request_c::wait()
+{
+	pthread_mutex_lock(&complete_mutex);
+	while (!complete) {
+		int res = pthread_cond_wait(&complete_cond, &complete_mutex);
+		assert(!res);
+		UNUSED(res);
+	}
+	pthread_mutex_unlock(&complete_mutex);
+	return success;
+}
+
 // create invalid requests, is setup by qunibusadapter
 intr_request_c::intr_request_c(qunibusdevice_c *_device) :
 		priority_request_c(_device) 
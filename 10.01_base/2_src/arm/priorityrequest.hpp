@@ -21,6 +21,8 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   dma_request_c::wait(): completion handle for non-blocking DMA()
+ 16-oct-2026  agent   scatter-gather DMA: list of segments, chunks queued on PRU
  jul-2019     JH      start: multiple parallel arbitration levels	 
  */
 
@@ -61,6 +63,13 @@
 
 class qunibusdevice_c;
 
+// one contiguous block of a scatter-gather DMA
+typedef struct {
+	uint32_t qunibus_addr;
+	uint16_t *buffer;
+	uint32_t wordcount;
+} dma_segment_t;
+
 // (almost) abstract base class for dma and intr requests
 class priority_request_c: public logsource_c {
 	friend class intr_request_c;
@@ -101,6 +110,14 @@ public:
 	~dma_request_c();
 	// const for all chunks
 	uint8_t qunibus_control; // DATI,DATO
+
+	// scatter-gather DMA: list of segments, transfered in one bus request.
+	// NULL for single block DMA. List and buffers must be valid until complete.
+	const dma_segment_t *segments;
+	unsigned segment_count;
+	unsigned segment_index; // segment of next chunk to queue
+
+	// current segment
 	uint32_t qunibus_start_addr;
 	uint32_t qunibus_end_addr;
 	uint16_t* buffer;
@@ -109,9 +126,10 @@ public:
 	bool is_cpu_access; // true if DMA is CPU memory access
 
 	// DMA transaction are divided in to smaller DAT transfer "chunks" 
-	uint32_t chunk_max_words; // max is PRU capacity PRU_MAX_DMA_WORDCOUNT (512)
-	uint32_t chunk_qunibus_start_addr; // current chunk
-	uint32_t chunk_words; // size of current chunks
+	uint32_t chunk_max_words; // max is PRU capacity PRU_MAX_DMA_WORDCOUNT (2048)
+	uint32_t chunk_qunibus_start_addr; // next chunk to queue
+	uint32_t chunk_words; // size of last queued chunk
+	bool chunk_failed; // a chunk ended with timeout or INIT, queued successors canceled
 
 	volatile bool success; // DMA can fail with bus timeout
 
@@ -120,11 +138,23 @@ public:
 		return buffer + (chunk_qunibus_start_addr - qunibus_start_addr) / 2;
 	}
 
-	// words already transfered in previous chunks
-	uint32_t wordcount_completed_chunks(void) {
+	// words of current segment already queued to PRU in previous chunks
+	uint32_t wordcount_queued_chunks(void) {
 		return (chunk_qunibus_start_addr - qunibus_start_addr) / 2;
 	}
 
+	// more chunks to queue in this or following segments?
+	bool chunks_remaining(void) {
+		return wordcount_queued_chunks() < wordcount || segment_index + 1 < segment_count;
+	}
+
+	// Completion handle for DMA(..., blocking=false):
+	// device may prepare the next buffer while the bus transfer runs.
+	bool is_complete(void) {
+		return complete;
+	}
+	bool wait(void); // block until complete, result: success
+
 };
 
 struct qunibusdevice_register_struct;
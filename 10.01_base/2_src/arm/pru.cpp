@@ -54,6 +54,7 @@
 #include "mailbox.h"
 #include "ddrmem.h"
 #include "iopageregister.h"
+#include "pru_virtual.hpp"
 
 #include "pru.hpp"
 
@@ -90,6 +91,8 @@ pru_c *pru;
 pru_c::pru_c() 
 {
 	prucode_id = PRUCODE_NONE;
+	backend = BACKEND_PRUSS;
+	virtual_pru = NULL;
 	log_label = "PRU";
 }
 
@@ -145,6 +148,23 @@ int pru_c::start(enum prucode_enum _prucode_id)
 	// use stop() before restart()
 	assert(this->prucode_id == PRUCODE_NONE);
 
+	if (backend == BACKEND_VIRTUAL) {
+		// no prussdrv, no code download: thread executes PRU1 command loop
+		if (virtual_pru == NULL)
+			virtual_pru = new pru_virtual_c();
+		virtual_pru->start();
+		ddrmem->info();
+		mailbox_connect();
+		iopageregisters_connect();
+		INFO("Started virtual PRU for code id = %d", _prucode_id);
+		prucode_id = _prucode_id;
+		mailbox->arm2pru_req = ARM2PRU_NOP;
+		timeout.wait_ms(1);
+		if (mailbox->arm2pru_req != ARM2PRU_NONE)
+			FATAL("Virtual PRU is not executing its command loop");
+		return 0;
+	}
+
 	/* initialize PRU */
 	if ((rtn = prussdrv_init()) != 0) {
 		ERROR("prussdrv_init() failed");
@@ -243,6 +263,12 @@ int pru_c::stop(void)
 	int rtn = 0;
 	prucode_id = PRUCODE_NONE;
 
+	if (backend == BACKEND_VIRTUAL) {
+		if (virtual_pru)
+			virtual_pru->stop();
+		return 0;
+	}
+
 	/* clear the event (if asserted) */
 	if (prussdrv_pru_clear_event(PRU_EVTOUT_0, PRU0_ARM_INTERRUPT)) {
 		ERROR("prussdrv_pru_clear_event() failed");
@@ -269,3 +295,35 @@ int pru_c::stop(void)
 	return rtn;
 }
 
+
+/*** pru_c::map_prumem() -- get ARM address of PRU RAM
+ Mailbox and device register tables are located there.
+ PRU_MAILBOX_RAM_ID or PRU_DEVICEREGISTER_RAM_ID
+ Returns 0 on success, non-0 on error.
+ ***/
+int pru_c::map_prumem(unsigned pru_ram_id, void **address) 
+{
+	if (backend == BACKEND_VIRTUAL)
+		return virtual_pru->map_prumem(pru_ram_id, address);
+	else
+		return prussdrv_map_prumem(pru_ram_id, address);
+}
+
+/*** pru_c::wait_event() -- wait for PRU2ARM_INTERRUPT
+ Returns 0 on timeout, -1 on error, else count of events received.
+ ***/
+int pru_c::wait_event(unsigned timeout_us) 
+{
+	if (backend == BACKEND_VIRTUAL)
+		return virtual_pru->wait_event(timeout_us);
+	else
+		return prussdrv_pru_wait_event_timeout(PRU_EVTOUT_0, timeout_us);
+}
+
+// re-arm PRU2ARM_INTERRUPT after wait_event()
+void pru_c::clear_event(void) 
+{
+	if (backend == BACKEND_PRUSS)
+		prussdrv_pru_clear_event(PRU_EVTOUT_0, PRU0_ARM_INTERRUPT);
+	// virtual: cleared in wait_event()
+}
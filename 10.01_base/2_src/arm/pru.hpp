@@ -31,6 +31,7 @@
  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+ 16-oct-2026  agent   virtual PRU backend, runs without BeagleBone
  18-apr-2019  JH      added PRU code dictionary
  12-nov-2018  JH      entered beta phase
  */
@@ -39,6 +40,7 @@
 #define _PRU_HPP_
 
 #include <stdint.h>
+#include <sched.h>
 #include "prussdrv.h"
 
 #include "logsource.hpp"
@@ -68,8 +70,15 @@
 #define PRU_DEVICEREGISTER_RAM_OFFSET	0
 #endif
 
+class pru_virtual_c ;
+
 class pru_c: public logsource_c {
 public:
+	// where are mailbox and device registers, who executes the bus protocols?
+	enum backend_enum {
+		BACKEND_PRUSS = 0, // real PRUs via prussdrv, physical QBUS/UNIBUS
+		BACKEND_VIRTUAL = 1 // PRU1 emulated by a thread, in-process bus model
+	};
 	// IDs for code variants, so callers can select one
 	enum prucode_enum {
 		PRUCODE_EOD = 0, // special marker: end of dictionary
@@ -81,9 +90,28 @@ public:
 public:
 	enum prucode_enum prucode_id; // currently running code
 
+	enum backend_enum backend; // select before start()
+	pru_virtual_c *virtual_pru; // if BACKEND_VIRTUAL
+
 	pru_c();
 	int start(enum prucode_enum prucode_id);
 	int stop(void);
+
+	bool is_virtual(void) {
+		return backend == BACKEND_VIRTUAL;
+	}
+
+	// call in loops busy waiting for the PRU:
+	// the virtual PRU is a thread and may need the cpu core.
+	void busywait_yield(void) {
+		if (backend == BACKEND_VIRTUAL)
+			sched_yield();
+	}
+
+	// backend independent access to PRU RAM and PRU->ARM interrupt
+	int map_prumem(unsigned pru_ram_id, void **address);
+	int wait_event(unsigned timeout_us);
+	void clear_event(void);
 };
 
 extern pru_c *pru; // singleton
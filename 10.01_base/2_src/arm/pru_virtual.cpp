@@ -0,0 +1,758 @@
+/* pru_virtual.cpp: software replacement for PRU1 and the physical bus
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026  agent   timestamp of PRU2ARM_INTERRUPT for latency statistics
+ 16-oct-2026  agent   event ring for posted DATO and INTR complete
+ 16-oct-2026  agent   created
+
+ The worker() follows pru1_main_unibus.c / pru1_main_qbus.c:
+ - ARM2PRU_* opcodes are processed and ACKed with ARM2PRU_NONE
+ - INIT, ACLO/DCLO (POK/DCOK) changes generate "init" and "power" events
+ - DMA and INTR requests are granted by an ideal arbitrator,
+   or by the emulated CPU logic, if ARM2PRU_CPU_ENABLE is set.
+ - access to "active" device registers raises "deviceregister" events.
+   Like SSYN/RPLY held on the physical bus, all further bus traffic
+   is stalled until ARM ACKs the event.
+ - posted DATOs and INTR completions go into the mailbox event ring.
+ Differences to the physical PRU:
+ - no bus timing, no bus timeouts: unimplemented addresses fail immediately.
+ - a DMA is not interrupted by register events, it continues after ACK.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "logger.hpp"
+#include "utils.hpp"
+#include "timeout.hpp"
+#include "pru.hpp"
+#include "qunibus.h"
+#include "mailbox.h"
+#include "ddrmem.h"
+#include "iopageregister.h"
+
+#include "pru_virtual.hpp"
+
+// which latch holds the initialization signals INIT, ACLO/DCLO or POK/DCOK?
+#if defined(UNIBUS)
+#define INITIALIZATIONSIGNAL_LATCH	7
+#define INITIALIZATIONSIGNAL_POWER	(INITIALIZATIONSIGNAL_ACLO | INITIALIZATIONSIGNAL_DCLO)
+#elif defined(QBUS)
+#define INITIALIZATIONSIGNAL_LATCH	5
+#define INITIALIZATIONSIGNAL_POWER	(INITIALIZATIONSIGNAL_POK | INITIALIZATIONSIGNAL_DCOK)
+#endif
+
+pru_virtual_c::pru_virtual_c()
+{
+	log_label = "VPRU";
+
+	shared_dataram = (uint8_t *) calloc(1, PRU_VIRTUAL_SHARED_DATARAM_SIZE);
+	pru0_dataram = (uint8_t *) calloc(1, PRU_VIRTUAL_PRU0_DATARAM_SIZE);
+	ddr = (ddrmem_t *) calloc(1, sizeof(ddrmem_t));
+	if (!shared_dataram || !pru0_dataram || !ddr)
+		FATAL("Can not allocate memory for virtual PRU");
+	assert(PRU_MAILBOX_RAM_OFFSET + sizeof(mailbox_t) <= PRU_VIRTUAL_SHARED_DATARAM_SIZE);
+	assert(PRU_DEVICEREGISTER_RAM_OFFSET + sizeof(pru_iopage_registers_t) <= PRU_VIRTUAL_PRU0_DATARAM_SIZE);
+	mb = (volatile mailbox_t *) (shared_dataram + PRU_MAILBOX_RAM_OFFSET);
+	regs = (volatile pru_iopage_registers_t *) (pru0_dataram + PRU_DEVICEREGISTER_RAM_OFFSET);
+
+	pthread_mutex_init(&event_mutex, NULL);
+	pthread_cond_init(&event_cond, NULL);
+	event_count = event_count_seen = 0;
+	signal_ns = 0;
+	pthread_mutex_init(&bus_mutex, NULL);
+	bus_owned = false;
+	thread_terminate = true; // not running
+
+	stat_opcodes = stat_events = stat_dma_words = stat_intrs = stat_slave_cycles = 0;
+	stat_dma_chunks = stat_dma_chunks_staged = 0;
+	stat_ring_events = 0;
+}
+
+pru_virtual_c::~pru_virtual_c()
+{
+	stop();
+	pthread_cond_destroy(&event_cond);
+	pthread_mutex_destroy(&event_mutex);
+	pthread_mutex_destroy(&bus_mutex);
+	free(ddr);
+	free(pru0_dataram);
+	free(shared_dataram);
+}
+
+// setup ddrmem like prussdrv_map_extmem() and start the PRU1 replacement thread
+void pru_virtual_c::start()
+{
+	if (!thread_terminate)
+		return; // already running
+
+	// PRU accesses DDR over physical address, here both are the same memory.
+	// base_physical is only 32 bit, so not usable as pointer on 64 bit hosts.
+	ddrmem->base_virtual = ddr;
+	ddrmem->len = sizeof(ddrmem_t);
+	ddrmem->base_physical = 0;
+
+	// state after PRU1 reset
+	memset((void *) regs, 0, sizeof(pru_iopage_registers_t));
+	memset(buslatch, 0, sizeof(buslatch));
+#if defined(QBUS)
+	buslatch[INITIALIZATIONSIGNAL_LATCH] = INITIALIZATIONSIGNAL_POK | INITIALIZATIONSIGNAL_DCOK;
+#endif
+	emulate_cpu = false;
+	arb_mode_none = false;
+	device_request_mask = 0;
+	cpu_request = false;
+	address_overlay = 0;
+	dma_running = false;
+	dma_chunk_idx = 0;
+	dma_chunks_queued = 0;
+
+	thread_terminate = false;
+	int status = pthread_create(&pthread, NULL, &worker_pthread_wrapper, this);
+	if (status != 0)
+		FATAL("Failed to create virtual PRU thread with status = %d", status);
+	INFO("Virtual PRU started");
+}
+
+void pru_virtual_c::stop()
+{
+	if (thread_terminate)
+		return; // not running
+	thread_terminate = true;
+	pthread_join(pthread, NULL);
+	if (bus_owned) {
+		bus_owned = false;
+		pthread_mutex_unlock(&bus_mutex);
+	}
+	INFO("Virtual PRU stopped");
+}
+
+// prussdrv_map_prumem(): pointer to mailbox or device register RAM
+int pru_virtual_c::map_prumem(unsigned pru_ram_id, void **address)
+{
+	if (pru_ram_id == PRU_MAILBOX_RAM_ID)
+		*address = shared_dataram;
+	else if (pru_ram_id == PRU_DEVICEREGISTER_RAM_ID)
+		*address = pru0_dataram;
+	else
+		return -1;
+	return 0;
+}
+
+// see DO_EVENT_RING_POST()
+// result: false if ring full, event not posted
+bool pru_virtual_c::event_ring_post(uint8_t type, uint8_t unibus_control,
+		uint8_t register_handle, uint8_t level_index, uint32_t addr, uint16_t data)
+{
+	if (EVENT_RING_IS_FULL(*mb))
+		return false;
+	volatile mailbox_event_ring_entry_t *entry = &EVENT_RING_ENTRY(*mb, mb->event_ring.head);
+	entry->type = type;
+	entry->unibus_control = unibus_control;
+	entry->register_handle = register_handle;
+	entry->level_index = level_index;
+	entry->iopage_offset = addr & 0x1fff;
+	entry->data = data;
+	__sync_synchronize(); // entry visible before head
+	mb->event_ring.head++;
+	__sync_synchronize(); // head visible before tail is checked, see qunibusadapter
+	stat_ring_events++;
+	if (EVENT_RING_COUNT(*mb) == 1)
+		signal_arm(); // ring was empty
+	return true;
+}
+
+// posted DATO: no stall of further bus traffic
+// result: false if register not "posted" or ring full: signal as deviceregister event
+bool pru_virtual_c::event_ring_post_dato(volatile pru_iopage_register_t *reg,
+		uint8_t unibus_control, uint32_t addr, uint16_t reg_val)
+{
+	if (!(reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED))
+		return false;
+	return event_ring_post(EVENT_RING_TYPE_DEVICEREGISTER, unibus_control,
+			reg->event_register_handle, 0, addr, reg_val);
+}
+
+// PRU2ARM_INTERRUPT
+void pru_virtual_c::signal_arm()
+{
+	uint64_t no_signal = 0;
+	signal_ns.compare_exchange_strong(no_signal, timeout_c::abstime_ns());
+	__sync_synchronize(); // event data visible before event
+	pthread_mutex_lock(&event_mutex);
+	event_count++;
+	pthread_cond_signal(&event_cond);
+	pthread_mutex_unlock(&event_mutex);
+	stat_events++;
+}
+
+// prussdrv_pru_wait_event_timeout():
+// result: 0 = timeout, else number of interrupts since last call.
+// Event is cleared here, no separate prussdrv_pru_clear_event() needed.
+int pru_virtual_c::wait_event(unsigned timeout_us)
+{
+	struct timespec abstime;
+	int res;
+
+	clock_gettime(CLOCK_REALTIME, &abstime);
+	abstime.tv_nsec += (long) (timeout_us % 1000000) * 1000;
+	abstime.tv_sec += timeout_us / 1000000 + abstime.tv_nsec / 1000000000;
+	abstime.tv_nsec %= 1000000000;
+
+	pthread_mutex_lock(&event_mutex);
+	while (event_count == event_count_seen) {
+		if (pthread_cond_timedwait(&event_cond, &event_mutex, &abstime) == ETIMEDOUT)
+			break;
+	}
+	res = event_count - event_count_seen;
+	event_count_seen = event_count;
+	pthread_mutex_unlock(&event_mutex);
+	return res;
+}
+
+void *pru_virtual_c::worker_pthread_wrapper(void *context)
+{
+	pru_virtual_c *vpru = (pru_virtual_c *) context;
+	vpru->worker();
+	return NULL;
+}
+
+// PRU1 main loop
+void pru_virtual_c::worker()
+{
+	while (!thread_terminate) {
+		bool busy = false;
+
+		do_event_initializationsignals();
+
+		// Bus halted while ARM processes a device register or emulated CPU INTR event.
+		// ARM may issue opcodes in the meantime, see below.
+		if (EVENT_IS_ACKED(*mb, deviceregister) && EVENT_IS_ACKED(*mb, intr_slave)) {
+			if (dma_running) {
+				dma_step();
+				busy = true;
+			} else
+				busy = arbitrate();
+		}
+
+		uint32_t req = mb->arm2pru_req;
+		if (req != ARM2PRU_NONE) {
+			arm2pru_request(req);
+			busy = true;
+		}
+		if (!busy)
+			sched_yield(); // idle: polling like PRU, but let others run
+	}
+}
+
+uint8_t pru_virtual_c::initializationsignals_get()
+{
+	return buslatch[INITIALIZATIONSIGNAL_LATCH] & INITIALIZATIONSIGNAL_ANY;
+}
+
+// signal INIT or power changes to ARM, see pru1_utils.c
+void pru_virtual_c::do_event_initializationsignals()
+{
+	uint8_t bussignals_cur = initializationsignals_get();
+
+	if (bussignals_cur & INITIALIZATIONSIGNAL_INIT) {
+		device_request_mask = 0; // INIT clears all PRIORITY request signals
+		dma_cancel_queue();
+	}
+
+	uint8_t powersignals_prev = mb->events.power_signals_cur; // as ARM knows
+	if ((powersignals_prev ^ bussignals_cur) & INITIALIZATIONSIGNAL_POWER) {
+		mb->events.power_signals_prev = powersignals_prev;
+		mb->events.power_signals_cur = bussignals_cur & INITIALIZATIONSIGNAL_POWER;
+		EVENT_SIGNAL(*mb, power);
+		signal_arm();
+	}
+
+#if defined(UNIBUS)
+	uint8_t initsignal_prev = mb->events.init_signal_cur; // as ARM knows
+	if ((initsignal_prev ^ bussignals_cur) & INITIALIZATIONSIGNAL_INIT) {
+		if (!initsignal_prev)
+			iopageregisters_reset_values(); // INIT raised
+		mb->events.init_signal_cur = bussignals_cur & INITIALIZATIONSIGNAL_INIT;
+		EVENT_SIGNAL(*mb, init);
+		signal_arm();
+	}
+#elif defined(QBUS)
+	// QBUS: only raising edge of INIT is signaled.
+	// init_signal_cur is reset after ACK and trailing edge
+	if (!mb->events.init_signal_cur) {
+		if (bussignals_cur & INITIALIZATIONSIGNAL_INIT) {
+			mb->events.init_signal_cur = 1;
+			iopageregisters_reset_values();
+			EVENT_SIGNAL(*mb, init);
+			signal_arm();
+		}
+	} else if (EVENT_IS_ACKED(*mb, init) && !(bussignals_cur & INITIALIZATIONSIGNAL_INIT))
+		mb->events.init_signal_cur = 0;
+#endif
+}
+
+void pru_virtual_c::iopageregisters_reset_values()
+{
+	for (unsigned i = 0; i < MAX_IOPAGE_REGISTER_COUNT; i++)
+		regs->registers[i].value = regs->registers[i].reset_value;
+}
+
+// execute ARM2PRU opcode, must never block.
+void pru_virtual_c::arm2pru_request(uint32_t request)
+{
+	switch (request) {
+	case ARM2PRU_NOP:
+	case ARM2PRU_HALT: // a thread is not halted
+		break;
+	case ARM2PRU_MAILBOXTEST1:
+		mb->mailbox_test.val = mb->mailbox_test.addr;
+		break;
+	case ARM2PRU_BUSLATCH_INIT:
+		memset(buslatch, 0, sizeof(buslatch));
+#if defined(QBUS)
+		buslatch[INITIALIZATIONSIGNAL_LATCH] = INITIALIZATIONSIGNAL_POK | INITIALIZATIONSIGNAL_DCOK;
+#endif
+		break;
+	case ARM2PRU_BUSLATCH_SET: {
+		uint8_t reg_sel = mb->buslatch.addr & 7;
+		uint8_t bitmask = mb->buslatch.bitmask;
+		buslatch[reg_sel] = (buslatch[reg_sel] & ~bitmask) | (mb->buslatch.val & bitmask);
+		mb->buslatch.val = buslatch[reg_sel];
+		break;
+	}
+	case ARM2PRU_BUSLATCH_GET:
+		mb->buslatch.val = buslatch[mb->buslatch.addr & 7];
+		break;
+	case ARM2PRU_BUSLATCH_EXERCISER: {
+		unsigned i;
+		for (i = 0; i < 8; i++)
+			buslatch[mb->buslatch_exerciser.addr[i] & 7] = mb->buslatch_exerciser.writeval[i];
+		for (i = 0; i < 8; i++)
+			mb->buslatch_exerciser.readval[i] = buslatch[mb->buslatch_exerciser.addr[i] & 7];
+		break;
+	}
+	case ARM2PRU_BUSLATCH_TEST:
+		// PRU loops until ARM changes the opcode: no ACK
+		return;
+	case ARM2PRU_INITALIZATIONSIGNAL_SET: {
+		uint8_t mask = mb->initializationsignal.id & INITIALIZATIONSIGNAL_ANY;
+		if (mb->initializationsignal.val)
+			buslatch[INITIALIZATIONSIGNAL_LATCH] |= mask;
+		else
+			buslatch[INITIALIZATIONSIGNAL_LATCH] &= ~mask;
+		break;
+	}
+	case ARM2PRU_ADDRESS_OVERLAY:
+		address_overlay = mb->address_overlay;
+		break;
+	case ARM2PRU_ARB_MODE_NONE:
+		arb_mode_none = true;
+		break;
+	case ARM2PRU_ARB_MODE_CLIENT:
+		arb_mode_none = false;
+		break;
+	case ARM2PRU_DMA:
+		dma_queue_chunk();
+		break;
+	case ARM2PRU_INTR:
+		device_request_mask |= mb->intr.priority_arbitration_bit;
+		// interrupt register changed atomically with BR line
+		if (mb->intr.iopage_register_handle)
+			regs->registers[mb->intr.iopage_register_handle].value = mb->intr.iopage_register_value;
+		break;
+	case ARM2PRU_INTR_CANCEL:
+		device_request_mask &= ~mb->intr.priority_arbitration_bit;
+		break;
+	case ARM2PRU_CPU_ENABLE:
+		if (emulate_cpu != (bool) mb->param) {
+			emulate_cpu = mb->param;
+			device_request_mask = 0; // sm_arb_reset()
+			cpu_request = false;
+		}
+		break;
+	case ARM2PRU_ARB_GRANT_INTR_REQUESTS:
+		if (emulate_cpu)
+			mb->arbitrator.ifs_intr_arbitration_pending = true;
+		break;
+	case ARM2PRU_DDR_FILL_PATTERN:
+		for (unsigned n = 0; n < QUNIBUS_MAX_WORDCOUNT; n++)
+			ddr->memory.words[n] = n;
+		break;
+	case ARM2PRU_DDR_SLAVE_MEMORY:
+		// no physical bus masters, nothing to serve.
+		// PRU runs until ARM changes the opcode: no ACK
+		return;
+	default:
+		WARNING("Unknown ARM2PRU request %u", request);
+	}
+	stat_opcodes++;
+	__sync_synchronize();
+	mb->arm2pru_req = ARM2PRU_NONE; // ACK: done
+}
+
+// Ideal arbitrator: grant NPR, then highest BR, then emulated CPU
+// see sm_arb_worker_cpu() and sm_arb_worker_device()
+// result: true, if a DMA or INTR was started
+bool pru_virtual_c::arbitrate()
+{
+	uint8_t intr_request_mask = device_request_mask & PRIORITY_ARBITRATION_INTR_MASK;
+	bool intr_arbitration;
+
+	if (!device_request_mask && !cpu_request) {
+		// CPU waits for end of arbitration also if nothing is requested
+		mb->arbitrator.ifs_intr_arbitration_pending = false;
+		return false;
+	}
+
+	// external master does a DATI/DATO?
+	if (pthread_mutex_trylock(&bus_mutex) != 0)
+		return false;
+
+	if (emulate_cpu) {
+		// emulated CPU GRANTs BR* only before opcode fetch
+		intr_arbitration = mb->arbitrator.ifs_intr_arbitration_pending;
+		mb->arbitrator.ifs_intr_arbitration_pending = false;
+	} else
+		intr_arbitration = !arb_mode_none; // ARB_MODE_NONE ignores BR*
+
+	if (device_request_mask & PRIORITY_ARBITRATION_BIT_NP) {
+		device_request_mask &= ~PRIORITY_ARBITRATION_BIT_NP;
+		dma_start();
+		return true; // bus_mutex held until DMA complete
+	}
+	if (intr_request_mask && intr_arbitration) {
+		// find highest level requested: BR4 = bit 0 ... BR7 = bit 3
+		uint8_t level_index = 31 - __builtin_clz(intr_request_mask);
+		uint8_t priority_level = mb->arbitrator.ifs_priority_level;
+		// INTR completion needs room in the event ring
+		if (!EVENT_RING_IS_FULL(*mb) && (!emulate_cpu
+				|| (priority_level != CPU_PRIORITY_LEVEL_FETCHING
+						&& level_index + 4 > priority_level))) {
+			device_request_mask &= ~(1 << level_index);
+			intr_transfer(level_index);
+			pthread_mutex_unlock(&bus_mutex);
+			return true;
+		}
+		// CPU must execute code to reach next arbitration point.
+	}
+	if (cpu_request && !(intr_request_mask && intr_arbitration)) {
+		cpu_request = false;
+		dma_start();
+		return true;
+	}
+	pthread_mutex_unlock(&bus_mutex);
+	return false;
+}
+
+// request bus for a queued chunk
+void pru_virtual_c::dma_request(volatile mailbox_dma_chunk_t *chunk)
+{
+	if (chunk->cpu_access)
+		cpu_request = true;
+	else
+		device_request_mask |= PRIORITY_ARBITRATION_BIT_NP;
+}
+
+// ARM2PRU_DMA: ARM filled the next free chunk. see sm_dma_queue_chunk()
+void pru_virtual_c::dma_queue_chunk()
+{
+	uint8_t idx = (dma_chunk_idx + dma_chunks_queued) & 1;
+	if (dma_chunks_queued++ == 0)
+		dma_request(&mb->dma.chunk[idx]);
+}
+
+// INIT cleared the NPR request: report queued device chunks. see sm_dma_cancel_queue()
+void pru_virtual_c::dma_cancel_queue()
+{
+	if (!dma_chunks_queued || dma_running || mb->dma.chunk[dma_chunk_idx].cpu_access)
+		return;
+	while (dma_chunks_queued) {
+		mb->dma.chunk[dma_chunk_idx].cur_status = DMA_STATE_INITSTOP;
+		__sync_synchronize();
+		EVENT_SIGNAL(*mb, dma);
+		dma_chunk_idx ^= 1;
+		dma_chunks_queued--;
+	}
+	signal_arm();
+}
+
+// bus mastership granted, bus_mutex locked
+void pru_virtual_c::dma_start()
+{
+	bus_owned = true;
+	dma_chunk = &mb->dma.chunk[dma_chunk_idx];
+	dma_chunk->cur_addr = dma_chunk->startaddr;
+	dma_dataptr = (uint16_t *) dma_chunk->words;
+	dma_wordsleft = dma_chunk->wordcount;
+	dma_chunk->cur_status = DMA_STATE_RUNNING;
+	dma_running = true;
+	stat_dma_chunks++;
+}
+
+// transfer words, until complete or a device register event must be processed by ARM
+void pru_virtual_c::dma_step()
+{
+	uint8_t buscycle = dma_chunk->buscycle;
+	uint8_t final_dma_state = DMA_STATE_RUNNING;
+
+	while (final_dma_state == DMA_STATE_RUNNING) {
+		uint32_t addr;
+		bool responded;
+
+		if (dma_wordsleft == 0) {
+			final_dma_state = DMA_STATE_READY;
+			break;
+		}
+		if (!EVENT_IS_ACKED(*mb, deviceregister))
+			return; // continue after ARM processed the register access
+
+		addr = dma_chunk->cur_addr | address_overlay;
+		if (QUNIBUS_CYCLE_IS_DATO(buscycle)) {
+			uint16_t data = *dma_dataptr;
+			if (buscycle == QUNIBUS_CYCLE_DATOB)
+				responded = addr_write_b(addr, (addr & 1) ? (data >> 8) : (data & 0xff));
+			else
+				responded = addr_write_w(addr, data);
+		} else
+			responded = addr_read(addr, dma_dataptr);
+
+		if (!responded)
+			final_dma_state = DMA_STATE_TIMEOUTSTOP;
+		else {
+			stat_dma_words++;
+			dma_dataptr++;
+			dma_wordsleft--;
+			if (dma_wordsleft == 0)
+				final_dma_state = DMA_STATE_READY;
+			else if (initializationsignals_get() & INITIALIZATIONSIGNAL_INIT)
+				final_dma_state = DMA_STATE_INITSTOP;
+			else
+				dma_chunk->cur_addr += 2; // signal progress to ARM
+		}
+	}
+
+	dma_running = false;
+	bus_owned = false;
+	pthread_mutex_unlock(&bus_mutex);
+
+	dma_chunk->cur_status = final_dma_state; // signal to ARM
+	bool cpu_access = dma_chunk->cpu_access; // ARM may refill chunk after event
+	__sync_synchronize();
+	EVENT_SIGNAL(*mb, dma);
+
+	// next queued chunk: request bus again, without ARM
+	dma_chunk_idx ^= 1;
+	if (--dma_chunks_queued) {
+		if (final_dma_state == DMA_STATE_READY) {
+			dma_request(&mb->dma.chunk[dma_chunk_idx]);
+			stat_dma_chunks_staged++;
+		} else {
+			mb->dma.chunk[dma_chunk_idx].cur_status = DMA_STATE_CANCELED;
+			__sync_synchronize();
+			EVENT_SIGNAL(*mb, dma);
+			dma_chunk_idx ^= 1;
+			dma_chunks_queued = 0;
+		}
+	}
+	// emulated CPU polls for completion
+	if (!cpu_access)
+		signal_arm();
+}
+
+// transfer vector of granted level to interrupt fielding processor
+void pru_virtual_c::intr_transfer(uint8_t level_index)
+{
+	if (emulate_cpu) {
+		// see sm_intr_slave: block GRANTs until CPU fetched new PSW
+		mb->arbitrator.ifs_priority_level = CPU_PRIORITY_LEVEL_FETCHING;
+		mb->events.intr_slave.vector = mb->intr.vector[level_index];
+		__sync_synchronize();
+		EVENT_SIGNAL(*mb, intr_slave);
+	}
+	stat_intrs++;
+	event_ring_post(EVENT_RING_TYPE_INTR_MASTER, 0, 0, level_index, 0, 0);
+}
+
+// access to emulated memory and device registers, see pru1_iopageregisters.c
+// result: false = address not implemented, bus timeout
+bool pru_virtual_c::addr_read(uint32_t addr, uint16_t *val)
+{
+	if (addr < regs->memory_limit_addr && addr >= regs->memory_start_addr) {
+		*val = ddr->memory.words[addr / 2];
+		return true;
+	} else if (addr >= regs->iopage_start_addr) {
+		uint8_t reghandle = IOPAGE_REGISTER_ENTRY(*regs, addr);
+		if (reghandle == 0)
+			return false;
+		else if (reghandle == IOPAGE_REGISTER_HANDLE_ROM) {
+			*val = ddr->memory.words[addr / 2];
+			return true;
+		} else {
+			volatile pru_iopage_register_t *reg = &(regs->registers[reghandle]);
+			*val = reg->value;
+			if (reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATI) {
+				mb->events.deviceregister.unibus_control = QUNIBUS_CYCLE_DATI;
+				mb->events.deviceregister.register_handle = reg->event_register_handle;
+				mb->events.deviceregister.addr = addr;
+				mb->events.deviceregister.data = *val;
+				__sync_synchronize();
+				EVENT_SIGNAL(*mb, deviceregister);
+				signal_arm();
+			}
+			return true;
+		}
+	} else
+		return false;
+}
+
+bool pru_virtual_c::addr_write_w(uint32_t addr, uint16_t w)
+{
+	if (addr < regs->memory_limit_addr && addr >= regs->memory_start_addr) {
+		ddr->memory.words[addr / 2] = w;
+		return true;
+	} else if (addr >= regs->iopage_start_addr) {
+		uint8_t reghandle = IOPAGE_REGISTER_ENTRY(*regs, addr);
+		if (reghandle == 0 || reghandle == IOPAGE_REGISTER_HANDLE_ROM)
+			return false; // not implemented, ROM does not respond to DATO
+		volatile pru_iopage_register_t *reg = &(regs->registers[reghandle]);
+		uint16_t reg_val = (reg->value & ~reg->writable_bits) | (w & reg->writable_bits);
+		reg->value = reg_val;
+		if ((reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO)
+				&& !event_ring_post_dato(reg, QUNIBUS_CYCLE_DATO, addr, reg_val)) {
+			mb->events.deviceregister.unibus_control = QUNIBUS_CYCLE_DATO;
+			mb->events.deviceregister.register_handle = reg->event_register_handle;
+			mb->events.deviceregister.addr = addr;
+			mb->events.deviceregister.data = reg_val;
+			__sync_synchronize();
+			EVENT_SIGNAL(*mb, deviceregister);
+			signal_arm();
+		}
+		return true;
+	} else
+		return false;
+}
+
+bool pru_virtual_c::addr_write_b(uint32_t addr, uint8_t b)
+{
+	if (addr < regs->memory_limit_addr && addr >= regs->memory_start_addr) {
+		ddr->memory.bytes[addr] = b;
+		return true;
+	} else if (addr >= regs->iopage_start_addr) {
+		uint8_t reghandle = IOPAGE_REGISTER_ENTRY(*regs, addr);
+		if (reghandle == 0 || reghandle == IOPAGE_REGISTER_HANDLE_ROM)
+			return false;
+		volatile pru_iopage_register_t *reg = &(regs->registers[reghandle]);
+		uint16_t reg_val;
+		if (addr & 1) // odd address = write upper byte
+			reg_val = (reg->value & 0x00ff) | (reg->value & ~reg->writable_bits & 0xff00)
+					| (((uint16_t) b << 8) & reg->writable_bits);
+		else
+			reg_val = (reg->value & 0xff00) | (reg->value & ~reg->writable_bits & 0x00ff)
+					| (b & reg->writable_bits);
+		reg->value = reg_val;
+		if ((reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO)
+				&& !event_ring_post_dato(reg, QUNIBUS_CYCLE_DATOB, addr, reg_val)) {
+			mb->events.deviceregister.unibus_control = QUNIBUS_CYCLE_DATOB;
+			mb->events.deviceregister.register_handle = reg->event_register_handle;
+			mb->events.deviceregister.addr = addr;
+			mb->events.deviceregister.data = reg_val;
+			__sync_synchronize();
+			EVENT_SIGNAL(*mb, deviceregister);
+			signal_arm();
+		}
+		return true;
+	} else
+		return false;
+}
+
+// external master: "SSYN" held until ARM processed the register event
+// Not to be called by worker(), which must continue to serve opcodes.
+void pru_virtual_c::wait_deviceregister_ack()
+{
+	while (!EVENT_IS_ACKED(*mb, deviceregister))
+		sched_yield();
+}
+
+// QBUS: master asserts BS7 for the IO page, see pru1_statemachine_data_slave.c
+uint32_t pru_virtual_c::slave_addr(uint32_t addr)
+{
+#if defined(QBUS)
+	if (addr >= regs->iopage_start_addr)
+		addr |= QUNIBUS_IOPAGE_ADDR_BITMASK;
+#endif
+	return addr;
+}
+
+// DATI by an external bus master, as a physical CPU would do.
+bool pru_virtual_c::dati(uint32_t addr, uint16_t *data)
+{
+	assert(!thread_terminate);
+	addr = slave_addr(addr);
+	pthread_mutex_lock(&bus_mutex);
+	bool result = addr_read(addr & ~1, data);
+	wait_deviceregister_ack();
+	stat_slave_cycles++;
+	pthread_mutex_unlock(&bus_mutex);
+	return result;
+}
+
+bool pru_virtual_c::dato(uint32_t addr, uint16_t data)
+{
+	assert(!thread_terminate);
+	addr = slave_addr(addr);
+	pthread_mutex_lock(&bus_mutex);
+	bool result = addr_write_w(addr & ~1, data);
+	wait_deviceregister_ack();
+	stat_slave_cycles++;
+	pthread_mutex_unlock(&bus_mutex);
+	return result;
+}
+
+bool pru_virtual_c::datob(uint32_t addr, uint8_t data)
+{
+	assert(!thread_terminate);
+	addr = slave_addr(addr);
+	pthread_mutex_lock(&bus_mutex);
+	bool result = addr_write_b(addr, data);
+	wait_deviceregister_ack();
+	stat_slave_cycles++;
+	pthread_mutex_unlock(&bus_mutex);
+	return result;
+}
+
+void pru_virtual_c::print_statistics()
+{
+	printf("Virtual PRU: %llu opcodes, %llu ARM events, %llu DMA words, %llu INTRs, %llu slave cycles.\n",
+			(unsigned long long) stat_opcodes, (unsigned long long) stat_events,
+			(unsigned long long) stat_dma_words, (unsigned long long) stat_intrs,
+			(unsigned long long) stat_slave_cycles);
+	printf("Virtual PRU: %llu DMA chunks, %llu of them pre-staged by ARM.\n",
+			(unsigned long long) stat_dma_chunks, (unsigned long long) stat_dma_chunks_staged);
+	printf("Virtual PRU: %llu events posted to event ring.\n",
+			(unsigned long long) stat_ring_events);
+}
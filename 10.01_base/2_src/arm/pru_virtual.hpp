@@ -0,0 +1,154 @@
+/* pru_virtual.hpp: software replacement for PRU1 and the physical bus
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026  agent   timestamp of PRU2ARM_INTERRUPT for latency statistics
+ 16-oct-2026  agent   created
+
+ A "virtual PRU" runs the ARM application on any Linux host, without
+ BeagleBone, PRUs, GPIOs and physical QBUS/UNIBUS.
+ - mailbox_t, pru_iopage_registers_t and ddrmem_t are allocated in process memory
+ - a thread replaces the PRU1 main loop: it answers ARM2PRU_* opcodes,
+   executes DMA and INTR transactions and raises PRU->ARM events.
+ - the "bus" is an in-process model: emulated memory in ddrmem and the
+   emulated device registers. External bus masters (test drivers, benchmarks)
+   use dati()/dato()/datob() to access it like a physical CPU would.
+ Timing is not emulated, everything runs at host speed.
+ */
+
+#ifndef _PRU_VIRTUAL_HPP_
+#define _PRU_VIRTUAL_HPP_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <atomic>
+
+#include "logsource.hpp"
+#include "mailbox.h"
+#include "ddrmem.h"
+#include "iopageregister.h"
+
+// sizes of PRU memories, which hold mailbox and device register tables
+#define PRU_VIRTUAL_SHARED_DATARAM_SIZE	0x3000	// 12KB
+#define PRU_VIRTUAL_PRU0_DATARAM_SIZE	0x2000	// 8 KB
+
+class pru_virtual_c: public logsource_c {
+private:
+	// replacement for PRU RAMs and shared DDR
+	uint8_t *shared_dataram;
+	uint8_t *pru0_dataram;
+	ddrmem_t *ddr;
+
+	// aliases into RAMs
+	volatile mailbox_t *mb;
+	volatile pru_iopage_registers_t *regs;
+
+	pthread_t pthread;
+	volatile bool thread_terminate;
+
+	// PRU->ARM interrupt: counted, waited for by qunibusadapter worker
+	pthread_mutex_t event_mutex;
+	pthread_cond_t event_cond;
+	unsigned event_count; // incremented on each "PRU2ARM_INTERRUPT"
+	unsigned event_count_seen; // last value returned by wait_event()
+	std::atomic<uint64_t> signal_ns; // time of oldest signal not yet taken by ARM, 0 = none
+
+	// only one bus master at a time: virtual PRU DMA/INTR or external dati()/dato()
+	pthread_mutex_t bus_mutex;
+	bool bus_owned; // virtual PRU holds bus_mutex for DMA
+
+	// state of PRU1 "main()"
+	uint8_t buslatch[8]; // last values written into mux latches
+	bool emulate_cpu;
+	bool arb_mode_none; // ARM2PRU_ARB_MODE_NONE: ignore BR*, grant NPR immediately
+	uint8_t device_request_mask; // PRIORITY_ARBITRATION_BIT_* requested by devices
+	bool cpu_request; // emulated CPU requests memory access
+	uint32_t address_overlay;
+
+	// DMA "statemachine" and chunk queue, see sm_dma
+	bool dma_running;
+	volatile mailbox_dma_chunk_t *dma_chunk; // chunk in transfer
+	uint16_t *dma_dataptr;
+	unsigned dma_wordsleft;
+	uint8_t dma_chunk_idx; // oldest queued chunk in mailbox.dma.chunk[]
+	uint8_t dma_chunks_queued;
+
+	static void *worker_pthread_wrapper(void *context);
+	void worker(void);
+
+	void signal_arm(void);
+	bool event_ring_post(uint8_t type, uint8_t unibus_control, uint8_t register_handle,
+			uint8_t level_index, uint32_t addr, uint16_t data);
+	bool event_ring_post_dato(volatile pru_iopage_register_t *reg, uint8_t unibus_control,
+			uint32_t addr, uint16_t reg_val);
+	uint8_t initializationsignals_get(void);
+	void do_event_initializationsignals(void);
+	void iopageregisters_reset_values(void);
+	void arm2pru_request(uint32_t request);
+	bool arbitrate(void);
+	void dma_request(volatile mailbox_dma_chunk_t *chunk);
+	void dma_queue_chunk(void);
+	void dma_cancel_queue(void);
+	void dma_start(void);
+	void dma_step(void);
+	void intr_transfer(uint8_t level_index);
+
+	bool addr_read(uint32_t addr, uint16_t *val);
+	bool addr_write_w(uint32_t addr, uint16_t w);
+	bool addr_write_b(uint32_t addr, uint8_t b);
+	uint32_t slave_addr(uint32_t addr);
+	void wait_deviceregister_ack(void);
+
+public:
+	// statistics, for benchmarks
+	uint64_t stat_opcodes; // ARM2PRU requests served
+	uint64_t stat_events; // PRU->ARM interrupts raised
+	uint64_t stat_dma_words; // words transferred by DMA
+	uint64_t stat_dma_chunks; // DMA chunks started
+	uint64_t stat_dma_chunks_staged; // chunks started directly after predecessor
+	uint64_t stat_intrs; // INTR vectors transferred
+	uint64_t stat_ring_events; // events posted to mailbox event ring
+	uint64_t stat_slave_cycles; // DATI/DATO by external bus masters
+
+	pru_virtual_c();
+	~pru_virtual_c();
+
+	void start(void);
+	void stop(void);
+
+	// replacements for prussdrv functions
+	int map_prumem(unsigned pru_ram_id, void **address);
+	int wait_event(unsigned timeout_us);
+	// time of oldest PRU2ARM_INTERRUPT since last call, 0 = none
+	uint64_t take_signal_timestamp(void) {
+		return signal_ns.exchange(0);
+	}
+
+	// bus cycles of an external bus master
+	// result: false = bus timeout
+	bool dati(uint32_t addr, uint16_t *data);
+	bool dato(uint32_t addr, uint16_t data);
+	bool datob(uint32_t addr, uint8_t data);
+
+	void print_statistics(void);
+};
+
+#endif
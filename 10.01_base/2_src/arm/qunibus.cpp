@@ -20,6 +20,7 @@
  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+ 16-oct-2026  agent   DMA error address from dma_request, mailbox has chunk queue
  jul-2019     JH      rewrite: multiple parallel arbitration levels
  12-nov-2018  JH      entered beta phase
  */
@@ -482,9 +483,9 @@ bool qunibus_c::get_arbitrator_active(void)
 }
 
 // do a DMA transaction with or without arbitration (arbitration_client)
-// mailbox.dma.words already filled
+// buffer filled for DATO
 // if result = timeout: =
-// 0 = bus time, error address =  mailbox->dma.cur_addr
+// 0 = bus time, error address =  dma_request->qunibus_end_addr
 // 1 = all transfered
 // A limit for time used by DMA can be compiled-in
 bool qunibus_c::dma(bool blocking, uint8_t qunibus_cycle, uint32_t startaddr, uint16_t *buffer,
@@ -545,7 +546,7 @@ void qunibus_c::mem_write(uint16_t *words, unsigned unibus_start_addr, unsigned
     assert(pru->prucode_id == pru_c::PRUCODE_EMULATION);
     *result_timeout = !dma(true, QUNIBUS_CYCLE_DATO, unibus_start_addr, buffer_start_addr, wordcount);
     if (*result_timeout) {
-        printf("\nWrite result_timeout @ %s\n", qunibus->addr2text(mailbox->dma.cur_addr));
+        printf("\nWrite result_timeout @ %s\n", qunibus->addr2text(dma_request->qunibus_end_addr));
         return;
     }
 }
@@ -563,7 +564,7 @@ void qunibus_c::mem_read(uint16_t *words, uint32_t unibus_start_addr, uint32_t u
 
     *result_timeout = !dma(true, QUNIBUS_CYCLE_DATI, unibus_start_addr, buffer_start_addr, wordcount);
     if (*result_timeout) {
-        printf("\nRead result_timeout @ %s\n", qunibus->addr2text(mailbox->dma.cur_addr));
+        printf("\nRead result_timeout @ %s\n", qunibus->addr2text(dma_request->qunibus_end_addr));
         return;
     }
 }
@@ -599,7 +600,7 @@ void qunibus_c::mem_access_random(uint8_t unibus_control, uint16_t *words,
                                block_wordcount);
         if (*result_timeout) {
             printf("\n%s result_timeout @ %s\n", control2text(unibus_control),
-                   qunibus->addr2text(mailbox->dma.cur_addr));
+                   qunibus->addr2text(dma_request->qunibus_end_addr));
             return;
         }
         block_unibus_start_addr = block_unibus_end_addr + 2;
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026	agent   trigger_c::is_active()
  13-feb-2021	JH      created
 
 
@@ -118,6 +119,11 @@ public:
         level = 0 ;
     }
 
+    // conditions defined, probe() must be called
+    bool is_active(void) {
+        return size() > 0 ;
+    }
+
     // check wether all conditions met.
     bool has_triggered(void) {
         return (size() > 0 && level >= size()) ;
@@ -21,6 +21,13 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ oct-2026	agent		register events via compact dispatch table, no logging below DEBUG. Trace/replay.
+ oct-2026	agent		busy-poll worker mode, CPU affinity, event latency histogram
+ oct-2026	agent		PRU event ring: posted DATOs and INTR completions drained in batches
+ oct-2026	agent		non-blocking DMA() completes via dma_request_c::wait()
+ oct-2026	agent		scatter-gather DMA, PRU DMA chunk queue with pre-staged 2nd chunk
+ oct-2026	agent		request tables lock-free, "busy" token per level instead of requests_mutex
+ oct-2026	agent		PRU event wait via pru_c, for virtual PRU
  aug-2020	JH		adapted to QBUS
  jul-2019     JH      rewrite: multiple parallel arbitration levels
  12-nov-2018  JH      entered beta phase
@@ -51,6 +58,8 @@
 #include <ios>
 #include <string.h>
 #include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
 #include <assert.h>
 #include <queue>
 
@@ -62,12 +71,13 @@
 #include "logger.hpp"
 #include "mailbox.h"
 #include "gpios.hpp"
-#include "prussdrv.h"
-#include "pruss_intc_mapping.h"
+#include "pru.hpp"
+#include "pru_virtual.hpp"
 #include "iopageregister.h"
 #include "priorityrequest.hpp"
 #include "qunibusadapter.hpp"
 #include "unibuscpu.hpp"
+#include "timeout.hpp"
 
 qunibusadapter_c *qunibusadapter; // another Singleton
 // is registered in device_c.list<devices> ... order of static constructor calls ???
@@ -99,18 +109,33 @@ qunibusadapter_c::qunibusadapter_c() :     device_c()
     line_DCLO = false;
     line_ACLO = false;
 
-    requests_mutex = PTHREAD_MUTEX_INITIALIZER;
+    busy_poll.value = false;
+    poll_idle.value = 1000; // 1 ms
+    cpumask.value = 0;
 
     requests_init();
+    clear_request_statistics();
 
     registered_cpu = NULL;
 
-	memset(register_by_handle, 0, sizeof(register_by_handle)) ;
+	memset(register_dispatch, 0, sizeof(register_dispatch)) ;
+	register_event_trace_capacity = 0;
+	register_event_trace_count = 0;
+	register_event_trace_cmd = trace_cmd_none;
 }
 
 bool qunibusadapter_c::on_param_changed(parameter_c *param) 
 {
-    // no own parameter or "enable" logic
+    // no "enable" logic. worker() applies params itself
+    if (param == &busy_poll && busy_poll.new_value && sysconf(_SC_NPROCESSORS_ONLN) < 2)
+        WARNING("busy_poll on single CPU core: worker competes with device threads");
+    if (param == &cpumask) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        if (cores < 32 && (cpumask.new_value >> cores)) {
+            ERROR("cpumask 0x%x: only %ld CPU cores", cpumask.new_value, cores);
+            return false;
+        }
+    }
     return device_c::on_param_changed(param); // more actions (for enable)
 }
 
@@ -125,8 +150,10 @@ void qunibusadapter_c::on_init_changed(void)
 {
     requests_init();
     // clear all pending BR and NPR lines on PRU
+    mailbox_lock();
     mailbox->intr.priority_arbitration_bit = PRIORITY_ARBITRATION_BIT_MASK;
     mailbox_execute(ARM2PRU_INTR_CANCEL);
+    mailbox_unlock();
 }
 
 
@@ -213,8 +240,13 @@ bool qunibusadapter_c::register_device(qunibusdevice_c& device)
 
         device_reg->pru_iopage_register = pru_iopage_reg; // link controller register to shared descriptor
         device_reg->register_handle = register_handle;
-		assert(register_by_handle[register_handle] == NULL) ;
-		register_by_handle[register_handle] = device_reg ; // PRU->ARM lookup table
+		register_dispatch_t *dispatch = &register_dispatch[register_handle]; // PRU->ARM lookup table
+		assert(dispatch->reg == NULL) ;
+		dispatch->device = &device;
+		dispatch->reg = device_reg;
+		dispatch->log_level_ptr = device.log_level_ptr;
+		dispatch->writable_bits = device_reg->writable_bits;
+		dispatch->event_flags = 0;
         pru_iopage_reg->value = device_reg->reset_value; // init
         pru_iopage_reg->reset_value = device_reg->reset_value;
         pru_iopage_reg->writable_bits = device_reg->writable_bits;
@@ -237,6 +269,10 @@ bool qunibusadapter_c::register_device(qunibusdevice_c& device)
                 pru_iopage_reg->event_flags |= IOPAGEREGISTER_EVENT_FLAG_DATI;
             if (device_reg->active_on_dato)
                 pru_iopage_reg->event_flags |= IOPAGEREGISTER_EVENT_FLAG_DATO;
+            if (device_reg->active_on_dato && device_reg->posted_dato)
+                pru_iopage_reg->event_flags |= IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED;
+            dispatch->event_flags = pru_iopage_reg->event_flags
+                                    & (IOPAGEREGISTER_EVENT_FLAG_DATI | IOPAGEREGISTER_EVENT_FLAG_DATO);
         }
         // write register handle into IO page address map
         uint32_t addr = device.base_addr.value + 2 * i; // devices have always sequential address register range!
@@ -284,7 +320,7 @@ void qunibusadapter_c::unregister_device(qunibusdevice_c& device)
     for (i = 0; i < device.register_count; i++) {
 	    qunibusdevice_register_t *device_reg = &(device.registers[i]);
         IOPAGE_REGISTER_ENTRY(*pru_iopage_registers,device_reg->addr) = 0;
-		register_by_handle[device_reg->register_handle] = NULL  ;
+		memset(&register_dispatch[device_reg->register_handle], 0, sizeof(register_dispatch_t)) ;
 
         // register descriptor remain unchanged, also device->members
     }
@@ -346,33 +382,84 @@ bool qunibusadapter_c::is_rom(uint32_t address)
 
 /*** Access requests in [level,slot] table ***/
 
+// get the "busy" token of a level.
+// Spin shortly: owner holds it only for a few mailbox operations.
+// Then sleep, the owner may be a preempted thread with lower priority.
+void priority_request_level_c::lock(void)
+{
+    if (try_lock())
+        return;
+    stat_lock_waits.fetch_add(1, std::memory_order_relaxed);
+    unsigned spins = 0;
+    do {
+        spins++;
+        if (spins > 100)
+            timeout_c::wait_us(1);
+    } while (!try_lock());
+    stat_lock_spins.fetch_add(spins, std::memory_order_relaxed);
+}
+
+// initialize slot table in empty state
+void priority_request_level_c::clear()
+{
+    for (unsigned slot = 0; slot <= PRIORITY_SLOT_COUNT; slot++)
+        slot_request[slot] = NULL;
+    slot_request_mask = 0;
+    active = NULL;
+}
+
+void priority_request_level_c::clear_statistics()
+{
+    stat_scheduled = 0;
+    stat_handoffs = 0;
+    stat_lock_waits = 0;
+    stat_lock_spins = 0;
+}
+
 // initialize slot tables in empty state
 void qunibusadapter_c::requests_init(void) 
 {
-    for (unsigned level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++) {
-        priority_request_level_c *prl = &request_levels[level_index];
-        for (unsigned slot = 0; slot < PRIORITY_SLOT_COUNT; slot++)
-            prl->slot_request[slot] = NULL;
-        prl->slot_request_mask = 0;
-        prl->active = NULL;
-    }
+    for (unsigned level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++)
+        request_levels[level_index].clear();
+    dma_chunk_head = 0;
+    dma_chunks_queued = 0;
+}
+
+// get "busy" tokens of all levels, for global operations like INIT.
+// always in same order
+void qunibusadapter_c::requests_lock_all(void)
+{
+    for (unsigned level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++)
+        request_levels[level_index].lock();
+}
+
+// requests scheduled while the tokens were held are started here,
+// as after every unlock().
+void qunibusadapter_c::requests_unlock_all(void)
+{
+    unsigned level_index;
+    for (level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++)
+        request_levels[level_index].unlock();
+    for (level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++)
+        request_dispatch(level_index);
 }
 
 // put a request into the level/slot table
 // do not yet activate!
+// Runs without lock, only the device owning the slot inserts.
 void qunibusadapter_c::request_schedule(priority_request_c& request) 
 {
-    // Must run under  pthread_mutex_lock(&requests_mutex);
     priority_request_level_c *prl = &request_levels[request.level_index];
     // DEBUG_FAST("request_schedule") ;
 
     // a device may reraise on of its own interrupts, but not an DMA on same slot
+    priority_request_c *slotrequest = prl->slot_request[request.priority_slot];
     if (dynamic_cast<dma_request_c *>(&request)) {
-        if (prl->slot_request[request.priority_slot] != NULL)
+        if (slotrequest != NULL)
             FATAL("Concurrent DMA requested for slot %d.", (unsigned )request.priority_slot);
     } else if (dynamic_cast<intr_request_c *>(&request)) {
-        if (prl->slot_request[request.priority_slot] != NULL) {
-            qunibusdevice_c *slotdevice = prl->slot_request[request.priority_slot]->device;
+        if (slotrequest != NULL) {
+            qunibusdevice_c *slotdevice = slotrequest->device;
             if (slotdevice != request.device)
                 FATAL(
                     "Devices %s and %s share both slot %u for INTR request with priority index %u",
@@ -385,8 +472,29 @@ void qunibusadapter_c::request_schedule(priority_request_c& request)
         }
     }
 
-    prl->slot_request[request.priority_slot] = &request; // mark slot with request
-    prl->slot_request_mask |= (1 << request.priority_slot);  // set slot bit
+    // mark slot with request. Published by seq_cst update of mask
+    prl->slot_request[request.priority_slot].store(&request, std::memory_order_release);
+    prl->slot_request_mask |= (1 << request.priority_slot);  // set slot bit, after slot
+    prl->stat_scheduled.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Start the highest priorized request of a level on the PRU, if the level is idle.
+// Never blocks: if another thread holds the level token, that thread
+// sees the request after its unlock().
+// Must be called after every unlock() of a level.
+void qunibusadapter_c::request_dispatch(unsigned level_index)
+{
+    priority_request_level_c *prl = &request_levels[level_index];
+    // re-check after unlock: requests may have been inserted while token was held
+    while (prl->slot_request_mask && !prl->active) {
+        if (!prl->try_lock()) {
+            prl->stat_handoffs.fetch_add(1, std::memory_order_relaxed);
+            return; // owner will dispatch
+        }
+        if (!prl->active && request_activate_lowest_slot(level_index))
+            request_execute_active_on_PRU(level_index);
+        prl->unlock();
+    }
 }
 
 // Cancel all pending device_DMA and IRQ requests of every level.
@@ -396,19 +504,27 @@ void qunibusadapter_c::requests_cancel_scheduled(void)
 {
     priority_request_c *req;
 
-    // Must run under pthread_mutex_lock(&requests_mutex);
+    // Must run under requests_lock_all()
+    // Devices still schedule in parallel: remove slot by slot, do not clear whole mask
     for (unsigned level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++) {
         priority_request_level_c *prl = &request_levels[level_index];
-        prl->slot_request_mask = 0; // clear alls slot from request
-        prl->active = NULL;
+        priority_request_c *keep = NULL;
+        // DMA with chunks on the PRU stays active: PRU stops or cancels them
+        // on INIT and signals each, last chunk event completes the request.
+        if (level_index == PRIORITY_LEVEL_INDEX_NPR && dma_chunks_queued)
+            keep = prl->active;
+        else
+            prl->active = NULL;
 
         for (unsigned slot = 0; slot < PRIORITY_SLOT_COUNT; slot++)
-            if ((req = prl->slot_request[slot])) {
+            if (keep && keep->priority_slot == slot)
+                continue;
+            else if ((req = prl->slot_request[slot].exchange(NULL))) {
                 dma_request_c *dmareq;
+                prl->slot_request_mask &= ~(1 << slot); // before complete: slot may be re-scheduled
                 req->executing_on_PRU = false;
                 if ((dmareq = dynamic_cast<dma_request_c *>(req)))
                     dmareq->success = false; // device gets an DMA error, but will not understand
-                prl->slot_request[slot] = NULL;
                 // signal to blocking DMA() or INTR()
                 pthread_mutex_lock(&req->complete_mutex);
                 req->complete = true;
@@ -421,7 +537,6 @@ void qunibusadapter_c::requests_cancel_scheduled(void)
 /*
  // is a request of given level active on the PRU?
  bool qunibusadapter_c::request_is_active(unsigned level_index) {
- // Must run under  pthread_mutex_lock(&requests_mutex);
  priority_request_level_c *prl = &request_levels[level_index];
  return (prl->active != NULL);
  }
@@ -436,31 +551,38 @@ priority_request_c *qunibusadapter_c::request_activate_lowest_slot(unsigned leve
      Is implemented on ARM as just 2 opcodes: rbit (bit reverse), clz (count number of leading zeros)
      VERY FAST (without sorting list)
      */
-    // Must run under  pthread_mutex_lock(&);
+    // Must run with level token: prl->lock()
     priority_request_level_c *prl = &request_levels[level_index];
     priority_request_c *rq;
 
     assert(prl->active == NULL);
     // DEBUG_FAST("request_activate_lowest_slot") ;
 
-    unsigned slot = __builtin_ffs(prl->slot_request_mask);
-    if (slot == 0)
-        rq = NULL; // no slot requesting on this level
-    else {
-        rq = prl->slot_request[slot - 1]; // slot 0 -> bit 0 -> slot=1
-        assert(rq != NULL);
+    unsigned slot;
+    rq = NULL;
+    while (!rq && (slot = __builtin_ffs(prl->slot_request_mask))) {
+        slot--; // slot 0 -> bit 0 -> ffs=1
+        rq = prl->slot_request[slot];
+        if (!rq) {
+            // Stale bit: request_schedule() in parallel to requests_cancel_scheduled()
+            // set mask bit after its slot was canceled. Remove, but restore bit
+            // if the device re-scheduled the slot meanwhile.
+            prl->slot_request_mask &= ~(1 << slot);
+            if (prl->slot_request[slot] != NULL)
+                prl->slot_request_mask |= (1 << slot);
+        }
     }
-    prl->active = rq;
+    prl->active.store(rq, std::memory_order_release);
     // if (prl->active)
     // 	DEBUG("request_activate_lowest_slot(): ->active = dma_request %p, level %u, slot %u",prl->active, prl->active->level_index, prl->active->slot);
     // else
     // 	DEBUG("request_activate_lowest_slot(): ->active = NULL");
-    assert((prl->slot_request_mask == 0) == (prl->active == NULL));
 
     return rq;
 }
 
 // is any request of higher or same level executed? Is the next request executed delayed?
+// lock-free snapshot, may be outdated on return
 bool qunibusadapter_c::request_is_blocking_active(uint8_t level_index) 
 {
     while (level_index < PRIORITY_LEVEL_COUNT) {
@@ -480,54 +602,22 @@ void qunibusadapter_c::request_execute_active_on_PRU(unsigned level_index)
 {
     priority_request_level_c *prl = &request_levels[level_index];
     assert(prl->active);
-    // Must run under  pthread_mutex_lock(&requests_mutex);
+    // Must run with level token: prl->lock()
     // DEBUG_FAST("request_execute_active_on_PRU(level_idx=%u)", level_index);
     if (level_index == PRIORITY_LEVEL_INDEX_NPR) {
 
-        dma_request_c *dmareq = dynamic_cast<dma_request_c *>(prl->active);
+        dma_request_c *dmareq = dynamic_cast<dma_request_c *>(prl->active.load());
         assert(dmareq);
 
         // We do the device_DMA transfer in chunks so we can handle arbitrary buffer sizes.
         // (the PRU mailbox has limited space available.)
-
-        // Push the chunk to the PRU.
-        unsigned wordcount_remaining = dmareq->wordcount - dmareq->wordcount_completed_chunks();
-        //dmareq->chunk_max_words = 2; // TEST
-        dmareq->chunk_words = std::min(dmareq->chunk_max_words, wordcount_remaining);
-
-        assert(dmareq->chunk_words); // if complete, the dmareq should not be active anymore
-        if (dmareq->chunk_qunibus_start_addr >= qunibus->iopage_start_addr) {
-#if defined(UNIBUS)
-            // UniBone PRU doesn't handle IOpage addresses marked with IOpage bit 22
-            mailbox->dma.startaddr = dmareq->chunk_qunibus_start_addr ;
-#elif defined(QBUS)
-            mailbox->dma.startaddr = dmareq->chunk_qunibus_start_addr | QUNIBUS_IOPAGE_ADDR_BITMASK ;
-#endif
-        } else
-            mailbox->dma.startaddr = dmareq->chunk_qunibus_start_addr ;
-        mailbox->dma.buscycle = dmareq->qunibus_control;
-        mailbox->dma.wordcount = dmareq->chunk_words;
-        mailbox->dma.cpu_access = dmareq->is_cpu_access;
-
-        // Copy outgoing data into mailbox device_DMA buffer
-        if (QUNIBUS_CYCLE_IS_DATO(dmareq->qunibus_control)) {
-            memcpy((void*) mailbox->dma.words, dmareq->chunk_buffer_start(),
-                   2 * dmareq->chunk_words);
-        }
-
-        //
-        // Start the PRU:
-        // signal still not cleared in worker() while processing this
-        // assert(mailbox->events.event_dma == 0); // previous signal must have been processed
-        _DEBUG(
-            "request_execute_active_on_PRU() DMA: dev %s, ->active = dma_request %p, start = %s, control=%u, wordcount=%u, data=%06o ...",
-            dmareq->device ? dmareq->device->name.value.c_str() : "none", dmareq,
-            qunibus->addr2text(mailbox->dma.startaddr), (unsigned) mailbox->dma.buscycle,
-            (unsigned) mailbox->dma.wordcount, (unsigned) mailbox->dma.words[0]);
-        mailbox->dma.cur_status = 0; // device DMA, not by CPU
-        mailbox_execute(ARM2PRU_DMA);
+        // Chunks of a previous request have all been processed.
+        assert(dma_chunks_queued == 0);
+        dma_chunk_queue(dmareq);
         // scheduling is fast, on complete there's a signal.
         dmareq->executing_on_PRU = true;
+        // PRU starts next chunk without waiting for worker()
+        dma_chunks_prestage(dmareq);
 
         /* if DMA is done in multiple chunks,
          then after PRU is complete, we don not call "active_complete() to remove the request.
@@ -541,10 +631,12 @@ void qunibusadapter_c::request_execute_active_on_PRU(unsigned level_index)
 
     } else {
         // Not DMA? must be INTR
-        intr_request_c *intrreq = dynamic_cast<intr_request_c *>(prl->active);
+        intr_request_c *intrreq = dynamic_cast<intr_request_c *>(prl->active.load());
         assert(intrreq);
 
         // Handle interrupt request to PRU. Setup mailbox:
+        // mailbox->intr is shared by all BR levels, which run in parallel
+        mailbox_lock();
         mailbox->intr.level_index = intrreq->level_index;
         mailbox->intr.vector[intrreq->level_index] = intrreq->vector;
         if (intrreq->interrupt_register)
@@ -563,6 +655,7 @@ void qunibusadapter_c::request_execute_active_on_PRU(unsigned level_index)
         // PRU have got arbitration for an INTR of different level in the mean time:
         // assert(mailbox->events.event_intr == 0) would trigger
         mailbox_execute(ARM2PRU_INTR);
+        mailbox_unlock();
         intrreq->executing_on_PRU = true; // waiting for GRANT
         
         // PRU now changes state
@@ -576,32 +669,110 @@ void qunibusadapter_c::request_execute_active_on_PRU(unsigned level_index)
      */
 }
 
+// helper: push next chunk of the active DMA request into the PRU chunk queue.
+// Advances to next scatter-gather segment, if current is completely queued.
+void qunibusadapter_c::dma_chunk_queue(dma_request_c *dmareq)
+{
+    // Must run with NPR level token: prl->lock()
+    assert(dma_chunks_queued < PRU_DMA_CHUNK_COUNT);
+    if (dmareq->wordcount_queued_chunks() == dmareq->wordcount) {
+        // segment queued, start next
+        const dma_segment_t *seg = &dmareq->segments[++dmareq->segment_index];
+        assert(dmareq->segment_index < dmareq->segment_count);
+        dmareq->qunibus_start_addr = dmareq->chunk_qunibus_start_addr = seg->qunibus_addr;
+        dmareq->buffer = seg->buffer;
+        dmareq->wordcount = seg->wordcount;
+    }
+    unsigned idx = (dma_chunk_head + dma_chunks_queued) % PRU_DMA_CHUNK_COUNT;
+    volatile mailbox_dma_chunk_t *chunk = &mailbox->dma.chunk[idx];
+
+    unsigned wordcount_remaining = dmareq->wordcount - dmareq->wordcount_queued_chunks();
+    //dmareq->chunk_max_words = 2; // TEST
+    dmareq->chunk_words = std::min(dmareq->chunk_max_words, wordcount_remaining);
+
+    assert(dmareq->chunk_words); // if complete, the dmareq should not be active anymore
+    if (dmareq->chunk_qunibus_start_addr >= qunibus->iopage_start_addr) {
+#if defined(UNIBUS)
+        // UniBone PRU doesn't handle IOpage addresses marked with IOpage bit 22
+        chunk->startaddr = dmareq->chunk_qunibus_start_addr ;
+#elif defined(QBUS)
+        chunk->startaddr = dmareq->chunk_qunibus_start_addr | QUNIBUS_IOPAGE_ADDR_BITMASK ;
+#endif
+    } else
+        chunk->startaddr = dmareq->chunk_qunibus_start_addr ;
+    chunk->buscycle = dmareq->qunibus_control;
+    chunk->wordcount = dmareq->chunk_words;
+    chunk->cpu_access = dmareq->is_cpu_access;
+
+    // Copy outgoing data into mailbox device_DMA buffer
+    if (QUNIBUS_CYCLE_IS_DATO(dmareq->qunibus_control)) {
+        memcpy((void*) chunk->words, dmareq->chunk_buffer_start(),
+               2 * dmareq->chunk_words);
+    }
+    dma_chunk_buffer[idx] = dmareq->chunk_buffer_start(); // DATI destination
+
+    //
+    // Start the PRU:
+    _DEBUG(
+        "dma_chunk_queue(): dev %s, dma_request %p, chunk %u, start = %s, control=%u, wordcount=%u, data=%06o ...",
+        dmareq->device ? dmareq->device->name.value.c_str() : "none", dmareq, idx,
+        qunibus->addr2text(chunk->startaddr), (unsigned) chunk->buscycle,
+        (unsigned) chunk->wordcount, (unsigned) chunk->words[0]);
+    chunk->cur_status = DMA_STATE_ARBITRATING;
+    if (!dmareq->is_cpu_access) {
+        stat_dma_chunks++;
+        if (dma_chunks_queued)
+            stat_dma_chunks_staged++;
+    }
+    dma_chunks_queued++;
+    mailbox_execute(ARM2PRU_DMA);
+
+    dmareq->chunk_qunibus_start_addr += 2 * dmareq->chunk_words;
+}
+
+// Queue further chunks of the active DMA request, while PRU transfers the current one.
+// Not if a device on a higher priority slot waits for NPR: it gets the bus
+// after the chunk on the PRU, as without pre-staging.
+void qunibusadapter_c::dma_chunks_prestage(dma_request_c *dmareq)
+{
+    // Must run with NPR level token: prl->lock()
+    priority_request_level_c *prl = &request_levels[PRIORITY_LEVEL_INDEX_NPR];
+    while (dma_chunks_queued < PRU_DMA_CHUNK_COUNT && !dmareq->is_cpu_access
+            && !dmareq->chunk_failed && dmareq->chunks_remaining()) {
+        // lowest mask bit is the highest priority slot. own bit is still set.
+        uint32_t higher_slots = prl->slot_request_mask & ((1u << dmareq->priority_slot) - 1);
+        if (higher_slots)
+            break;
+        dma_chunk_queue(dmareq);
+    }
+}
+
 // remove request pointer currently handled by PRU from tables
 // also called on INTR_CANCEL
 void qunibusadapter_c::request_active_complete(unsigned level_index, bool signal_complete) 
 {
-    // Must run under  pthread_mutex_lock(&requests_mutex);
+    // Must run with level token: prl->lock()
 
     priority_request_level_c *prl = &request_levels[level_index];
-    if (!prl->active) // PRU completed after INIT cleared the tables
+    priority_request_c *tmprq = prl->active;
+    if (!tmprq) // PRU completed after INIT cleared the tables
         return;
     // DEBUG_FAST("request_active_complete") ;
 
-    unsigned slot = prl->active->priority_slot;
+    unsigned slot = tmprq->priority_slot;
     //if (prl->slot_request[slot] != prl->active)
     //	mailbox_execute(ARM2PRU_HALT) ; // LA: trigger on timeout REG_WRITE
     // active not in table, if table cleared by  INIT	requests_cancel_scheduled()
-    assert(prl->slot_request[slot] == prl->active); // must still be in table
+    assert(prl->slot_request[slot] == tmprq); // must still be in table
 
     // mark as complete
-    prl->active->executing_on_PRU = false;
-//	prl->active->complete = true;
+    tmprq->executing_on_PRU = false;
+//	tmprq->complete = true;
     // remove table entries
-    prl->slot_request[slot] = NULL; // clear slot from request
-    prl->slot_request_mask &= ~(1 << slot); // mask out slot bit
+    prl->slot_request_mask &= ~(1 << slot); // mask out slot bit, before slot
+    prl->slot_request[slot].store(NULL, std::memory_order_release); // clear slot from request
 
-    priority_request_c *tmprq = prl->active;
-    prl->active = NULL;
+    prl->active.store(NULL, std::memory_order_release); // ordered by unlock()
 
     if (signal_complete) {
         // signal to DMA() or INTR()
@@ -619,31 +790,70 @@ void qunibusadapter_c::request_active_complete(unsigned level_index, bool signal
 // result: false on QBUS/UNIBUS timeout
 // Blocking == true: DMA() wait for request to complete
 // Blocking == false: return immediately, the device logic should
-//		 evaluate the request.complete flag or wait for the mutex
+//		 evaluate dma_request.is_complete() or call dma_request.wait().
+//		 Buffer must be valid until then.
 
 void qunibusadapter_c::DMA(dma_request_c& dma_request, bool blocking, uint8_t qunibus_cycle,
                            uint32_t unibus_addr, uint16_t *buffer, uint32_t wordcount) 
 {
-    assert(dma_request.priority_slot < PRIORITY_SLOT_COUNT);
-    assert(dma_request.level_index == PRIORITY_LEVEL_INDEX_NPR);
-
     // setup device request
     assert(wordcount > 0);
     assert((unibus_addr + 2*wordcount) <= qunibus->addr_space_byte_count);
+
+    dma_request.segments = NULL;
+    dma_request.segment_count = 1;
+    dma_request.segment_index = 0;
+    dma_request.qunibus_control = qunibus_cycle;
+    dma_request.qunibus_start_addr = unibus_addr;
+    dma_request.buffer = buffer;
+    dma_request.wordcount = wordcount;
+    DMA_execute(dma_request, blocking);
+}
+
+// Scatter-gather DMA: transfer a list of blocks with one request.
+// Chunks of all segments are queued to the PRU back-to-back, the request
+// completes once after the last segment, or on first error.
+// unibus_end_addr = last accessed address in segment of error.
+// segments[] and all buffers must be valid until request is complete.
+void qunibusadapter_c::DMA(dma_request_c& dma_request, bool blocking, uint8_t qunibus_cycle,
+                           const dma_segment_t *segments, unsigned segment_count)
+{
+    assert(segment_count > 0);
+    assert(!dma_request.is_cpu_access); // CPU accesses only single words
+    for (unsigned i = 0; i < segment_count; i++) {
+        assert(segments[i].wordcount > 0);
+        assert((segments[i].qunibus_addr + 2*segments[i].wordcount) <= qunibus->addr_space_byte_count);
+    }
+
+    dma_request.segments = segments;
+    dma_request.segment_count = segment_count;
+    dma_request.segment_index = 0;
+    dma_request.qunibus_control = qunibus_cycle;
+    dma_request.qunibus_start_addr = segments[0].qunibus_addr;
+    dma_request.buffer = segments[0].buffer;
+    dma_request.wordcount = segments[0].wordcount;
+    DMA_execute(dma_request, blocking);
+}
+
+// schedule a DMA request, setup by DMA(), and wait for completion
+void qunibusadapter_c::DMA_execute(dma_request_c& dma_request, bool blocking)
+{
+    assert(dma_request.priority_slot < PRIORITY_SLOT_COUNT);
+    assert(dma_request.level_index == PRIORITY_LEVEL_INDEX_NPR);
     // lowest priority reserved for CPU
     assert(!dma_request.is_cpu_access || dma_request.priority_slot == 31);
 
 #if defined(UNIBUS)
     if (!dma_request.is_cpu_access && qunibus->is_address_overlay_active())
-        ERROR("UNIBUS ADDR lines overlayed (for M9312 boot) @ %s. Only CPU 24/26 access intended!", qunibus->addr2text(unibus_addr)) ;
+        ERROR("UNIBUS ADDR lines overlayed (for M9312 boot) @ %s. Only CPU 24/26 access intended!", qunibus->addr2text(dma_request.qunibus_start_addr)) ;
 #endif
 
     // ignore calls if INIT condition
     if (line_INIT) {
+        dma_request.success = false;
         dma_request.complete = true;
         return;
     }
-    pthread_mutex_lock(&requests_mutex); // lock schedule table operations
 
     // In contrast to re-raised INTR, overlapping DMA requests from same board
     // must not be ignored (different DATA situation) and are an device implementation error.
@@ -655,28 +865,22 @@ void qunibusadapter_c::DMA(dma_request_c& dma_request, bool blocking, uint8_t qu
     dma_request.complete = false;
     dma_request.success = false;
     dma_request.executing_on_PRU = false;
-    dma_request.qunibus_control = qunibus_cycle;
-    dma_request.qunibus_start_addr = unibus_addr;
-    dma_request.chunk_qunibus_start_addr = unibus_addr;
+    dma_request.chunk_failed = false;
+    dma_request.chunk_qunibus_start_addr = dma_request.qunibus_start_addr;
     dma_request.qunibus_end_addr = 0; // last transfered addr, or error position
-    dma_request.buffer = buffer;
-    dma_request.wordcount = wordcount;
     dma_request.chunk_max_words = PRU_MAX_DMA_WORDCOUNT; // PRU limit, maybe less
-    _DEBUG("DMA() req: dev %s, %s @ %s, wordcount %d",
+    _DEBUG("DMA() req: dev %s, %s @ %s, wordcount %d, segments %u",
            dma_request.device ? dma_request.device->name.value.c_str() : "none",
-           qunibus_c::control2text(qunibus_cycle), qunibus->addr2text(unibus_addr), wordcount);
+           qunibus_c::control2text(dma_request.qunibus_control),
+           qunibus->addr2text(dma_request.qunibus_start_addr), dma_request.wordcount,
+           dma_request.segment_count);
 
     // put into schedule tables
 
     request_schedule(dma_request); // assertion, if twice for same slot
-    if (!prl->active) {
-//	if (!request_is_active(dma_request.level_index)) {
-        // no device_DMA current performed: start immediately
-        // else triggered by PRU signals
-        request_activate_lowest_slot(dma_request.level_index);
-        request_execute_active_on_PRU(dma_request.level_index);
-    }
-    pthread_mutex_unlock(&requests_mutex);
+    // no device_DMA current performed: start immediately
+    // else triggered by PRU signals
+    request_dispatch(dma_request.level_index);
 
     // DEBUG_FAST("device DMA start: %s @ %06o, len=%d", qunibus->control2text(qunibus_cycle), unibus_addr, wordcount);
 
@@ -689,35 +893,32 @@ void qunibusadapter_c::DMA(dma_request_c& dma_request, bool blocking, uint8_t qu
             // CPU thread is now spinning
             // wait until CPU access scheduled and processed on PRU
             // in parallel, other device threads call DMA()
-            pthread_mutex_lock(&requests_mutex);
-            dma_request_c *activereq = dynamic_cast<dma_request_c *>(prl->active);
-//if (activereq == &dma_request)
-//	printf("a\n") ;
-//if (DMA_STATE_IS_COMPLETE(mailbox->dma.cur_status))
-//	printf("b\n") ;
-            if ((activereq == &dma_request) && !EVENT_IS_ACKED(*mailbox, dma)) {
-                assert(activereq->is_cpu_access);
-                // transfer DATI data to buffer, set success flag, schedule next request
-                worker_device_dma_chunk_complete_event(); // do not signal, uses complete_mutex
-                EVENT_ACK(*mailbox, dma);
-                completed = true;
-            } else if (activereq == NULL)
+            // Polling is lock-free, token only needed to complete
+            stat_cpu_polls.fetch_add(1, std::memory_order_relaxed);
+            if ((prl->active == &dma_request) && !EVENT_IS_ACKED(*mailbox, dma)) {
+                prl->lock();
+                // re-check under token: worker may have completed the request
+                // and started the next one between poll and lock()
+                if ((prl->active == &dma_request) && !EVENT_IS_ACKED(*mailbox, dma)) {
+                    // transfer DATI data to buffer, set success flag, schedule next request
+                    worker_device_dma_chunk_complete_event(); // do not signal, uses complete_mutex
+                    EVENT_ACK(*mailbox, dma);
+                    completed = true;
+                }
+                prl->unlock();
+                request_dispatch(PRIORITY_LEVEL_INDEX_NPR);
+            } else if (dma_request.complete)
                 // request aborted by worker_power_event()
+                // (->active may also be NULL while request is handed over to token owner)
                 completed = true;
-            pthread_mutex_unlock(&requests_mutex); //&dma_request.complete_mutex);
+            if (!completed)
+                pru->busywait_yield();
         } while (!completed);
 //ARM_DEBUG_PIN1(0); // CPU20 performace
 
     } else if (blocking) {
-        pthread_mutex_lock(&dma_request.complete_mutex);
         // DMA() is blocking: Wait for request to finish.
-        //	pthread_mutex_lock(&dma_request.mutex);
-        while (!dma_request.complete) {
-            int res = pthread_cond_wait(&dma_request.complete_cond,
-                                        &dma_request.complete_mutex);
-            assert(!res);
-        }
-        pthread_mutex_unlock(&dma_request.complete_mutex);
+        dma_request.wait();
     }
 }
 
@@ -760,7 +961,6 @@ void qunibusadapter_c::INTR(intr_request_c& intr_request,
     }
 
     priority_request_level_c *prl = &request_levels[intr_request.level_index];
-    pthread_mutex_lock(&requests_mutex); // lock schedule table operations
 //if (intr_request.device->log_level == LL_DEBUG)
     DEBUG_FAST("INTR() req: dev %s, slot/level/vector= %d/%d/%03o",
           intr_request.device->name.value.c_str(), (unsigned ) intr_request.priority_slot,
@@ -770,7 +970,7 @@ void qunibusadapter_c::INTR(intr_request_c& intr_request,
     // If yes: do not re-raise, will be completed at some time later.
     if (prl->slot_request[intr_request.priority_slot] != NULL) {
         intr_request_c *scheduled_intr_req =
-            dynamic_cast<intr_request_c *>(prl->slot_request[intr_request.priority_slot]);
+            dynamic_cast<intr_request_c *>(prl->slot_request[intr_request.priority_slot].load());
         assert(scheduled_intr_req);
         // A device may re-raised a pending INTR again
         // (quite normal situation when other ISRs block, CPU overload)
@@ -785,7 +985,6 @@ void qunibusadapter_c::INTR(intr_request_c& intr_request,
         // it must use different pseudo-slots.
 
         // scheduled and request_active_complete() not called
-        pthread_mutex_unlock(&requests_mutex);
         if (interrupt_register) {
             DEBUG_FAST("INTR() delayed with IR");
             // if device re-raises a blocked INTR, CSR must complete immediately
@@ -823,15 +1022,10 @@ void qunibusadapter_c::INTR(intr_request_c& intr_request,
     // put into schedule tables
     request_schedule(intr_request); // assertion, if twice for same slot
 
-    if (!prl->active) {
-        // INTR of this level can be raised immediately
-        // If other level active, let PRU atomically set the interrupt register value.
-        request_activate_lowest_slot(intr_request.level_index);
-        request_execute_active_on_PRU(intr_request.level_index);
-        // else activation triggered by PRU signal in worker()
-    }
-
-    pthread_mutex_unlock(&requests_mutex);  // work on schedule table finished
+    // INTR of this level can be raised immediately
+    // If other level active, let PRU atomically set the interrupt register value.
+    // else activation triggered by PRU signal in worker()
+    request_dispatch(intr_request.level_index);
 
     /*
      // If INTR() is blocking: Wait for request to finish.
@@ -856,33 +1050,29 @@ void qunibusadapter_c::cancel_INTR(intr_request_c& intr_request)
     if (prl->slot_request[intr_request.priority_slot] == NULL)
         return; // not scheduled or active
 
-    pthread_mutex_lock(&requests_mutex); // lock schedule table operations
+    prl->lock(); // activation of this level must not run in parallel
     if (&intr_request == prl->active) {
         // already on PRU
         assert(level_index <= PRIORITY_LEVEL_INDEX_BR7);
+        mailbox_lock();
         mailbox->intr.priority_arbitration_bit =
             priority_level_idx_to_arbitration_bit[level_index];
         mailbox_execute(ARM2PRU_INTR_CANCEL);
+        mailbox_unlock();
         request_active_complete(level_index, true);
-
-        // restart next request
-        request_activate_lowest_slot(level_index);
-        if (prl->active)
-            request_execute_active_on_PRU(level_index);
-    } else {
+    } else if (prl->slot_request[intr_request.priority_slot] == &intr_request) {
         // not active on PRU: just remove from schedule table
-        prl->slot_request[intr_request.priority_slot] = NULL; // clear slot from request
         prl->slot_request_mask &= ~(1 << intr_request.priority_slot); // mask out slot bit
+        prl->slot_request[intr_request.priority_slot] = NULL; // clear slot from request
     }
-    // both empty, or both filled
-    assert((prl->slot_request_mask == 0) == (prl->active == NULL));
 
     pthread_mutex_lock(&intr_request.complete_mutex);
     pthread_cond_signal(&intr_request.complete_cond);
     pthread_mutex_unlock(&intr_request.complete_mutex);
 
-    pthread_mutex_unlock(&requests_mutex); // lock schedule table operations
-
+    prl->unlock();
+    // restart next request
+    request_dispatch(level_index);
 }
 
 // set state of INIT
@@ -899,12 +1089,11 @@ void qunibusadapter_c::worker_init_event()
             device->on_init_changed();
         }
 
-    // Clear bus request queues,
-    pthread_mutex_lock(&requests_mutex);
+    // Clear bus request queues.
+    // No requests_init(): devices may already schedule new requests in parallel
+    requests_lock_all();
     requests_cancel_scheduled();
-    // reset all scheduled tables, also requests on PRU
-    requests_init();
-    pthread_mutex_unlock(&requests_mutex);
+    requests_unlock_all();
 }
 
 void qunibusadapter_c::worker_power_event(signal_edge_enum aclo_edge, signal_edge_enum dclo_edge) 
@@ -926,36 +1115,38 @@ void qunibusadapter_c::worker_power_event(signal_edge_enum aclo_edge, signal_edg
 
     // in true power fail, terminate pending DMA/CPU transfer
     if (dclo_edge == SIGNAL_EDGE_RAISING) {
-        // Clear bus request queues,
-        pthread_mutex_lock(&requests_mutex);
+        // Clear bus request queues
+        requests_lock_all();
         requests_cancel_scheduled();
-        // reset all scheduled tables, also requests on PRU
-        requests_init();
-        pthread_mutex_unlock(&requests_mutex);
+        requests_unlock_all();
     }
 }
 
 // process DATI/DATO access to active device registers
-
-void qunibusadapter_c::worker_deviceregister_event() 
+// signaled by blocking mailbox event, or posted via event ring.
+// evt_addr: only bits <12:0> evaluated
+void qunibusadapter_c::worker_deviceregister_event(uint8_t register_handle,
+        uint8_t unibus_control, uint32_t evt_addr, uint16_t evt_data)
 {
 	// signaled the 8bit registerhandle, locate device & register
-    uint8_t register_handle = mailbox->events.deviceregister.register_handle ;
     assert(register_handle > 0 && register_handle != IOPAGE_REGISTER_HANDLE_ROM); 
-    qunibusdevice_register_t *device_reg = register_by_handle[register_handle];
+    const register_dispatch_t *dispatch = &register_dispatch[register_handle];
+    qunibusdevice_register_t *device_reg = dispatch->reg;
 	assert(device_reg) ;
-    qunibusdevice_c *device = device_reg->device ;
-    uint32_t evt_addr = mailbox->events.deviceregister.addr;
+    qunibusdevice_c *device = dispatch->device ;
+    // logger->ignored() inline, skip call if not DEBUG
+    bool log_event = *dispatch->log_level_ptr >= LL_DEBUG;
     // normally evt_data == device_reg->pru_iopage_register->value
     // but shared value gets desorted if INIT in same event clears the registers before DATO
-    uint16_t evt_data = mailbox->events.deviceregister.data;
-    uint8_t unibus_control = mailbox->events.deviceregister.unibus_control;
 
-    // QBUS: for IOpage only addr bits <12:0> transferred,
-    // "IOPage" signal BS7 encoded in QUNIBUS_IOPAGE_ADDR_BITMASK
-#if defined(QBUS)
-    assert(evt_addr & QUNIBUS_IOPAGE_ADDR_BITMASK) ; // must be in marked IOpage
-#endif
+    if (register_event_trace_count < register_event_trace_capacity) {
+        register_event_t *traced = &register_event_trace[register_event_trace_count++];
+        traced->register_handle = register_handle;
+        traced->unibus_control = unibus_control;
+        traced->addr = evt_addr;
+        traced->data = evt_data;
+    }
+
     evt_addr = qunibus->iopage_start_addr + (evt_addr & 0x1fff) ;
 
 
@@ -967,17 +1158,18 @@ void qunibusadapter_c::worker_deviceregister_event()
      DATO: save written value into .active_write_val
      restore changed shared PRU register with .active_read_val for next read
      */
-    if (device_reg->active_on_dati && !QUNIBUS_CYCLE_IS_DATO(unibus_control)) {
+    if ((dispatch->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATI) && !QUNIBUS_CYCLE_IS_DATO(unibus_control)) {
         // register is read with DATI, this changes the logic state
         evt_addr &= ~1; // make even
         unibus_control = QUNIBUS_CYCLE_DATI;
         // read access: dati-flipflops do not change
 
         // signal: changed by QBUS/UNIBUS
-        device->log_register_event("DATI", device_reg);
+        if (log_event)
+            device->log_register_event("DATI", device_reg);
 
         device->on_after_register_access(device_reg, unibus_control, DATO_WORD);
-    } else if (device_reg->active_on_dato && QUNIBUS_CYCLE_IS_DATO(unibus_control)) {
+    } else if ((dispatch->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO) && QUNIBUS_CYCLE_IS_DATO(unibus_control)) {
         DATO_ACCESS dato_type = DATO_WORD;
         //		uint16_t reg_value_written = device_reg->pru_iopage_register->value;
         //	restore value accessible by DATI
@@ -988,14 +1180,15 @@ void qunibusadapter_c::worker_deviceregister_event()
         case QUNIBUS_CYCLE_DATO:
             // write into a register with separate read/write flipflops
             // clear unused bits, save written value
-            device_reg->active_dato_flipflops = evt_data & device_reg->writable_bits;
+            device_reg->active_dato_flipflops = evt_data & dispatch->writable_bits;
             // signal: changed by QBUS/UNIBUS
-            device->log_register_event("DATO", device_reg);
+            if (log_event)
+                device->log_register_event("DATO", device_reg);
             break;
         case QUNIBUS_CYCLE_DATOB:
             // QBUS/UNIBUS may access only 8bit half of register with DATOB.
             // convert all active registers accesses to 16 bit
-            evt_data &= device_reg->writable_bits; // clear unused bits
+            evt_data &= dispatch->writable_bits; // clear unused bits
             // save written value
             if (evt_addr & 1) { // odd address: bits 15:8 written
                 device_reg->active_dato_flipflops = (device_reg->active_dato_flipflops & 0x00ff)
@@ -1010,7 +1203,8 @@ void qunibusadapter_c::worker_deviceregister_event()
             }
             unibus_control = QUNIBUS_CYCLE_DATO; // simulate 16 bit access
             // signal: changed by QBUS/UNIBUS
-            device->log_register_event("DATOB", device_reg);
+            if (log_event)
+                device->log_register_event("DATOB", device_reg);
             break;
         }
         device->on_after_register_access(device_reg, unibus_control, dato_type);
@@ -1023,64 +1217,109 @@ void qunibusadapter_c::worker_deviceregister_event()
     }
 }
 
+// process all events in the PRU event ring, in order of occurrence.
+// PRU may append while ARM drains, these are processed in the same batch.
+// result: true if events processed
+bool qunibusadapter_c::worker_event_ring_drain()
+{
+    uint8_t tail = mailbox->event_ring.tail;
+    if (tail == mailbox->event_ring.head)
+        return false;
+    stat_event_ring_batches++;
+    do {
+        volatile mailbox_event_ring_entry_t *entry = &EVENT_RING_ENTRY(*mailbox, tail);
+        switch (entry->type) {
+        case EVENT_RING_TYPE_DEVICEREGISTER:
+            // posted DATO
+            worker_deviceregister_event(entry->register_handle, entry->unibus_control,
+                                        entry->iopage_offset, entry->data);
+            break;
+        case EVENT_RING_TYPE_INTR_MASTER: {
+            // Device INTR was transmitted. INTRs are granted unpredictable by Arbitrator
+            uint8_t level_index = entry->level_index;
+            priority_request_level_c *prl = &request_levels[level_index];
+            prl->lock();
+            worker_intr_complete_event(level_index);
+            prl->unlock();
+            request_dispatch(level_index);
+            break;
+        }
+        default:
+            FATAL("worker_event_ring_drain(): illegal event type %u", (unsigned)entry->type);
+        }
+        stat_event_ring_events++;
+        // PRU may reuse entry now. Tail must be visible before "head" is re-read,
+        // PRU signals only if it sees the ring empty.
+        mailbox->event_ring.tail = ++tail;
+        __sync_synchronize();
+    } while (tail != mailbox->event_ring.head);
+    return true;
+}
+
 // called by PRU signal when DMA transmission complete
 // Called for device DMA() chunk,
 // or cpu_DATA_transfer()
+// Processes the oldest chunk in the PRU chunk queue.
 void qunibusadapter_c::worker_device_dma_chunk_complete_event() 
 {
     priority_request_level_c *prl = &request_levels[PRIORITY_LEVEL_INDEX_NPR];
-    bool more_chunks;
-    // Must run under pthread_mutex_lock(&requests_mutex) ;
+    // Must run with level token: prl->lock()
 
-    dma_request_c *dmareq = dynamic_cast<dma_request_c *>(prl->active);
+    dma_request_c *dmareq = dynamic_cast<dma_request_c *>(prl->active.load());
 
     assert(dmareq != NULL);
-    // fix PRU data struct: remove IOPAGE bit from mailbox struct, was set im mailbox_execute()
-    mailbox->dma.startaddr &= ~QUNIBUS_IOPAGE_ADDR_BITMASK ;
-    mailbox->dma.cur_addr &= ~QUNIBUS_IOPAGE_ADDR_BITMASK ;
-    dmareq->qunibus_end_addr = mailbox->dma.cur_addr; // track end of transmission, eror position
-    unsigned wordcount_transferred = dmareq->wordcount_completed_chunks()
-                                     + mailbox->dma.wordcount;
-    assert(wordcount_transferred <= dmareq->wordcount);
-    assert(!dmareq->is_cpu_access || dmareq->wordcount == 1); // CPU accesses only single words
-    if (QUNIBUS_CYCLE_IS_DATI(mailbox->dma.buscycle)) {
-        // guard against buffer overrun
-        // PRU read chunk data from QBUS/UNIBUS into mailbox
-        // copy result cur_DMA_wordcount from mailbox->DMA buffer to cur_DMA_buffer
-        memcpy(dmareq->chunk_buffer_start(), (void *) mailbox->dma.words,
-               2 * mailbox->dma.wordcount);
-    }
-    if (mailbox->dma.cur_status != DMA_STATE_READY) {
-        // failure: abort remaining chunks
-        dmareq->success = false;
-        more_chunks = false;
-    } else if (wordcount_transferred == dmareq->wordcount) {
-        // last chunk completed
-        dmareq->success = true;
-        more_chunks = false;
+    assert(dma_chunks_queued > 0);
+    // pop chunk from queue
+    volatile mailbox_dma_chunk_t *chunk = &mailbox->dma.chunk[dma_chunk_head];
+    uint16_t *chunk_buffer = dma_chunk_buffer[dma_chunk_head];
+    dma_chunk_head = (dma_chunk_head + 1) % PRU_DMA_CHUNK_COUNT;
+    dma_chunks_queued--;
+
+    if (dmareq->chunk_failed) {
+        // previous chunk failed, end_addr remains at error position.
+        // Canceled by PRU, or queued too late and executed: ignore result.
     } else {
+        assert(chunk->cur_status != DMA_STATE_CANCELED); // only after failed chunk
+        // fix PRU data struct: remove IOPAGE bit from mailbox struct, was set im mailbox_execute()
+        chunk->startaddr &= ~QUNIBUS_IOPAGE_ADDR_BITMASK ;
+        chunk->cur_addr &= ~QUNIBUS_IOPAGE_ADDR_BITMASK ;
+        dmareq->qunibus_end_addr = chunk->cur_addr; // track end of transmission, eror position
+        assert(!dmareq->is_cpu_access || dmareq->wordcount == 1); // CPU accesses only single words
+        if (QUNIBUS_CYCLE_IS_DATI(chunk->buscycle)) {
+            // PRU read chunk data from QBUS/UNIBUS into mailbox
+            // copy result cur_DMA_wordcount from mailbox->DMA buffer to cur_DMA_buffer
+            memcpy(chunk_buffer, (void *) chunk->words, 2 * chunk->wordcount);
+        }
+        if (chunk->cur_status != DMA_STATE_READY)
+            // failure: abort remaining chunks. PRU cancels a queued one.
+            dmareq->chunk_failed = true;
+    }
+    _DEBUG(
+        "DMA chunk complete: dev %s, %s @ %s..%s, wordcount %d, data=%06o, %06o, ... status %u",
+        dmareq->device ? dmareq->device->name.value.c_str() : "none",
+        qunibus->control2text(chunk->buscycle), qunibus->addr2text(chunk->startaddr),
+        qunibus->addr2text(chunk->cur_addr), chunk->wordcount, chunk->words[0],
+        chunk->words[1], (unsigned)chunk->cur_status);
+
+    if (dma_chunks_queued) {
+        // next chunk of this request already on the PRU: refill queue
+        dma_chunks_prestage(dmareq);
+        return;
+    }
+
+    if (!dmareq->chunk_failed && dmareq->chunks_remaining()) {
         // more data to transfer: next chunk.
         assert(!dmareq->is_cpu_access); // CPU accesses only single words
-        dmareq->chunk_qunibus_start_addr = mailbox->dma.cur_addr + 2;
         // dmarequest remains prl->active and ->busy
 
-        _DEBUG(
-            "DMA chunk complete: dev %s, %s @ %s..%s, wordcount %d, data=%06o, %06o, ... %s",
-            prl->active->device ? prl->active->device->name.value.c_str() : "none",
-            qunibus->control2text(mailbox->dma.buscycle), qunibus->addr2text(mailbox->dma.startaddr),
-            qunibus->addr2text(mailbox->dma.cur_addr), mailbox->dma.wordcount, mailbox->dma.words[0],
-            mailbox->dma.words[1], dmareq->success ? "OK" : "TIMEOUT");
-
         // re-activate this request, or choose another with higher slot priority,
         // inserted in parallel (interrupt this DMA)
-        prl->active = NULL;
+        prl->active.store(NULL, std::memory_order_release);
         request_activate_lowest_slot(PRIORITY_LEVEL_INDEX_NPR);
 
         request_execute_active_on_PRU(PRIORITY_LEVEL_INDEX_NPR);
-        more_chunks = true;
-
-    }
-    if (!more_chunks) {
+    } else {
+        dmareq->success = !dmareq->chunk_failed;
         _DEBUG("DMA ready: %s @ %s..%s, wordcount %d, data=%06o, %06o, ... %s",
                qunibus->control2text(dmareq->qunibus_control),
                qunibus->addr2text(dmareq->qunibus_start_addr),
@@ -1103,7 +1342,7 @@ void qunibusadapter_c::worker_device_dma_chunk_complete_event()
 // priority_level_index:  0..3 = BR4..BR7
 void qunibusadapter_c::worker_intr_complete_event(uint8_t level_index) 
 {
-    // Must run under pthread_mutex_lock(&requests_mutex) ;
+    // Must run with level token: prl->lock()
     priority_request_level_c *prl = &request_levels[level_index];
 
     // if 1st opcode of an ISR is a "clear of INTR" condition,
@@ -1125,6 +1364,33 @@ void qunibusadapter_c::worker_intr_complete_event(uint8_t level_index)
     // else INTRs for all slots of this level completed
 }
 
+// something for worker() in the mailbox? Same conditions as the event loop.
+bool qunibusadapter_c::worker_events_pending()
+{
+    return !EVENT_IS_ACKED(*mailbox, init)
+           || !EVENT_IS_ACKED(*mailbox, power)
+           || !EVENT_IS_ACKED(*mailbox, deviceregister)
+           || EVENT_RING_COUNT(*mailbox)
+           || (!EVENT_IS_ACKED(*mailbox, dma) && !mailbox->dma.chunk[dma_chunk_head].cpu_access)
+           || !EVENT_IS_ACKED(*mailbox, intr_slave);
+}
+
+// restrict worker thread to CPU cores. mask 0: all cores
+void qunibusadapter_c::worker_set_cpu_affinity(unsigned mask)
+{
+    cpu_set_t cpuset;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    CPU_ZERO(&cpuset);
+    for (long i = 0; i < cores && i < CPU_SETSIZE; i++)
+        if (mask == 0 || (i < 32 && (mask & (1U << i))))
+            CPU_SET(i, &cpuset);
+    int res = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (res)
+        ERROR("worker(): can not set CPU affinity 0x%x: %s", mask, strerror(res));
+    else
+        INFO("worker(): CPU affinity 0x%x", mask);
+}
+
 // runs in background, catches and distributes PRU events
 void qunibusadapter_c::worker(unsigned instance) 
 {
@@ -1141,8 +1407,21 @@ void qunibusadapter_c::worker(unsigned instance)
     // worker_init_realtime_priority(rt_max); // set to max prio
 
     // mailbox may be un-initialized
+    // PRU code (re)started with empty DMA chunk queue
+    dma_chunk_head = 0;
+    dma_chunks_queued = 0;
+
+    unsigned cur_cpumask = 0; // not pinned
+    uint64_t idle_since_ns = timeout_c::abstime_ns(); // busy_poll: last event
 
     while (!workers_terminate) {
+        if (register_event_trace_cmd != trace_cmd_none)
+            register_event_trace_execute();
+        if (cpumask.value != cur_cpumask) {
+            cur_cpumask = cpumask.value;
+            worker_set_cpu_affinity(cur_cpumask);
+        }
+
         // Timing:
         // This is THE ONE mechanism where "realtime meets Linux"
         // To respond to the PRU signal, Linux must wake up schedule this thread
@@ -1160,12 +1439,30 @@ void qunibusadapter_c::worker(unsigned instance)
          the event has taken place, as an unsigned int. There is no out-of-
          band value to indicate error (and it can wrap around to 0 if you
          run the program just a whole lot of times). */
-        res = prussdrv_pru_wait_event_timeout(PRU_EVTOUT_0, 100000/*us*/);
+        // busy_poll: Linux wakeup not needed if event found by polling.
+        // PRU interrupts still raised, so blocking wait may return without new event.
+        bool polling = busy_poll.value && mailbox
+                       && timeout_c::abstime_ns() - idle_since_ns < 1000LL * poll_idle.value;
+        if (polling) {
+            if (!worker_events_pending()) {
+                sched_yield(); // only others of same RT priority
+                continue;
+            }
+            res = 1;
+            stat_worker_polled++;
+        } else {
+            res = pru->wait_event(100000/*us*/);
 //res = prussdrv_pru_wait_event(PRU_EVTOUT_0);
-        // PRU may have raised more than one event before signal is accepted.
-        // single combination of only INIT+DATI/O possible
-        prussdrv_pru_clear_event(PRU_EVTOUT_0, PRU0_ARM_INTERRUPT);
-        // uses select() internally: 0 = timeout, -1 = error, else event count received
+            // PRU may have raised more than one event before signal is accepted.
+            // single combination of only INIT+DATI/O possible
+            pru->clear_event();
+            // uses select() internally: 0 = timeout, -1 = error, else event count received
+            if (res > 0)
+                stat_worker_waited++;
+        }
+        uint64_t handler_ns = timeout_c::abstime_ns();
+        if (res > 0)
+            idle_since_ns = handler_ns;
         any_event = true;
         // at startup sequence, mailbox may be not yet valid
         while (mailbox && res > 0 && any_event) { // res is const
@@ -1181,6 +1478,11 @@ void qunibusadapter_c::worker(unsigned instance)
 #if defined(UNIBUS)
             bool init_raising_edge = false;
             bool init_falling_edge = false;
+#elif defined(QBUS)
+            // CPU is blocked by DMR after INIT until ACK, so all posted events
+            // in the ring are older than a pending INIT.
+            if (worker_event_ring_drain())
+                any_event = true;
 #endif			
             if (!EVENT_IS_ACKED(*mailbox, init)) {
                 any_event = true;
@@ -1258,42 +1560,47 @@ void qunibusadapter_c::worker(unsigned instance)
 			// we receive event INIT and execute device initalization.
 			// PDP11 CPU state is out of sync with device state in that time, but CPU sees device
 			// only via SSYN/RPLY halted deviceregister accesses. So make sure pending INIT are processed before register access
+            // posted DATOs and INTR completions. Before blocking DATI/DATO,
+            // which may have been signaled because the ring was full.
+            if (EVENT_IS_ACKED(*mailbox, init) && worker_event_ring_drain())
+                any_event = true;
+
             if (!EVENT_IS_ACKED(*mailbox, deviceregister) && EVENT_IS_ACKED(*mailbox, init)) {
                 any_event = true;
 
                 // DATI/DATO
                 // DEBUG_FAST("EVENT_DEVICEREGISTER:  control=%d, addr=%06o", (int)mailbox->events.unibus_control, mailbox->events.addr);
-                worker_deviceregister_event();
+                // QBUS: for IOpage only addr bits <12:0> transferred,
+                // "IOPage" signal BS7 encoded in QUNIBUS_IOPAGE_ADDR_BITMASK
+#if defined(QBUS)
+                assert(mailbox->events.deviceregister.addr & QUNIBUS_IOPAGE_ADDR_BITMASK) ; // must be in marked IOpage
+#endif
+                worker_deviceregister_event(mailbox->events.deviceregister.register_handle,
+                                            mailbox->events.deviceregister.unibus_control,
+                                            mailbox->events.deviceregister.addr,
+                                            mailbox->events.deviceregister.data);
                 // ARM2PRU opcodes raised by device logic are processed in midst of bus cycle
                 EVENT_ACK(*mailbox, deviceregister); // PRU continues bus cycle with SSYN now
             }
 
-            if (!EVENT_IS_ACKED(*mailbox, dma) && !mailbox->dma.cpu_access) {
+            if (!EVENT_IS_ACKED(*mailbox, dma)
+                    && !mailbox->dma.chunk[dma_chunk_head].cpu_access) {
                 // not called for CPU DATI/DATO
+                // one event per chunk, in order of the PRU chunk queue
 
                 any_event = true;
-                pthread_mutex_lock(&requests_mutex);
-                worker_device_dma_chunk_complete_event();
-
-                pthread_mutex_unlock(&requests_mutex);
-                // PRU may have set again event_dma again, if this is called before EVENT signal??
-                // call this only on signal, not on timeout!
-
-                // this may clear reraised PRU event flag!
-                EVENT_ACK(*mailbox, dma); // PRU may re-raise and change mailbox now
-            }
-
-            // 4 events for each BG4,5,6,7
-            for (unsigned level_index = 0; level_index < 4; level_index++) {
-                if (!EVENT_IS_ACKED(*mailbox, intr_master[level_index])) {
-                    // Device INTR was transmitted. INTRs are granted unpredictable by Arbitrator
-                    any_event = true;
-                    // INTR of which level? the .active rquest of the"
-                    pthread_mutex_lock(&requests_mutex);
-                    worker_intr_complete_event(level_index);
-                    pthread_mutex_unlock(&requests_mutex);
-                    EVENT_ACK(*mailbox, intr_master[level_index]); // PRU may re-raise and change mailbox now
+                priority_request_level_c *prl = &request_levels[PRIORITY_LEVEL_INDEX_NPR];
+                prl->lock();
+                // re-check with token: head may have changed to a CPU access
+                if (!EVENT_IS_ACKED(*mailbox, dma)
+                        && !mailbox->dma.chunk[dma_chunk_head].cpu_access) {
+                    worker_device_dma_chunk_complete_event();
+                    // ack under token: CPU polling DMA() must not see this event
+                    // as completion of its own chunk.
+                    EVENT_ACK(*mailbox, dma); // PRU may re-raise and change mailbox now
                 }
+                prl->unlock();
+                request_dispatch(PRIORITY_LEVEL_INDEX_NPR);
             }
 
             if (!EVENT_IS_ACKED(*mailbox, intr_slave)) {
@@ -1316,6 +1623,12 @@ void qunibusadapter_c::worker(unsigned instance)
 			}
 #endif			
         }
+        if (res > 0 && pru->is_virtual()) {
+            // oldest signal not yet seen, may be raised while events processed
+            uint64_t signal_ns = pru->virtual_pru->take_signal_timestamp();
+            if (signal_ns)
+                stat_event_latency_add(handler_ns > signal_ns ? handler_ns - signal_ns : 0);
+        }
         // Signal to PRU: continue QBUS/UNIBUS cycles now with SSYN negated
     }
 }
@@ -1347,9 +1660,9 @@ void qunibusadapter_c::print_pru_iopage_register_map()
             else {
 				// signaled the 8bit registerhandle, locate device & register
 				uint8_t event_register_handle = pru_iopage_reg->event_register_handle ;
-				qunibusdevice_register_t *device_reg = register_by_handle[event_register_handle];
+				qunibusdevice_register_t *device_reg = register_dispatch[event_register_handle].reg;
 				assert(device_reg) ;
-				qunibusdevice_c *device = device_reg->device ;
+				qunibusdevice_c *device = register_dispatch[event_register_handle].device ;
 
                 printf("active iopage reg with handle %d linked to device %s reg[%s]\n", event_register_handle,
                        device->name.value.c_str(), device_reg->name);
@@ -1385,6 +1698,127 @@ void qunibusadapter_c::print_pru_iopage_register_map()
         }
 }
 
+// Trace buffer and device register callbacks belong to worker():
+// start and replay are passed to worker() and executed there between events.
+// Without running worker() they are executed in the caller's thread.
+void qunibusadapter_c::register_event_trace_call(enum register_event_trace_cmd_e cmd,
+        unsigned param)
+{
+    register_event_trace_cmd_param = param;
+    register_event_trace_cmd = cmd;
+    while (register_event_trace_cmd != trace_cmd_none && !workers.empty()
+            && workers[0].running && !workers_terminate)
+        timeout_c::wait_ms(1);
+    if (register_event_trace_cmd != trace_cmd_none)
+        register_event_trace_execute();
+}
+
+// runs in worker()
+void qunibusadapter_c::register_event_trace_execute(void)
+{
+    if (register_event_trace_cmd == trace_cmd_start) {
+        register_event_trace_capacity = 0; // stop recording
+        register_event_trace.resize(register_event_trace_cmd_param);
+        register_event_trace_count = 0;
+        register_event_trace_capacity = register_event_trace_cmd_param;
+    } else if (register_event_trace_cmd == trace_cmd_replay) {
+        timeout_c timer;
+        unsigned count = register_event_trace_count;
+        unsigned loops = register_event_trace_cmd_param;
+        register_event_trace_capacity = 0; // stop recording, do not trace the replay
+        register_event_trace_cmd_result = 0;
+        if (count > 0 && loops > 0) {
+            timer.start_ns(0);
+            for (unsigned loop = 0; loop < loops; loop++)
+                for (unsigned i = 0; i < count; i++) {
+                    register_event_t *evt = &register_event_trace[i];
+                    worker_deviceregister_event(evt->register_handle, evt->unibus_control,
+                                                evt->addr, evt->data);
+                }
+            register_event_trace_cmd_result = timer.elapsed_ns() / ((uint64_t) loops * count);
+        }
+    }
+    register_event_trace_cmd = trace_cmd_none; // release caller
+}
+
+// Record the next "count" register events processed by worker().
+void qunibusadapter_c::register_event_trace_start(unsigned count)
+{
+    register_event_trace_call(trace_cmd_start, count);
+}
+
+// Feed recorded register events "loops" times into the worker event processing,
+// as if received again from PRU. Device logic executes them!
+// Measures ARM time per event, without PRU signaling.
+// PRU events are not processed meanwhile, bus should be idle.
+// result: avg ns per event, 0 if no trace
+uint64_t qunibusadapter_c::register_event_trace_replay(unsigned loops)
+{
+    register_event_trace_call(trace_cmd_replay, loops);
+    return register_event_trace_cmd_result;
+}
+
+// contention of request scheduling between device threads, CPU and worker
+void qunibusadapter_c::print_request_statistics()
+{
+    static const char *level_names[PRIORITY_LEVEL_COUNT] = { "BR4", "BR5", "BR6", "BR7", "NPR" };
+    printf("Level  Scheduled   Handoffs  Lock waits  Lock spins\n");
+    for (unsigned level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++) {
+        priority_request_level_c *prl = &request_levels[level_index];
+        printf("%-5s %10u %10u  %10u  %10u\n", level_names[level_index],
+               prl->stat_scheduled.load(), prl->stat_handoffs.load(),
+               prl->stat_lock_waits.load(), prl->stat_lock_spins.load());
+    }
+    printf("CPU DATA transfer polls: %u\n", stat_cpu_polls.load());
+    printf("Device DMA chunks: %u, %u of them pre-staged while PRU busy\n",
+           stat_dma_chunks, stat_dma_chunks_staged);
+    printf("PRU event ring: %u events in %u batches\n",
+           stat_event_ring_events, stat_event_ring_batches);
+    printf("Worker event passes: %u found by busy polling, %u after PRU interrupt\n",
+           stat_worker_polled, stat_worker_waited);
+    unsigned latency_count = 0;
+    for (unsigned i = 0; i < EVENT_LATENCY_BUCKETS; i++)
+        latency_count += stat_event_latency[i];
+    if (latency_count) {
+        printf("PRU signal to worker latency: %u events, max %llu us\n", latency_count,
+               (unsigned long long) stat_event_latency_max_ns / 1000);
+        for (unsigned i = 0; i < EVENT_LATENCY_BUCKETS - 1; i++)
+            if (stat_event_latency[i])
+                printf("  < %6u us: %8u = %5.1f%%\n", 1U << i, stat_event_latency[i],
+                       100.0 * stat_event_latency[i] / latency_count);
+        unsigned i = EVENT_LATENCY_BUCKETS - 1; // overflow bucket
+        if (stat_event_latency[i])
+            printf(" >= %6u us: %8u = %5.1f%%\n", 1U << (i - 1), stat_event_latency[i],
+                   100.0 * stat_event_latency[i] / latency_count);
+    }
+}
+
+void qunibusadapter_c::clear_request_statistics()
+{
+    for (unsigned level_index = 0; level_index < PRIORITY_LEVEL_COUNT; level_index++)
+        request_levels[level_index].clear_statistics();
+    stat_cpu_polls = 0;
+    stat_dma_chunks = 0;
+    stat_dma_chunks_staged = 0;
+    stat_event_ring_events = 0;
+    stat_event_ring_batches = 0;
+    stat_worker_polled = 0;
+    stat_worker_waited = 0;
+    memset(stat_event_latency, 0, sizeof(stat_event_latency));
+    stat_event_latency_max_ns = 0;
+}
+
+void qunibusadapter_c::stat_event_latency_add(uint64_t latency_ns)
+{
+    unsigned bucket = 0;
+    uint64_t latency_us = latency_ns / 1000;
+    while (bucket < EVENT_LATENCY_BUCKETS - 1 && latency_us >= (1ULL << bucket))
+        bucket++;
+    stat_event_latency[bucket]++;
+    if (latency_ns > stat_event_latency_max_ns)
+        stat_event_latency_max_ns = latency_ns;
+}
+
 // diag: access to internal state of DMA and interrupt request handling
 mailbox_t mailbox_snapshot;
 
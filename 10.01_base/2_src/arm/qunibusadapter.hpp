@@ -21,6 +21,11 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ oct-2026	agent		register dispatch table, register event trace and replay
+ oct-2026	agent		busy-poll worker, CPU affinity, event latency histogram
+ oct-2026	agent		event ring drain, worker_deviceregister_event() with event parameters
+ oct-2026	agent		scatter-gather DMA, 2nd DMA chunk pre-staged on PRU
+ oct-2026	agent		lock-free request tables, no global requests_mutex
  aug-2020	JH		adapted to QBUS
  jul-2019     JH      rewrite: multiple parallel arbitration levels	 
  12-nov-2018  JH      entered beta phase
@@ -29,58 +34,146 @@
 #ifndef _QUNIBUSADAPTER_HPP_
 #define _QUNIBUSADAPTER_HPP_
 
+#include <atomic>
+#include <vector>
+
 #include "iopageregister.h"
+#include "mailbox.h"
 #include "priorityrequest.hpp"
 #include "qunibusadapter.hpp"
 #include "qunibusdevice.hpp"
 
 // for each priority arbitration level, theres a table with backplane slots.
 //  Each device sits in a slot, the slot determinss the request priority within one level (BR4567,NP).
+// No global lock: device threads insert requests into slot_request[] and slot_request_mask
+// with atomic operations.
+// Changing ->active (activate, execute on PRU, complete, cancel) needs the "busy" token of
+// the level. A thread which can not get the token hands its request over to the token owner,
+// who re-checks the table after releasing the token.
 class priority_request_level_c {
 public:
 	// remember for each backplane slot wether the device has requested
 	// INTR or DMA at this level
-	priority_request_c* slot_request[PRIORITY_SLOT_COUNT + 1];
+	// Insert: slot first, then mask bit. Remove: mask bit first, then slot.
+	std::atomic<priority_request_c*> slot_request[PRIORITY_SLOT_COUNT + 1];
 	// Optimization to find the high priorized slot in use very fast.
 	// bit array: bit set -> slot<bitnr> has open request.
-	uint32_t slot_request_mask;
+	std::atomic<uint32_t> slot_request_mask;
+
+	// request currently handled by PRU. Read lock-free, written only with "busy" token
+	std::atomic<priority_request_c*> active;
+
+	std::atomic<bool> busy; // token: a thread is changing ->active
 
-	priority_request_c* active; // request currently handled by PRU, not in table anymore
+	// contention statistics, updated by any thread without token. relaxed counters.
+	std::atomic<unsigned> stat_scheduled; // requests inserted into table
+	std::atomic<unsigned> stat_handoffs; // level busy, request left to token owner
+	std::atomic<unsigned> stat_lock_waits; // lock() found level busy
+	std::atomic<unsigned> stat_lock_spins; // total loops waiting for token
+
+	bool try_lock(void) {
+		bool expected = false;
+		return busy.compare_exchange_strong(expected, true);
+	}
+	void lock(void);
+	// seq_cst: orders against following reads of slot_request_mask, see request_dispatch()
+	void unlock(void) {
+		busy.store(false);
+	}
 
 	void clear();
+	void clear_statistics(void);
 };
 
 class unibuscpu_c ;
 
 
-// is a device_c. need a thread (but no params)
+// log2 histogram of PRU event latency: bucket i counts latencies < 2^i us
+#define EVENT_LATENCY_BUCKETS	20
+
+// PRU->ARM lookup for register events, indexed by 8bit register handle.
+// Static register setup copied from qunibusdevice_register_t, so
+// worker_deviceregister_event() needs only this entry and the flipflops.
+// Handles are compact (< MAX_IOPAGE_REGISTER_COUNT), so the table is much smaller
+// than one indexed by IO page address.
+typedef struct {
+	qunibusdevice_c *device; // on_after_register_access() callback
+	qunibusdevice_register_t *reg; // NULL: handle not in use
+	unsigned *log_level_ptr; // verbosity of device, DEBUG: log register events
+	uint16_t writable_bits;
+	uint8_t event_flags; // IOPAGEREGISTER_EVENT_FLAG_DATI/_DATO
+} register_dispatch_t;
+
+// a register event as received from PRU, for trace and replay
+typedef struct {
+	uint8_t register_handle;
+	uint8_t unibus_control;
+	uint32_t addr;
+	uint16_t data;
+} register_event_t;
+
+// is a device_c. need a thread, params tune the worker
 class qunibusadapter_c: public device_c {
 private:
 
 	// handle arbitration for each of the 5 device request levels in parallel
 	priority_request_level_c request_levels[PRIORITY_LEVEL_COUNT];
 
+	// Mirror of DMA chunk queue on PRU, see mailbox_dma_t.
+	// All queued chunks belong to the active NPR request. Access with NPR token.
+	unsigned dma_chunk_head; // index of oldest chunk queued on PRU
+	unsigned dma_chunks_queued; // chunks on PRU, not yet processed by complete event
+	uint16_t *dma_chunk_buffer[PRU_DMA_CHUNK_COUNT]; // DATI destination for each chunk
+
 	// access of master CPU to memory not handled via priority arbitration
 //	dma_request_c 	*cpu_data_transfer_request ; // needs no link to CPU
 
-	pthread_mutex_t requests_mutex;
-
 	unibuscpu_c	*registered_cpu ; // only one unibuscpu_c may be registered
 
 	// Helper map: find register via 8bit handle
-	qunibusdevice_register_t *register_by_handle[MAX_IOPAGE_REGISTER_COUNT];
-	
+	register_dispatch_t register_dispatch[MAX_IOPAGE_REGISTER_COUNT];
+
+	// trace of register events, for replay benchmark. Only accessed by worker()
+	std::vector<register_event_t> register_event_trace;
+	unsigned register_event_trace_capacity; // 0 = not recording
+	unsigned register_event_trace_count;
+	// start/replay command from other threads to worker()
+	enum register_event_trace_cmd_e {
+		trace_cmd_none, trace_cmd_start, trace_cmd_replay
+	};
+	std::atomic<register_event_trace_cmd_e> register_event_trace_cmd;
+	unsigned register_event_trace_cmd_param; // start: event count, replay: loops
+	uint64_t register_event_trace_cmd_result; // replay: ns per event
+	void register_event_trace_call(enum register_event_trace_cmd_e cmd, unsigned param);
+	void register_event_trace_execute(void);
 
 	void worker_init_event(void);
 	void worker_power_event(signal_edge_enum aclo_edge, signal_edge_enum dclo_edge);
-	void worker_deviceregister_event(void);
+	void worker_deviceregister_event(uint8_t register_handle, uint8_t unibus_control,
+			uint32_t evt_addr, uint16_t evt_data);
+	bool worker_event_ring_drain(void);
 	void worker_device_dma_chunk_complete_event(void);
 	void worker_intr_complete_event(uint8_t level_index);
+	void request_dispatch(unsigned level_index);
+	void dma_chunk_queue(dma_request_c *dmareq);
+	void dma_chunks_prestage(dma_request_c *dmareq);
+	void DMA_execute(dma_request_c& dma_request, bool blocking);
+	bool worker_events_pending(void);
+	void worker_set_cpu_affinity(unsigned mask);
 	void worker(unsigned instance) override; // background worker function
 
 public:
 	qunibusadapter_c();
 
+	// Low latency: worker polls the mailbox instead of waiting for the PRU interrupt.
+	// Use with "cpumask" on a core not used by Linux otherwise ("isolcpus=")
+	parameter_bool_c busy_poll = parameter_bool_c(this, "busy_poll", "bp", /*readonly*/
+	false, "1 = worker polls for PRU events, no interrupt wakeup latency");
+	parameter_unsigned_c poll_idle = parameter_unsigned_c(this, "poll_idle", "pi", /*readonly*/
+	false, "us", "%d", "busy_poll: after this time without event wait for interrupt", 32, 10);
+	parameter_unsigned_c cpumask = parameter_unsigned_c(this, "cpumask", "cm", /*readonly*/
+	false, "", "%x", "Bitmask of CPU cores for worker, 0 = all", 32, 16);
+
 	bool on_param_changed(parameter_c *param) override;  // must implement
 
 	// list of registered devices.
@@ -107,6 +200,8 @@ public:
 
 	void request_schedule(priority_request_c& request);
 	void requests_cancel_scheduled(void);
+	void requests_lock_all(void);
+	void requests_unlock_all(void);
 	priority_request_c *request_activate_lowest_slot(unsigned level_index);
 //	bool request_is_active(		unsigned level_index);
 	bool request_is_blocking_active(uint8_t level_index);
@@ -115,6 +210,8 @@ public:
 
 	void DMA(dma_request_c& dma_request, bool blocking, uint8_t qunibus_cycle,
 			uint32_t unibus_addr, uint16_t *buffer, uint32_t wordcount);
+	void DMA(dma_request_c& dma_request, bool blocking, uint8_t qunibus_cycle,
+			const dma_segment_t *segments, unsigned segment_count);
 	void INTR(intr_request_c& intr_request, qunibusdevice_register_t *interrupt_register,
 			uint16_t interrupt_register_value);
 	void cancel_INTR(intr_request_c& intr_request);
@@ -123,6 +220,27 @@ public:
 
 	void print_pru_iopage_register_map(void);
 
+	// record the next "count" register events. Replay: returns ns per event, 0 if trace empty
+	void register_event_trace_start(unsigned count);
+	unsigned register_event_trace_recorded(void) {
+		return register_event_trace_count;
+	}
+	uint64_t register_event_trace_replay(unsigned loops);
+
+	std::atomic<unsigned> stat_cpu_polls; // CPU DATA transfer: loops polling for PRU completion
+	unsigned stat_dma_chunks; // device DMA chunks queued on PRU
+	unsigned stat_dma_chunks_staged; // ... of these queued while PRU busy with previous chunk
+	unsigned stat_event_ring_events; // posted events processed by worker()
+	unsigned stat_event_ring_batches; // ... in this many drain passes
+	unsigned stat_worker_polled; // event passes started by busy polling
+	unsigned stat_worker_waited; // ... started by PRU interrupt
+	// PRU signal to worker latency. Only with virtual PRU, physical PRU has no common clock
+	unsigned stat_event_latency[EVENT_LATENCY_BUCKETS];
+	uint64_t stat_event_latency_max_ns;
+	void stat_event_latency_add(uint64_t latency_ns);
+	void print_request_statistics(void);
+	void clear_request_statistics(void);
+
 		void debug_init(void) ;
 	void debug_snapshot(void) ;
 };
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ oct-2026	agent		register option "posted_dato"
  aug-2020	JH		adapted to QBUS
  6-feb-2020	JH		added symbol table
  12-nov-2018  JH      entered beta phase
@@ -44,6 +45,9 @@ qunibusdevice_c::qunibusdevice_c() :		device_c()
 {
 	handle = 0;
 	register_count = 0;
+	// devices set only what they need
+	for (unsigned i = 0; i < MAX_IOPAGE_REGISTERS_PER_DEVICE; i++)
+		registers[i].posted_dato = false;
 	// device is not yet enabled, QBUS/UNIBUS properties can be set
 	base_addr.readonly = false;
     // Kristen McIntyre: reinitialize the base address's bitwidth now that we are initialized
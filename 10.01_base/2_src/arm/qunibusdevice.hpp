@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   register option "posted_dato"
  12-nov-2018  JH      entered beta phase
  */
 
@@ -74,6 +75,10 @@ typedef struct qunibusdevice_register_struct {
 	//   UNIBUS access to the register
 	bool active_on_dati; // call on_after_register_access() on DATI
 	bool active_on_dato; // call on_after_register_access() on DATO
+	// "posted_dato": DATO event is queued, bus cycle continues without waiting for ARM.
+	//	on_after_register_access() runs some usecs later, a DATI before sees the written value.
+	//	Only for parameter registers, where a DATO does not start an action visible on the bus.
+	bool posted_dato;
 	uint16_t reset_value;
 	uint16_t writable_bits;
 
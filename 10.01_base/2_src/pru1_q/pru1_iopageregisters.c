@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   posted DATO events via mailbox event ring
  12-nov-2018  JH      entered beta phase
  */
 
@@ -109,8 +110,12 @@ uint8_t emulated_addr_write_w(uint32_t addr, uint16_t w) {
 			uint16_t reg_val = (reg->value & ~reg->writable_bits) | (w & reg->writable_bits);
 			reg->value = reg_val;
 			if (reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO) {
-				DO_EVENT_DEVICEREGISTER(reg, QUNIBUS_CYCLE_DATO, addr, reg_val);
-				}
+				// posted: no SSYN stall, if ARM has room for the event
+				if ((reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED) && !EVENT_RING_IS_FULL(mailbox))
+					DO_EVENT_RING_DEVICEREGISTER(reg, QUNIBUS_CYCLE_DATO, addr, reg_val);
+				else
+					DO_EVENT_DEVICEREGISTER(reg, QUNIBUS_CYCLE_DATO, addr, reg_val);
+			}
 			return 2;
 		}
 	} else
@@ -145,8 +150,13 @@ uint8_t emulated_addr_write_b(uint32_t addr, uint8_t b) {
 				| (reg->value & ~reg->writable_bits & 0x00ff) // protected upper byte bits
 						| (b & reg->writable_bits); // changed lower byte bits
 			reg->value = reg_val;
-			if (reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO)
-				DO_EVENT_DEVICEREGISTER(reg, QUNIBUS_CYCLE_DATOB, addr, reg_val);
+			if (reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO) {
+				// posted: no SSYN stall, if ARM has room for the event
+				if ((reg->event_flags & IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED) && !EVENT_RING_IS_FULL(mailbox))
+					DO_EVENT_RING_DEVICEREGISTER(reg, QUNIBUS_CYCLE_DATOB, addr, reg_val);
+				else
+					DO_EVENT_DEVICEREGISTER(reg, QUNIBUS_CYCLE_DATOB, addr, reg_val);
+			}
 			return 2;
 		}
 	} else
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   INTR complete posted to mailbox event ring
  12-nov-2018  JH      entered beta phase
 
  Statemachine for execution of the Priority Arbitration protocol
@@ -302,6 +303,9 @@ uint8_t sm_arb_worker_device(uint8_t granted_requests_mask) {
         // "9. The Bus Slave negates TRPLY 0 ns minimum after the negation of RIAKI."
         if (buslatches_getbyte(6) & BIT(5))
             return 0 ; // wait for RIAKI to negate
+        // INTR may come faster than ARM Linux can process: need room in the event ring
+        if (EVENT_RING_IS_FULL(mailbox))
+            return 0 ; // wait, RPLY held
         buslatches_setbits(4, BIT(3), 0) ; // negate RPLY
         // "10. The Bus Slave continues to gate TVECT onto the Bus for 0 ns
         // minimum and 100 ns maximum after negating TRPLY."
@@ -313,14 +317,9 @@ uint8_t sm_arb_worker_device(uint8_t granted_requests_mask) {
         // if (buslatches_getbyte(4) & BIT(1))
         //	return 0 ; // wait for DIN to negate, "RPLY negate" repeats then
 
-        // signal to ARM which INTR was completed
-        // change mailbox only after ARM has ack'ed mailbox.events.event_intr
-        // mailbox.events.intr_master.level_index = sm_intr_master.level_index;
-        EVENT_SIGNAL(mailbox,intr_master[sm_arb.intr_level_index]);
-        // ARM is clearing this, before requesting new interrupt of same level
-        // so no concurrent ARP+PRU access
-        PRU2ARM_INTERRUPT
-        ;
+        // signal to ARM which INTR was completed.
+        // ARM processes it before requesting new interrupt of same level
+        DO_EVENT_RING_POST(EVENT_RING_TYPE_INTR_MASTER, 0, 0, sm_arb.intr_level_index, 0, 0);
 
         sm_arb.state = state_arbitration_grant_check ; // restart
 
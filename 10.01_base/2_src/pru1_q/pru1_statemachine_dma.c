@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026	agent		chunk queue: next chunk requested without ARM round trip
  01-aug-2020	JH		start QBUS
  29-jun-2019	JH		rework: state returns ptr to next state func
  12-nov-2018	JH      entered beta phase
@@ -39,7 +40,7 @@
  while(sm_dma_state != DMA_STATE_READY)
  sm_dma_service() ;
  state is 0 for OK, or 2 for timeout error.
- mailbox.dma.cur_addr is error location
+ sm_dma.chunk->cur_addr is error location
 
  Uses global timeout
  */
@@ -73,7 +74,44 @@ static statemachine_state_func sm_dma_state_dout_start(void);
 static statemachine_state_func sm_dma_state_dout_complete(void);
 static statemachine_state_func sm_dma_state_99(void);
 
-// dma mailbox setup with
+// request bus for a queued chunk
+static void sm_dma_request(volatile mailbox_dma_chunk_t *chunk) {
+    if (chunk->cpu_access) {
+        // Emulated CPU: no NPR/NPG/SACK protocol
+        sm_arb.cpu_request = 1;
+    } else {
+        // Emulated device: raise request for emulated or physical Arbitrator.
+        sm_arb.device_request_mask |= PRIORITY_ARBITRATION_BIT_NP;
+    }
+}
+
+// ARM2PRU_DMA: ARM has filled the next free chunk in mailbox.dma.chunk[].
+// Only the head of the queue requests the bus, a 2nd chunk is
+// requested by sm_dma_state_99() when the 1st is complete.
+void sm_dma_queue_chunk() {
+    uint8_t idx = (sm_dma.chunk_idx + sm_dma.chunks_queued) & 1;
+    if (sm_dma.chunks_queued++ == 0)
+        sm_dma_request(&mailbox.dma.chunk[idx]);
+}
+
+// INIT clears the NPR request: report all queued device chunks as stopped,
+// each queued chunk must produce an event.
+// Only called while no chunk is transferred.
+// Emulated CPU accesses survive INIT.
+void sm_dma_cancel_queue() {
+    if (!sm_dma.chunks_queued || mailbox.dma.chunk[sm_dma.chunk_idx].cpu_access)
+        return;
+    while (sm_dma.chunks_queued) {
+        mailbox.dma.chunk[sm_dma.chunk_idx].cur_status = DMA_STATE_INITSTOP;
+        EVENT_SIGNAL(mailbox, dma);
+        sm_dma.chunk_idx ^= 1;
+        sm_dma.chunks_queued--;
+    }
+    PRU2ARM_INTERRUPT
+    ;
+}
+
+// dma chunk setup with
 // startaddr, wordcount, cycle, words[]   ?
 // "cycle" must be QUNIBUS_CYCLE_DATI or QUNIBUS_CYCLE_DATO
 // DATIO not supported,
@@ -87,10 +125,11 @@ statemachine_state_func sm_dma_start() {
     // assert BBSY: latch[1], bit 6
     // buslatches_setbits(1, BIT(6), BIT(6));
 
-    mailbox.dma.cur_addr = mailbox.dma.startaddr;
-    sm_dma.dataptr = (uint16_t *) mailbox.dma.words; // point to start of data buffer
-    sm_dma.words_left = mailbox.dma.wordcount;
-    mailbox.dma.cur_status = DMA_STATE_RUNNING;
+    sm_dma.chunk = &mailbox.dma.chunk[sm_dma.chunk_idx];
+    sm_dma.chunk->cur_addr = sm_dma.chunk->startaddr;
+    sm_dma.dataptr = (uint16_t *) sm_dma.chunk->words; // point to start of data buffer
+    sm_dma.words_left = sm_dma.chunk->wordcount;
+    sm_dma.chunk->cur_status = DMA_STATE_RUNNING;
 
     // next call to sm_dma.state() starts state machine
     return (statemachine_state_func) &sm_dma_state_addr;
@@ -101,10 +140,10 @@ statemachine_state_func sm_dma_start() {
 // If slave address is internal (= implemented by QBone),
 // fast slave protocol is generated on the bus.
 static statemachine_state_func sm_dma_state_addr() {
-    uint32_t addr = mailbox.dma.cur_addr; // non-volatile snapshot
-    uint8_t buscycle = mailbox.dma.buscycle;
+    uint32_t addr = sm_dma.chunk->cur_addr; // non-volatile snapshot
+    uint8_t buscycle = sm_dma.chunk->buscycle;
 
-    if (mailbox.dma.cur_status != DMA_STATE_RUNNING || mailbox.dma.wordcount == 0)
+    if (sm_dma.chunk->cur_status != DMA_STATE_RUNNING || sm_dma.chunk->wordcount == 0)
         return NULL; // still stopped
 
     sm_dma.state_timeout = 0;
@@ -184,7 +223,7 @@ static statemachine_state_func sm_dma_state_addr() {
 
 // initiate a DIN
 statemachine_state_func sm_dma_state_din_start() {
-    uint32_t addr = mailbox.dma.cur_addr; // non-volatile snapshot, BS7 encoded
+    uint32_t addr = sm_dma.chunk->cur_addr; // non-volatile snapshot, BS7 encoded
     uint16_t data;
 
     // "The Bus Master asserts TDIN 100 ns minimum after asserting TSYNC"
@@ -251,8 +290,8 @@ statemachine_state_func sm_dma_state_din_start() {
 
 // initiate a DOUT
 statemachine_state_func sm_dma_state_dout_start() {
-    uint32_t addr = mailbox.dma.cur_addr; // non-volatile snapshot, BS7 encoded
-    uint8_t buscycle = mailbox.dma.buscycle;
+    uint32_t addr = sm_dma.chunk->cur_addr; // non-volatile snapshot, BS7 encoded
+    uint8_t buscycle = sm_dma.chunk->buscycle;
     uint16_t data;
 
     bool internal;
@@ -330,7 +369,7 @@ statemachine_state_func sm_dma_state_dout_start() {
 // DATI to external slave: DIN set, wait for RPLY or timeout
 static statemachine_state_func sm_dma_state_din_complete() {
     uint16_t tmpval;
-    uint32_t addr = mailbox.dma.cur_addr; // non-volatile snapshot, BS7 encoded
+    uint32_t addr = sm_dma.chunk->cur_addr; // non-volatile snapshot, BS7 encoded
 
 
     // "The slave asserts TRPLY 0ns minimum (8000 ns maximum to avoid bus timeouts)
@@ -383,7 +422,7 @@ static statemachine_state_func sm_dma_state_din_complete() {
 
 // DATO to external slave: DOUT set, wait for RPLY or timeout
 static statemachine_state_func sm_dma_state_dout_complete() {
-    uint32_t addr = mailbox.dma.cur_addr; // non-volatile snapshot, BS7 encoded
+    uint32_t addr = sm_dma.chunk->cur_addr; // non-volatile snapshot, BS7 encoded
 
     // "The Bus Slave receives stable RDATA and RWTBT from 25 ns
     // minimum before the assertion of RCOUT until 25 ns minimum
@@ -429,6 +468,7 @@ static statemachine_state_func sm_dma_state_dout_complete() {
 // word is transfered, or timeout.
 static statemachine_state_func sm_dma_state_99() {
     uint8_t final_dma_state;
+    uint8_t cpu_access;
     // from state_12, state_21
 
     //  "The Bus Master negates TSYNC 250 nsec minimum after the
@@ -454,7 +494,7 @@ static statemachine_state_func sm_dma_state_99() {
         } else {
             final_dma_state = DMA_STATE_RUNNING; // more words:  continue
             // dataptr and words_left already updated
-            mailbox.dma.cur_addr += 2; // signal progress to ARM, next addr to output
+            sm_dma.chunk->cur_addr += 2; // signal progress to ARM, next addr to output
             if (sm_dma.block_data_state_func)
                 return sm_dma.block_data_state_func; // Next data portion in DATBI or DATBO
             buslatches_setbits(4, BIT(0)+BIT(5), 0); // negate SYNC, BS7(block indicator)
@@ -468,7 +508,10 @@ static statemachine_state_func sm_dma_state_99() {
     buslatches_setbits(6, BIT(7), 0); // negate SACK
     buslatches_setbits(4, BIT(0)+BIT(5), 0); // negate SYNC, BS7(block indicator)
 
-    mailbox.dma.cur_status = final_dma_state; // signal to ARM
+    sm_dma.chunk->cur_status = final_dma_state; // signal to ARM
+
+    // snapshot: after the event ARM may refill the chunk
+    cpu_access = sm_dma.chunk->cpu_access;
 
     // device or cpu cycle ended
     // no concurrent ARM+PRU access
@@ -477,8 +520,22 @@ static statemachine_state_func sm_dma_state_99() {
     // test for DMA_STATE_IS_COMPLETE(cur_status)
     EVENT_SIGNAL(mailbox, dma);
 
+    // next queued chunk: request bus again, ARM refills this chunk meanwhile
+    sm_dma.chunk_idx ^= 1;
+    if (--sm_dma.chunks_queued) {
+        if (final_dma_state == DMA_STATE_READY)
+            sm_dma_request(&mailbox.dma.chunk[sm_dma.chunk_idx]);
+        else {
+            // error: do not continue, but report queued chunk
+            mailbox.dma.chunk[sm_dma.chunk_idx].cur_status = DMA_STATE_CANCELED;
+            EVENT_SIGNAL(mailbox, dma);
+            sm_dma.chunk_idx ^= 1;
+            sm_dma.chunks_queued = 0;
+        }
+    }
+
     // for device DMA: qunibusadapter worker() waits for signal
-    if (!mailbox.dma.cpu_access) {
+    if (!cpu_access) {
         // signal to ARM
         // ARM is clearing this, before requesting new DMA.
         // no concurrent ARM+PRU access
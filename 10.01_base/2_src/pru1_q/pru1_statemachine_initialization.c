@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   INIT cancels queued DMA chunks
  12-nov-2020  JH      begin
 
 
@@ -45,6 +46,7 @@
 #include "pru1_utils.h"
 #include "pru1_timeouts.h"
 #include "pru1_statemachine_arbitration.h"
+#include "pru1_statemachine_dma.h"
 #include "pru1_statemachine_initialization.h"
 
 
@@ -74,6 +76,7 @@ void sm_initialization_func() {
 
     if (sm_initialization.bussignals_cur & INITIALIZATIONSIGNAL_INIT) {
         sm_arb.device_request_mask = 0 ; // INIT clears all PRIORITY request signals
+        sm_dma_cancel_queue() ; // no DMR request for queued DMA chunks anymore
         // SACK cleared later on end of DMA transaction
     }
 
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   ARM2PRU_DMA queues DMA chunks
  28-mar-2019  JH      split off from "all-function" main
  12-nov-2018  JH      entered beta phase
 
@@ -117,6 +118,8 @@ void main(void) {
 	 */
 
 	sm_arb_reset();
+	sm_dma.chunk_idx = 0; // empty DMA chunk queue
+	sm_dma.chunks_queued = 0;
 
 	while (true) {
 		uint8_t arm2pru_req_cached;
@@ -233,17 +236,10 @@ void main(void) {
 				mailbox.arm2pru_req = ARM2PRU_NONE; // ACK: done
 				break;
 			case ARM2PRU_DMA:
+				// ARM queued a chunk in mailbox.dma.chunk[].
 				// different arbitration for device and CPU memory access.
-
 				// request DMA, arbitrator must've been selected with ARM2PRU_ARB_MODE_*
-				if (mailbox.dma.cpu_access) {
-					// Emulated CPU: no NPR/NPG/SACK protocol
-					sm_arb.cpu_request = 1;
-//PRU_DEBUG_PIN0_PULSE(50) ; // CPU20 performace
-				} else {
-					// Emulated device: raise request for emulated or physical Arbitrator.
-					sm_arb.device_request_mask |= PRIORITY_ARBITRATION_BIT_NP;
-				}
+				sm_dma_queue_chunk();
 				// request not put on bus for CPU memory access
 				mailbox.arm2pru_req = ARM2PRU_NONE; // ACK: done
 				break;
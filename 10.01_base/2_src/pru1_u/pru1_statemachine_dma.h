@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   chunk queue: mailbox.dma.chunk[]
  29-jun-2019	JH		rework: state returns ptr to next state func
  12-nov-2018  JH      entered beta phase
  */
@@ -29,16 +30,22 @@
 #define  _PRU1_STATEMACHINE_DMA_H_
 
 #include "pru1_utils.h"	// statemachine_state_func
+#include "mailbox.h"
 
 // Transfers a block of worst as data cycles
 typedef struct {
 	uint8_t state_timeout; // timeout occured?
-	uint16_t *dataptr; // points to current word in mailbox.words[] ;
+	uint16_t *dataptr; // points to current word in chunk->words[] ;
 	uint16_t cur_wordsleft; // # of words left to transfer
+	volatile mailbox_dma_chunk_t *chunk; // chunk in transfer
+	uint8_t chunk_idx; // oldest queued chunk in mailbox.dma.chunk[]
+	uint8_t chunks_queued; // queued by ARM2PRU_DMA, not yet completed
 } statemachine_dma_t;
 
 extern statemachine_dma_t sm_dma;
 
+void sm_dma_queue_chunk(void);
+void sm_dma_cancel_queue(void);
 statemachine_state_func sm_dma_start(void);
 
 #endif
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   INTR complete posted to mailbox event ring
  29-jun-2019	JH		rework: state returns ptr to next state func
  12-nov-2018  JH      entered beta phase
 
@@ -82,10 +83,10 @@ static statemachine_state_func sm_intr_master_state_2() {
 		return (statemachine_state_func) &sm_intr_master_state_2; // wait
 	// received SSYN
 
-	// Complete and signal this INTR transaction only after ARM has processed the previous event.
+	// Complete and signal this INTR transaction only if the event ring has room.
 	// INTR may come faster than ARM Linux can process,
 	// especially if Arbitrator grants INTRs of multiple levels almost simultaneaously in parallel.
-	if (! EVENT_IS_ACKED(mailbox,intr_master[sm_intr_master.level_index]))
+	if (EVENT_RING_IS_FULL(mailbox))
 		return (statemachine_state_func) &sm_intr_master_state_2; // wait
 
 	// remove vector
@@ -100,14 +101,9 @@ static statemachine_state_func sm_intr_master_state_2() {
 	// device cycle ended: now CPU may become UNIBUS master again
 	// SACK already removed
 
-	// signal to ARM which INTR was completed
-	// change mailbox only after ARM has ack'ed mailbox.events.event_intr
-	// mailbox.events.intr_master.level_index = sm_intr_master.level_index;
-	EVENT_SIGNAL(mailbox,intr_master[sm_intr_master.level_index]);
-	// ARM is clearing this, before requesting new interrupt of same level
-	// so no concurrent ARP+PRU access
-	PRU2ARM_INTERRUPT
-	;
+	// signal to ARM which INTR was completed.
+	// ARM processes it before requesting new interrupt of same level
+	DO_EVENT_RING_POST(EVENT_RING_TYPE_INTR_MASTER, 0, 0, sm_intr_master.level_index, 0, 0);
 	
 
 	return NULL; // ready
@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   INIT cancels queued DMA chunks
  12-nov-2018  JH      entered beta phase
  */
 
@@ -33,6 +34,7 @@
 #include "iopageregister.h"
 #include "pru1_buslatches.h"
 #include "pru1_statemachine_arbitration.h"
+#include "pru1_statemachine_dma.h"
 #include "pru1_utils.h"
 
 
@@ -45,6 +47,7 @@ void do_event_initializationsignals() {
 	
 	if (bussignals_cur & INITIALIZATIONSIGNAL_INIT) {
 	sm_arb.device_request_mask = 0 ; // INIT clears all PRIORITY request signals
+	sm_dma_cancel_queue() ; // no NPR request for queued DMA chunks anymore
 		// SACK cleared later on end of INTR/DMA transaction
 	}
 
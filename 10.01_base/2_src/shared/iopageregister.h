@@ -22,6 +22,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED
  12-nov-2018  JH      entered Beta phase
 
  Implementation of QBUS/UNIBUS devices:
@@ -125,6 +126,8 @@
 // Bitmask: Create event for iopageregister DATI/DATO access ?
 #define IOPAGEREGISTER_EVENT_FLAG_DATI	0x01
 #define IOPAGEREGISTER_EVENT_FLAG_DATO	0x02
+// DATO event via mailbox event ring, bus cycle not halted
+#define IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED	0x04
 
 // register descriptor used by PRU for direct high-speed QBUS/UNIBUS DATI/DATO access
 typedef struct {
@@ -21,6 +21,8 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   event ring: posted DATO and INTR complete events, no bus stall
+ 16-oct-2026  agent   DMA chunk queue: 2 chunk buffers, PRU starts staged chunk itself
  12-nov-2018  JH      entered beta phase
  */
 
@@ -76,10 +78,11 @@
 
 // possible states of DMA machine
 #define DMA_STATE_READY	0        	// idle
-#define DMA_STATE_ARBITRATING	1	// in NPR/NPG/SACK arbitration
+#define DMA_STATE_ARBITRATING	1	// queued by ARM, in NPR/NPG/SACK arbitration
 #define DMA_STATE_RUNNING	2	// transfering data
 #define DMA_STATE_TIMEOUTSTOP	3	// stop because of QBUS/UNIBUS timeout
 #define DMA_STATE_INITSTOP	4	// stop because INIT signal sensed
+#define DMA_STATE_CANCELED	5	// queued chunk not executed, previous chunk failed
 
 // Bit masks BR*/NPR and BG*/NPG in buslatch 0 and 1
 // bit # is index into arbitration_request[] array.
@@ -94,8 +97,10 @@
 // CPU pririty level invalid between INTR receive and fetch of next PSW
 #define CPU_PRIORITY_LEVEL_FETCHING	0xff
 
-// data for a requested DMA operation
-#define	PRU_MAX_DMA_WORDCOUNT	(8*512)
+// data for a requested DMA operation: words per chunk buffer
+#define	PRU_MAX_DMA_WORDCOUNT	(4*512)
+// ARM may queue a 2nd chunk, while PRU transfers the 1st
+#define	PRU_DMA_CHUNK_COUNT	2
 
 #include "ddrmem.h"
 
@@ -152,10 +157,10 @@ typedef struct {
 
 } mailbox_arbitrator_t;
 
-// data for a requested DMA operation
+// data for one chunk of a requested DMA operation
 typedef struct {
 	// take care of 32 bit word borders for struct members
-	uint8_t cur_status; // 0 = idle, 1 = DMA running, 2 = timeout error
+	uint8_t cur_status; // DMA_STATE_*: queued, running, or result
 
 	uint8_t buscycle; // cycle to perform: only DATO, DATI allowed
 	uint16_t wordcount; // # of remaining words transmit/receive, static
@@ -167,6 +172,20 @@ typedef struct {
 	// if complete: last address accessed.
 	uint32_t startaddr; // address of 1st word to transfer
 	uint16_t words[PRU_MAX_DMA_WORDCOUNT]; // buffer for rcv/xmt data
+} mailbox_dma_chunk_t;
+
+/* Chunk queue:
+ ARM fills chunk[] alternately and queues each with ARM2PRU_DMA.
+ PRU executes them in the same order. After a chunk is complete, the PRU
+ signals EVENT_DMA and requests the bus for the next queued chunk
+ without waiting for the ARM.
+ If a chunk fails, a queued successor is not executed, but set to
+ DMA_STATE_CANCELED and signaled too: each queued chunk produces exactly one event.
+ A chunk queued after the failure was signaled is executed, ARM ignores its result.
+ CPU accesses are never queued behind another chunk.
+ */
+typedef struct {
+	mailbox_dma_chunk_t chunk[PRU_DMA_CHUNK_COUNT];
 } mailbox_dma_t;
 
 // data for all 4 pending INTR requests
@@ -234,18 +253,6 @@ typedef struct {
 	uint8_t _dummy2[2];
 } mailbox_event_dma_t;
 
-// INTR raised by device
-typedef struct {
-	/* Event priority arbitration INTR transfer complete
-	 After ARM2PRU_INTR, one of BR4/5/6/7 NP was requested,
-	 granted, and the deviceregister.data transfer was handled as bus master.
-	 */
-	uint8_t signaled; // PRU->ARM, one of BR/IRQ4,5,6,7 vector on QBUS/UNIBUS
-	uint8_t acked; // ARM->PRU
-	//uint8_t level_index; // 0..3 -> BR4..BR7
-	uint8_t _dummy[2];
-} mailbox_event_intr_master_t;
-
 // INTR received by CPU
 typedef struct {
 	uint8_t signaled; // PRU->ARM, one of BR4/IRQ,5,6,7 vector on QBUS/UNIBUS
@@ -267,14 +274,51 @@ typedef struct {
 	uint8_t _dummy[2];
 } mailbox_event_power_t;
 
+/* Event ring: events which need no synchronous ARM processing.
+ PRU does not stall the bus cycle until ACK, but appends a record to the ring.
+ - DATO to registers with IOPAGEREGISTER_EVENT_FLAG_DATO_POSTED
+ - INTR vector transmitted: after ARM2PRU_INTR one of BR4/5/6/7 was granted,
+   and the vector transfer was handled as bus master
+ Single writer pattern again: PRU only writes "head", ARM only writes "tail".
+ Both are rollaround-counters, index into entry[] is counter % EVENT_RING_SIZE.
+ PRU raises PRU2ARM_INTERRUPT only if the ring was empty before. Else the ARM
+ is still draining and processes the new entry in the same batch.
+ If the ring is full, a DATO is signaled as blocking deviceregister event,
+ INTR waits. ARM drains the ring before processing a blocking deviceregister event,
+ so bus order of register accesses is kept.
+ */
+#define EVENT_RING_SIZE	16	// power of 2, < 256
+#define EVENT_RING_TYPE_DEVICEREGISTER	1	// posted DATO/DATOB
+#define EVENT_RING_TYPE_INTR_MASTER	2	// INTR vector transferred
+
+typedef struct {
+	uint8_t type; // EVENT_RING_TYPE_*
+	uint8_t unibus_control; // DEVICEREGISTER: DATO,DATOB
+	uint8_t register_handle; // DEVICEREGISTER: handle of controller register
+	uint8_t level_index; // INTR_MASTER: 0..3 = BR4..BR7
+	// ---dword---
+	uint16_t data; // DEVICEREGISTER: new register value
+	uint16_t iopage_offset; // DEVICEREGISTER: address bits <12:0>, odd/even important for DATOB
+} mailbox_event_ring_entry_t;
+
+typedef struct {
+	uint8_t head; // PRU->ARM: next entry to fill
+	uint8_t tail; // ARM->PRU: next entry to process
+	uint8_t _dummy[2];
+	mailbox_event_ring_entry_t entry[EVENT_RING_SIZE];
+} mailbox_event_ring_t;
+
+#define EVENT_RING_COUNT(mailbox) ((uint8_t)((mailbox).event_ring.head - (mailbox).event_ring.tail))
+#define EVENT_RING_IS_FULL(mailbox) (EVENT_RING_COUNT(mailbox) >= EVENT_RING_SIZE)
+#define EVENT_RING_ENTRY(mailbox,counter) ((mailbox).event_ring.entry[(counter) & (EVENT_RING_SIZE-1)])
+
 typedef struct {
 	// different events can be raised asynchronically and concurrent,
 	// but a single event type is sequentially signaled by PRU and acked by ARM.
 	mailbox_event_deviceregister_t deviceregister;
 	mailbox_event_dma_t dma;
 
-	// one event for each BG4,5,6,7
-	mailbox_event_intr_master_t intr_master[4];
+	// INTR raised by device: see event ring
 
 	mailbox_event_intr_slave_t intr_slave;
 
@@ -304,6 +348,8 @@ typedef struct {
 	// set by PRU, read by ARM on event
 	mailbox_events_t events;
 
+	mailbox_event_ring_t event_ring;
+
 	mailbox_intr_t intr;
 
 	mailbox_dma_t dma;
@@ -340,6 +386,8 @@ void mailbox_print(void);
 int mailbox_connect(void);
 void mailbox_test1(void);
 bool mailbox_execute(uint8_t request);
+void mailbox_lock(void);
+void mailbox_unlock(void);
 
 #else
 // included by PRU code
@@ -361,6 +409,27 @@ extern volatile far mailbox_t mailbox;
 			/* leave SSYN asserted until mailbox.event.signal ACKEd to 0 */ \
 		} while(0)
 
+// append an entry to the event ring. Caller checked !EVENT_RING_IS_FULL()
+// Entry valid before "head" is incremented.
+#define DO_EVENT_RING_POST(_type,_unibus_control,_register_handle,_level_index,_addr,_data)	do { \
+			volatile far mailbox_event_ring_entry_t *_entry = &EVENT_RING_ENTRY(mailbox, mailbox.event_ring.head) ; \
+			_entry->type = _type ;											\
+			_entry->unibus_control = _unibus_control ;						\
+			_entry->register_handle = _register_handle ;						\
+			_entry->level_index = _level_index ;								\
+			_entry->iopage_offset = (_addr) & 0x1fff ;							\
+			_entry->data = _data ;											\
+			mailbox.event_ring.head++ ;										\
+			/* ring was empty: ARM waits for signal */						\
+			if (EVENT_RING_COUNT(mailbox) == 1)								\
+				PRU2ARM_INTERRUPT ;											\
+		} while(0)
+
+// posted DATO: bus cycle completes without waiting for ARM
+#define DO_EVENT_RING_DEVICEREGISTER(_reg,_unibus_control,_addr,_data)	\
+	DO_EVENT_RING_POST(EVENT_RING_TYPE_DEVICEREGISTER, _unibus_control, _reg->event_register_handle, 0, _addr, _data)
+
+
 
 #endif
 
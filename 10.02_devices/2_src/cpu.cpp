@@ -20,6 +20,10 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent  bus access instrumentation selected on CPU start, trace() only on DEBUG
+ 16-oct-2026  agent  worker executes instruction bursts, breakpoint via bitmap
+ 16-oct-2026  agent  predecoded instruction cache for KA11
+ oct-2026     agent  busy waits yield to virtual PRU
  16-oct-2020  JH     merged VBIT changes by github jks-prv
  23-nov-2018  JH      created
 
@@ -32,6 +36,7 @@
 
 #include "logger.hpp"
 #include "mailbox.h"
+#include "pru.hpp"
 #include "gpios.hpp"	// ARM_DEBUG_PIN*
 
 #include "qunibus.h"
@@ -91,6 +96,7 @@ void unibone_grant_interrupts(void)
     while (mailbox->arbitrator.ifs_intr_arbitration_pending) {
 // often 60-80 us, So just idle loop the CPU thread
 //		timeout_c::wait_us(1);
+        pru->busywait_yield();
     }
 }
 
@@ -107,14 +113,38 @@ void unibone_grant_interrupts(void)
 #define UNIBUS_ACCESS_NS	1000
 // "real world" time for bus access. emulated timeout is stepped by this on every cycle.
 
-int unibone_dato(unsigned addr, unsigned data) 
+// Probe policies for the bus access templates below.
+// bus_probe_none_c: plain bus cycle, compiles to nothing.
+// bus_probe_all_c: trigger probe, emulated time step, cycle trace.
+// cpu_c::bus_access_select() installs the variant when the CPU starts
+// or a trace parameter changes, so the plain path checks nothing per cycle.
+class bus_probe_none_c {
+public:
+    static inline void before(unsigned, uint8_t) { }
+    static inline void after(unsigned, uint8_t, unsigned, bool) { }
+} ;
+
+class bus_probe_all_c {
+public:
+    static inline void before(unsigned addr, uint8_t cycle) {
+        unibone_cpu->trigger.probe(addr, cycle) ; // register access for trigger system
+        the_flexi_timeout_controller->emu_step_ns(UNIBUS_ACCESS_NS);
+    }
+    // trace bus access
+    static inline void after(unsigned addr, uint8_t cycle, unsigned data, bool success) {
+        if (unibone_cpu->cycle_trace_buffer.active)
+            unibone_cpu->cycle_trace_buffer.add(qunibus_cycle_trace_entry_c(unibone_cpu->cycle_trace_entry_id++, addr >= qunibus->iopage_start_addr, addr, cycle, data, !success)) ;
+    }
+} ;
+
+template<class probe>
+static int unibone_dato_probed(unsigned addr, unsigned data) 
 {
     bool success ;
 
-    unibone_cpu->trigger.probe(addr, QUNIBUS_CYCLE_DATO) ; // register access for trigger system
+    probe::before(addr, QUNIBUS_CYCLE_DATO) ;
 
     uint16_t wordbuffer = (uint16_t) data;
-    the_flexi_timeout_controller->emu_step_ns(UNIBUS_ACCESS_NS);
     if (unibone_cpu->direct_memory.value && addr < qunibus->iopage_start_addr) {
         // Direct access Non-IOPage memory.
         ddrmem->pmi_deposit(addr, data);
@@ -128,18 +158,16 @@ int unibone_dato(unsigned addr, unsigned data)
         //printf("DATO; ba=%o, data=%o, success=%u\n", addr, data, (int)success) ;
     }
 
-    // trace bus access
-    if (unibone_cpu->cycle_trace_buffer.active)
-        unibone_cpu->cycle_trace_buffer.add(qunibus_cycle_trace_entry_c(unibone_cpu->cycle_trace_entry_id++, addr >= qunibus->iopage_start_addr, addr, QUNIBUS_CYCLE_DATO, data, !success)) ;
+    probe::after(addr, QUNIBUS_CYCLE_DATO, data, success) ;
 
     return success;
 }
 
-int unibone_datob(unsigned addr, unsigned data) 
+template<class probe>
+static int unibone_datob_probed(unsigned addr, unsigned data) 
 {
     bool success ;
-    unibone_cpu->trigger.probe(addr, QUNIBUS_CYCLE_DATO) ; // register access for trigger system
-    the_flexi_timeout_controller->emu_step_ns(UNIBUS_ACCESS_NS);
+    probe::before(addr, QUNIBUS_CYCLE_DATO) ; // trigger does not distinguish DATOB
     if (unibone_cpu->direct_memory.value && addr < qunibus->iopage_start_addr) {
         // read-modify-write
         unsigned word_address = addr & ~1; // lower even address
@@ -164,20 +192,18 @@ int unibone_datob(unsigned addr, unsigned data)
         //printf("DATOB; ba=%o, data=%o, success=%u\n", addr, data, (int)success) ;
     }
 
-    // trace bus access
-    if (unibone_cpu->cycle_trace_buffer.active)
-        unibone_cpu->cycle_trace_buffer.add(qunibus_cycle_trace_entry_c(unibone_cpu->cycle_trace_entry_id++, addr >= qunibus->iopage_start_addr, addr, QUNIBUS_CYCLE_DATOB, data, !success)) ;
+    probe::after(addr, QUNIBUS_CYCLE_DATOB, data, success) ;
 
     return success;
 }
 
-int unibone_dati(unsigned addr, unsigned *data) 
+template<class probe>
+static int unibone_dati_probed(unsigned addr, unsigned *data) 
  {
     bool success ;
     uint16_t w;
-    unibone_cpu->trigger.probe(addr, QUNIBUS_CYCLE_DATI) ; // register access for trigger system
+    probe::before(addr, QUNIBUS_CYCLE_DATI) ;
 
-    the_flexi_timeout_controller->emu_step_ns(UNIBUS_ACCESS_NS);
     if (unibone_cpu->direct_memory.value && addr < qunibus->iopage_start_addr) {
         // boot address redirection by M9312? addrs 24/26 now in M9312 IOpage
         addr |= ddrmem->pmi_address_overlay;
@@ -198,13 +224,16 @@ int unibone_dati(unsigned addr, unsigned *data)
         //printf("DATI; ba=%o, data=%o, success=%u\n", addr, *data, (int)success) ;
     }
 
-    // trace bus access
-    if (unibone_cpu->cycle_trace_buffer.active)
-        unibone_cpu->cycle_trace_buffer.add(qunibus_cycle_trace_entry_c(unibone_cpu->cycle_trace_entry_id++, addr >= qunibus->iopage_start_addr, addr, QUNIBUS_CYCLE_DATI, *data, !success)) ;
+    probe::after(addr, QUNIBUS_CYCLE_DATI, *data, success) ;
 
     return success;
 }
 
+// Entry points called by ka11.c. Until a CPU started: instrumented.
+int (*unibone_dato)(unsigned addr, unsigned data) = unibone_dato_probed<bus_probe_all_c> ;
+int (*unibone_datob)(unsigned addr, unsigned data) = unibone_datob_probed<bus_probe_all_c> ;
+int (*unibone_dati)(unsigned addr, unsigned *data) = unibone_dati_probed<bus_probe_all_c> ;
+
 // CPU has changed the arbitration level, just forward
 // if this is called as result of INTR fector PC and PSW fetch,
 // mailbox->arbitrator.cpu_priority_level was CPU_PRIORITY_LEVEL_FETCHING
@@ -261,6 +290,10 @@ cpu_c::cpu_c() :
     // must be qunibusdevice_c then!
     register_count = 0;
     swab_vbit.value = false;
+    predecode.value = true;
+
+    breakpoint.value = 0;
+    breakpoint_bitmap_update(0);
 
     memset(&bus, 0, sizeof(bus));
     memset(&ka11, 0, sizeof(ka11));
@@ -275,6 +308,7 @@ cpu_c::~cpu_c()
 {
     // restore
     the_flexi_timeout_controller->set_mode(flexi_timeout_c::world_time);
+    ka11_icache_free(&ka11);
     unibone_cpu = NULL;
 }
 
@@ -308,6 +342,9 @@ bool cpu_c::on_param_changed(parameter_c *param)
         emulation_speed.value = direct_memory.new_value ? 0.5 : 0.1 ;
     } else if (param == &cycle_tracefilepath) {
 	    cycle_trace_buffer.active = ! cycle_tracefilepath.new_value.empty() ;
+	    bus_access_select() ;
+    } else if (param == &breakpoint) {
+        breakpoint_bitmap_update(breakpoint.new_value) ;
     }
     return qunibusdevice_c::on_param_changed(param); // more actions (for enable)
 }
@@ -351,6 +388,7 @@ void cpu_c::start()
 #else
     the_flexi_timeout_controller->set_mode(flexi_timeout_c::world_time);
 #endif
+    bus_access_select() ;
     cycle_count.value = 0;
 
     // 	what if CONT while WAITING??
@@ -393,6 +431,53 @@ void cpu_c::stop(const char * info, int show_options)
 	
 }
 
+// Install plain or instrumented unibone_dati/dato/datob().
+// Instrumented only if triggers, cycle trace or emulated time need the probes.
+// May change while the CPU thread runs, then it uses either variant for a cycle.
+void cpu_c::bus_access_select(void)
+{
+    bool instrumented = trigger.is_active() || cycle_trace_buffer.active
+                        || the_flexi_timeout_controller->mode == flexi_timeout_c::emulated_time ;
+    if (instrumented) {
+        unibone_dato = unibone_dato_probed<bus_probe_all_c> ;
+        unibone_datob = unibone_datob_probed<bus_probe_all_c> ;
+        unibone_dati = unibone_dati_probed<bus_probe_all_c> ;
+    } else {
+        unibone_dato = unibone_dato_probed<bus_probe_none_c> ;
+        unibone_datob = unibone_datob_probed<bus_probe_none_c> ;
+        unibone_dati = unibone_dati_probed<bus_probe_none_c> ;
+    }
+}
+
+// set breakpoint. 0 = none
+void cpu_c::breakpoint_bitmap_update(unsigned addr)
+{
+    memset(breakpoint_bitmap, 0, sizeof(breakpoint_bitmap)) ;
+    if (addr)
+        breakpoint_bitmap[(addr & 0xffff) >> 3] |= 1 << (addr & 7) ;
+}
+
+// Execute instructions until the CPU leaves RUNNING state,
+// a breakpoint or trigger is hit, switches or power events need worker(),
+// or burst_instructions are done.
+// Interrupts are taken inside the burst by ka11_condstep(), as before.
+// result: instructions executed, which left the CPU RUNNING
+unsigned cpu_c::execute_burst(void)
+{
+    unsigned count = 0;
+    ka11_condstep(&ka11); // may also wake up a WAITING CPU
+    while (ka11.state == KA11_STATE_RUNNING) {
+        count++;
+        if (count >= burst_instructions || breakpoint_at(ka11.r[7])
+                || trigger.has_triggered() || halt_switch.value
+                || power_event_ACLO_active || power_event_DCLO_active
+                || power_event_ACLO_inactive)
+            break;
+        ka11_condstep(&ka11);
+    }
+    return count;
+}
+
 // background worker.
 // Started/stopped on param "enable"
 void cpu_c::worker(unsigned instance) 
@@ -432,6 +517,8 @@ void cpu_c::worker(unsigned instance)
         continue_switch.value = false; // momentary action
 
         ka11.sw = swreg.value & 0xffff;
+        ka11.predecode = (predecode.value == true);
+        ka11.trace = (verbosity.value >= LL_DEBUG);
 
         if (!runmode.value && start_switch.value) {
             // START, or HALT+START: reset system
@@ -448,20 +535,19 @@ void cpu_c::worker(unsigned instance)
 
         int prev_ka11_state = ka11.state;
         // ARM_DEBUG_PIN(0,1) ; // measure pmi gain
-        ka11_condstep(&ka11);
+        unsigned burst_count = execute_burst();
         // ARM_DEBUG_PIN(0,0) ;
         if (ka11.state != KA11_STATE_HALTED && trigger.has_triggered()) {
             stop("Halted by trigger conditions:", show_pc+show_trigger+show_state+show_cycletrace);
-        } else  if (breakpoint.value && ka11.state != KA11_STATE_HALTED && breakpoint.value == ka11.r[7]) {
+        } else  if (ka11.state != KA11_STATE_HALTED && breakpoint_at(ka11.r[7])) {
             stop("CPU HALT by breakpoint", show_pc+show_state+show_cycletrace);
         } else  if (prev_ka11_state > 0 && ka11.state == KA11_STATE_HALTED) {
             // CPU run on HALT, sync runmode
             stop("CPU HALT by opcode", show_pc+show_state+show_cycletrace);
         }
         // running CPU: produce emulated time for all devices
-        if (ka11.state == KA11_STATE_RUNNING) {
-            cycle_count.value++;
-        } else if (ka11.state == KA11_STATE_WAITING)
+        cycle_count.value += burst_count;
+        if (ka11.state == KA11_STATE_WAITING)
             // we should us "world" time here, but want to avoid permanent time-source switching
             // so just assume this here is called every 500ns (estimated average worker loop time)
             the_flexi_timeout_controller->emu_step_ns(500);
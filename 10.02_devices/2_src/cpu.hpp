@@ -21,6 +21,9 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   bus_access_select()
+ 16-oct-2026  agent   burst execution, breakpoint bitmap
+ 16-oct-2026  agent   param "predecode"
  23-nov-2018  JH      created
  */
 #ifndef _CPU_HPP_
@@ -121,6 +124,20 @@ private:
 	static const int show_state = 4 ;
 	static const int show_cycletrace = 8 ;
 
+	// max instructions executed by worker() between housekeeping
+	static const unsigned burst_instructions = 1000 ;
+
+	// bit set for each opcode fetch address with a breakpoint
+	uint8_t breakpoint_bitmap[0x10000 / 8] ;
+	void breakpoint_bitmap_update(unsigned addr) ;
+	bool breakpoint_at(uint16_t addr) {
+		return breakpoint_bitmap[addr >> 3] & (1 << (addr & 7)) ;
+	}
+	unsigned execute_burst(void) ;
+
+	// install plain or instrumented unibone_dati/dato/datob()
+	void bus_access_select(void) ;
+
 public:
 
     cpu_c();
@@ -146,6 +163,9 @@ public:
     parameter_bool_c direct_memory = parameter_bool_c(this, "pmi", "pmi",/*readonly*/
                                      false, "Private Memory Interconnect: CPU accesses memory internally, not over UNIBUS.");
 
+    parameter_bool_c predecode = parameter_bool_c(this, "predecode", "pdc",/*readonly*/
+                                 false, "Execute from predecoded instruction cache(=1) or with reference decoder(=0)");
+
     parameter_bool_c swab_vbit = parameter_bool_c(this, "swab_vbit", "swab",/*readonly*/
                                  false, "SWAB instruction does not(=0) or does(=1) modify psw v-bit (=0 is standard 11/20 behavior)");
 
@@ -4,13 +4,16 @@
 #include "gpios.hpp" // ARM_DEBUG_PIN*
 
 void unibone_grant_interrupts(void) ;
-int unibone_dato(unsigned addr, unsigned data);
-int unibone_datob(unsigned addr, unsigned data);
-int unibone_dati(unsigned addr, unsigned *data);
+// bus access path, instrumented or plain. Selected by cpu_c::bus_access_select()
+extern int (*unibone_dato)(unsigned addr, unsigned data);
+extern int (*unibone_datob)(unsigned addr, unsigned data);
+extern int (*unibone_dati)(unsigned addr, unsigned *data);
 void unibone_prioritylevelchange(uint8_t level);
 void unibone_bus_init() ;
 
 bool unibone_trace_addr(uint16_t a) ;
+// trace() only with CPU log level DEBUG, and for addresses selected by tracer
+#define TRACE_ADDR(a)	(cpu->trace && unibone_trace_addr(a))
 
 
 int
@@ -157,7 +160,7 @@ dati(KA11 *cpu, int b)
 	if(dati_bus(cpu->bus))
 		goto be;
 ok:
-if (unibone_trace_addr(cpu->ba))
+if (TRACE_ADDR(cpu->ba))
  	trace("DATI [%06o] => %06o\n", cpu->ba, cpu->bus->data);
 	cpu->be = 0;
 	return 0;
@@ -170,7 +173,7 @@ be:
 int
 dato(KA11 *cpu, int b)
 {
-if (unibone_trace_addr(cpu->ba)) // default: all
+if (TRACE_ADDR(cpu->ba)) // default: all
 trace("%s [%06o] <= %06o\n", b? "DATOB":"DATO", cpu->ba, cpu->bus->data);
 	if(!b && cpu->ba&1)
 		goto be;
@@ -316,6 +319,19 @@ setnz(KA11 *cpu, word w)
 	if(w == 0) cpu->psw |= PSW_Z;
 }
 
+/* how an instruction ended, for step_complete() */
+enum {
+	EXEC_SVC,	// service traps and interrupts
+	EXEC_TRAP,	// trap through vector TV
+	EXEC_BE,	// bus error
+	EXEC_RI,	// reserved instruction
+	EXEC_ILL,	// illegal instruction
+	EXEC_DONE	// HALT, WAIT: no service
+};
+
+static void step_complete(KA11 *cpu, int exec, byte oldpsw);
+
+/* Reference implementation: decode and execute. */
 void
 step(KA11 *cpu)
 {
@@ -326,7 +342,7 @@ step(KA11 *cpu)
 	uint src, dst, sf, df, sm, dm;
 	word mask, sign;
 	int inhov;
-	byte oldpsw;
+	byte oldpsw = cpu->psw;
 
 //	printf("fetch from %06o\n", cpu->r[7]);
 //	printstate(cpu);
@@ -368,8 +384,8 @@ step(KA11 *cpu)
 #define OUT(a,d)	cpu->ba = (a); cpu->bus->data = (d); if(dato(cpu, 0)) goto be
 #define IN(d)	if(dati(cpu, 0)) goto be; d = cpu->bus->data
 #define INA(a,d)	cpu->ba = a; if(dati(cpu, 0)) goto be; d = cpu->bus->data
-#define TR(m)	if (unibone_trace_addr(PC-2)) trace("EXEC [%06o] "#m"\n", PC-2)
-#define TRB(m)	if (unibone_trace_addr(PC-2)) trace("EXEC [%06o] "#m"%s\n", PC-2, by ? "B" : "")
+#define TR(m)	if (TRACE_ADDR(PC-2)) trace("EXEC [%06o] "#m"\n", PC-2)
+#define TRB(m)	if (TRACE_ADDR(PC-2)) trace("EXEC [%06o] "#m"%s\n", PC-2, by ? "B" : "")
 //#define TR(m)	trace("EXEC [%06o] "#m"\n", PC-2)
 //#define TRB(m)	trace("EXEC [%06o] "#m"%s\n", PC-2, by ? "B" : "")
 
@@ -595,6 +611,36 @@ step(KA11 *cpu)
 
 	// All other instructions should be reserved now
 
+ri:	step_complete(cpu, EXEC_RI, oldpsw);
+	return;
+ill:	step_complete(cpu, EXEC_ILL, oldpsw);
+	return;
+be:	step_complete(cpu, EXEC_BE, oldpsw);
+	return;
+trap:	step_complete(cpu, EXEC_TRAP, oldpsw);
+	return;
+service:
+	step_complete(cpu, EXEC_SVC, oldpsw);
+}
+
+/* Trap and service sequence after an instruction, shared by
+ * step() and step_predecoded() */
+static void
+step_complete(KA11 *cpu, int exec, byte oldpsw)
+{
+	uint c;
+	int inhov;
+
+	inhov = 0;
+	switch(exec){
+	case EXEC_SVC:	goto service;
+	case EXEC_TRAP:	goto trap;
+	case EXEC_BE:	goto be;
+	case EXEC_RI:	goto ri;
+	case EXEC_ILL:	goto ill;
+	default:	return;
+	}
+
 ri:	TRAP(010);
 ill:	TRAP(4);
 be:	if(cpu->be > 1){
@@ -607,7 +653,7 @@ be:	if(cpu->be > 1){
 	TRAP(4);
 
 trap:
-	if (unibone_trace_addr(PC-2)) 
+	if (TRACE_ADDR(PC-2)) 
 	trace("TRAP %o\n", TV);
 	PUSH; OUT(SP, PSW);
 	PUSH; OUT(SP, PC);
@@ -617,7 +663,7 @@ trap:
 	/* no trace trap after a trap */
 	oldpsw = PSW;
 
-	if (unibone_trace_addr(PC-2)) 
+	if (TRACE_ADDR(PC-2)) 
 	ka11_tracestate(cpu);
 	return;		// TODO: is this correct?
 //	SVC;
@@ -652,6 +698,500 @@ service:
 		return;
 }
 
+/*
+ * Predecoded instruction cache.
+ * An instruction word is decoded once into a handler with operand specifiers
+ * and register modes resolved. Entries are tagged with the opcode they were
+ * decoded from: the opcode fetch is still a bus cycle, so code changed by
+ * CPU DATO or by device DMA is decoded again. IO page (ROM) is not cached.
+ * Semantics must be kept identical to step(). Verify changes with the
+ * MAINDEC ZKAA..ZKAM diagnostics, see "diag" in the device menu.
+ */
+
+#define ICACHE_END	0160000	// first address not cached
+#define ICACHE_SIZE	(ICACHE_END/2)
+
+typedef int (*ka11_exec_t)(KA11 *cpu, const KA11_decoded *d);
+
+struct KA11_decoded
+{
+	ka11_exec_t exec;	// nil: not decoded
+	word ir;	// tag: opcode decoded
+	word br;	// branch offset
+	word arg;	// branch condition mask, trap vector, condition code bits
+	byte by;	// byte instruction
+	byte src, dst;	// operand specifiers
+};
+
+/* handlers leave with an EXEC_* code instead of goto */
+#undef SVC
+#undef TRAP
+#undef RD_B
+#undef RD_U
+#undef WR
+#undef PUSH
+#undef OUT
+#undef IN
+#define SVC	return EXEC_SVC
+#define TRAP(v)	TV = v; return EXEC_TRAP
+#define BE	return EXEC_BE
+#define RD_B	if(sm != 0) if(readop(cpu, 010, src, by)) BE;\
+		if(dm != 0) if(readop(cpu, 011, dst, by)) BE;\
+		if(sm == 0) fetchop(cpu, 010, src, by);\
+		if(dm == 0) fetchop(cpu, 011, dst, by)
+#define RD_RR	SR = cpu->r[sf]; DR = cpu->r[df];\
+		if(by) { SR = sxt(SR); DR = sxt(DR); }
+#define RD_U	if(dm != 0) if(readop(cpu, 011, dst, by)) BE;\
+		if(dm == 0) fetchop(cpu, 011, dst, by);\
+		SR = DR
+#define RD_R	DR = cpu->r[df]; if(by) DR = sxt(DR);\
+		SR = DR
+#define WR	if(writedest(cpu, b, by)) BE
+#define PUSH	SP -= 2; if((SP&~0377) == 0) cpu->traps |= TRAP_STACK
+#define OUT(a,d)	cpu->ba = (a); cpu->bus->data = (d); if(dato(cpu, 0)) BE
+#define IN(d)	if(dati(cpu, 0)) BE; d = cpu->bus->data
+
+#define OPERANDS	uint by = d->by;\
+	uint src = d->src, sm = src>>3, sf = src&7;\
+	uint dst = d->dst, dm = dst>>3, df = dst&7;\
+	uint b;\
+	(void)src; (void)sm; (void)sf; (void)dst; (void)dm; (void)df
+
+/* double operand: generic, and both operands registers */
+#define EXEC_BINARY(name, ...)	\
+static int exec_##name(KA11 *cpu, const KA11_decoded *d)	\
+{ OPERANDS; RD_B; __VA_ARGS__ }	\
+static int exec_##name##_rr(KA11 *cpu, const KA11_decoded *d)	\
+{ OPERANDS; RD_RR; __VA_ARGS__ }
+
+/* single operand: generic, and register */
+#define EXEC_UNARY(name, ...)	\
+static int exec_##name(KA11 *cpu, const KA11_decoded *d)	\
+{ OPERANDS; word mask = by ? M8 : M16, sign = by ? B7 : B15; uint c;	\
+  (void)mask; (void)sign; (void)c; RD_U; __VA_ARGS__ }	\
+static int exec_##name##_r(KA11 *cpu, const KA11_decoded *d)	\
+{ OPERANDS; word mask = by ? M8 : M16, sign = by ? B7 : B15; uint c;	\
+  (void)mask; (void)sign; (void)c; RD_R; __VA_ARGS__ }
+
+EXEC_BINARY(mov, TRB(MOV);
+	CLV;
+	b = SR; NZ;
+	if(dm==0) cpu->r[df] = SR;
+	else writedest(cpu, SR, by);
+	SVC;)
+EXEC_BINARY(cmp, TRB(CMP);
+	CLCV;
+	b = SR + W(~DR) + 1; NC; BXT;
+	if(sgn((SR ^ DR) & ~(DR ^ b))) SEV;
+	NZ; SVC;)
+EXEC_BINARY(bit, TRB(BIT);
+	CLV;
+	b = DR & SR;
+	NZ; SVC;)
+EXEC_BINARY(bic, TRB(BIC);
+	CLV;
+	b = DR & ~SR;
+	NZ; WR; SVC;)
+EXEC_BINARY(bis, TRB(BIS);
+	CLV;
+	b = DR | SR;
+	NZ; WR; SVC;)
+EXEC_BINARY(add, TR(ADD);
+	CLCV;
+	b = SR + DR; C;
+	if(sgn(~(SR ^ DR) & (DR ^ b))) SEV;
+	NZ; WR; SVC;)
+EXEC_BINARY(sub, TR(SUB);
+	CLCV;
+	b = DR + W(~SR) + 1; NC;
+	if(sgn((SR ^ DR) & (DR ^ b))) SEV;
+	NZ; WR; SVC;)
+
+EXEC_UNARY(clr, TRB(CLR);
+	CLCV;
+	b = 0;
+	NZ; WR; SVC;)
+EXEC_UNARY(com, TRB(COM);
+	CLV; SEC;
+	b = W(~SR);
+	NZ; WR; SVC;)
+EXEC_UNARY(inc, TRB(INC);
+	CLV;
+	b = W(SR+1); BXT;
+	if(sgn(~SR&b)) SEV;
+	NZ; WR; SVC;)
+EXEC_UNARY(dec, TRB(DEC);
+	CLV;
+	b = W(SR+~0); BXT;
+	if(sgn(SR&~b)) SEV;
+	NZ; WR; SVC;)
+EXEC_UNARY(neg, TRB(NEG);
+	CLCV;
+	b = W(~SR+1); BXT; if(b) SEC;
+	if(sgn(b&SR)) SEV;
+	NZ; WR; SVC;)
+EXEC_UNARY(adc, TRB(ADC);
+	c = ISSET(PSW_C); CLCV;
+	b = SR + c; C; BXT;
+	if(sgn(~SR&b)) SEV;
+	NZ; WR; SVC;)
+EXEC_UNARY(sbc, TRB(SBC);
+	c = !ISSET(PSW_C)-1; CLCV;
+	b = W(SR+c); if(c && SR == 0) SEC; BXT;
+	if(sgn(SR&~b)) SEV;
+	NZ; WR; SVC;)
+EXEC_UNARY(tst, TRB(TST);
+	CLCV;
+	b = SR;
+	NZ; SVC;)
+EXEC_UNARY(ror, TRB(ROR);
+	c = ISSET(PSW_C); CLCV;
+	b = (SR&mask) >> 1; if(c) b |= sign; if(SR & 1) SEC; BXT;
+	NZ; if((PSW>>3^PSW)&1) SEV;
+	WR; SVC;)
+EXEC_UNARY(rol, TRB(ROL);
+	c = ISSET(PSW_C); CLCV;
+	b = (SR<<1) & mask; if(c) b |= 1; if(SR & B15) SEC; BXT;
+	NZ; if((PSW>>3^PSW)&1) SEV;
+	WR; SVC;)
+EXEC_UNARY(asr, TRB(ASR);
+	CLCV;
+	b = W(SR>>1) | (SR & B15); if(SR & 1) SEC; BXT;
+	NZ; if((PSW>>3^PSW)&1) SEV;
+	WR; SVC;)
+EXEC_UNARY(asl, TRB(ASL);
+	CLCV;
+	b = W(SR<<1); if(SR & B15) SEC; BXT;
+	NZ; if((PSW>>3^PSW)&1) SEV;
+	WR; SVC;)
+EXEC_UNARY(swab, TR(SWAB);
+	if(cpu->swab_vbit) {
+	    CLCV;   // v-bit cleared, ZQKC compatible
+	} else {
+	    CLC;    // v-bit unchanged, actual 11/20 behavior
+	}
+	b = WD(DR & 0377, (DR>>8) & 0377);
+	CLNZ; if(b & B7) SEN; if((b & M8) == 0) SEZ;
+	WR; SVC;)
+
+static int
+exec_jsr(KA11 *cpu, const KA11_decoded *d)
+{
+	uint sf = d->src & 7;
+	TR(JSR);
+	if(addrop(cpu, d->dst, 0)) BE;
+	DR = cpu->b;
+	PUSH; OUT(SP, cpu->r[sf]);
+	cpu->r[sf] = PC; PC = DR;
+	SVC;
+}
+
+static int
+exec_jmp(KA11 *cpu, const KA11_decoded *d)
+{
+	TR(JMP);
+	if(addrop(cpu, d->dst, 0)) BE;
+	PC = cpu->b;
+	SVC;
+}
+
+static int
+exec_rts(KA11 *cpu, const KA11_decoded *d)
+{
+	uint df = d->dst & 7;
+	TR(RTS);
+	BA = SP; POP;
+	PC = cpu->r[df];
+	IN(cpu->r[df]);
+	SVC;
+}
+
+static int
+exec_br(KA11 *cpu, const KA11_decoded *d)
+{
+	TR(BR);
+	PC += d->br;
+	SVC;
+}
+
+static const char *branch_name(word cond);
+
+static int
+exec_cbr(KA11 *cpu, const KA11_decoded *d)
+{
+	if (TRACE_ADDR(PC-2))
+		trace("EXEC [%06o] %s\n", PC-2, branch_name(d->arg));
+	if((d->arg>>(cpu->psw&017)) & 1) PC += d->br;
+	SVC;
+}
+
+static int
+exec_ccc(KA11 *cpu, const KA11_decoded *d)
+{
+	TR(CCC);
+	PSW &= ~d->arg;
+	SVC;
+}
+
+static int
+exec_sec(KA11 *cpu, const KA11_decoded *d)
+{
+	TR(SEC);
+	PSW |= d->arg;
+	SVC;
+}
+
+#define EXEC_TRAPOP(name, vec)	\
+static int exec_##name(KA11 *cpu, const KA11_decoded *d)	\
+{ (void)d; TR(name); TRAP(vec); }
+
+EXEC_TRAPOP(EMT, 030)
+EXEC_TRAPOP(TRAP, 034)
+EXEC_TRAPOP(BPT, 014)
+EXEC_TRAPOP(IOT, 020)
+
+static int
+exec_halt(KA11 *cpu, const KA11_decoded *d)
+{
+	(void)d;
+	TR(HALT);
+	cpu->state = KA11_STATE_HALTED;
+	return EXEC_DONE;
+}
+
+static int
+exec_wait(KA11 *cpu, const KA11_decoded *d)
+{
+	(void)d;
+	TR(WAIT);
+	cpu->state = KA11_STATE_WAITING;
+	return EXEC_DONE; // no traps
+}
+
+static int
+exec_rti(KA11 *cpu, const KA11_decoded *d)
+{
+	(void)d;
+	TR(RTI);
+	BA = SP; POP; IN(PC);
+	BA = SP; POP; IN(PSW);
+	levelchange(cpu->psw) ;
+	SVC;
+}
+
+static int
+exec_reset(KA11 *cpu, const KA11_decoded *d)
+{
+	(void)d;
+	TR(RESET);
+	ka11_reset(cpu);
+	unibone_bus_init() ;
+	SVC;
+}
+
+static int
+exec_ri(KA11 *cpu, const KA11_decoded *d)
+{
+	(void)cpu; (void)d;
+	return EXEC_RI;
+}
+
+static int
+exec_ill(KA11 *cpu, const KA11_decoded *d)
+{
+	(void)cpu; (void)d;
+	return EXEC_ILL;
+}
+
+/* branch conditions, see CBR() in step() */
+static const struct {
+	word op;
+	word cond;
+	const char *name;
+} branches[] = {
+	{ 0001000, 0x0F0F, "BNE" }, { 0001400, 0xF0F0, "BEQ" },
+	{ 0002000, 0xCC33, "BGE" }, { 0002400, 0x33CC, "BLT" },
+	{ 0003000, 0x0C03, "BGT" }, { 0003400, 0xF3FC, "BLE" },
+	{ 0100000, 0x00FF, "BPL" }, { 0100400, 0xFF00, "BMI" },
+	{ 0101000, 0x0505, "BHI" }, { 0101400, 0xFAFA, "BLOS" },
+	{ 0102000, 0x3333, "BVC" }, { 0102400, 0xCCCC, "BVS" },
+	{ 0103000, 0x5555, "BCC" }, { 0103400, 0xAAAA, "BCS" },
+};
+
+static const char *
+branch_name(word cond)
+{
+	uint i;
+	for(i = 0; i < sizeof(branches)/sizeof(branches[0]); i++)
+		if(branches[i].cond == cond)
+			return branches[i].name;
+	return "?";
+}
+
+/* Same case structure as step() */
+static void
+decode(word ir, KA11_decoded *d)
+{
+	uint i;
+	uint sm, dm;
+	int rr;
+
+	d->ir = ir;
+	d->by = !!(ir&B15);
+	d->br = sxt(ir)<<1;
+	d->arg = 0;
+	d->src = ir>>6 & 077;
+	d->dst = ir & 077;
+	sm = d->src>>3 & 7;
+	dm = d->dst>>3 & 7;
+	rr = sm == 0 && dm == 0;
+
+	/* Binary */
+	switch(ir & 0170000){
+	case 0110000: case 0010000:
+		d->exec = rr ? exec_mov_rr : exec_mov; return;
+	case 0120000: case 0020000:
+		d->exec = rr ? exec_cmp_rr : exec_cmp; return;
+	case 0130000: case 0030000:
+		d->exec = rr ? exec_bit_rr : exec_bit; return;
+	case 0140000: case 0040000:
+		d->exec = rr ? exec_bic_rr : exec_bic; return;
+	case 0150000: case 0050000:
+		d->exec = rr ? exec_bis_rr : exec_bis; return;
+	case 0060000:
+		d->by = 0;
+		d->exec = rr ? exec_add_rr : exec_add; return;
+	case 0160000:
+		d->by = 0;
+		d->exec = rr ? exec_sub_rr : exec_sub; return;
+	case 0170000: case 0070000:
+		d->exec = exec_ri; return;
+	}
+
+	/* Unary */
+#define UNARY(name)	d->exec = dm == 0 ? exec_##name##_r : exec_##name; return
+	switch(ir & 0007700){
+	case 0005000:	UNARY(clr);
+	case 0005100:	UNARY(com);
+	case 0005200:	UNARY(inc);
+	case 0005300:	UNARY(dec);
+	case 0005400:	UNARY(neg);
+	case 0005500:	UNARY(adc);
+	case 0005600:	UNARY(sbc);
+	case 0005700:	UNARY(tst);
+	case 0006000:	UNARY(ror);
+	case 0006100:	UNARY(rol);
+	case 0006200:	UNARY(asr);
+	case 0006300:	UNARY(asl);
+	case 0006400:
+	case 0006500:
+	case 0006600:
+	case 0006700:
+		d->exec = exec_ri; return;
+	}
+
+	switch(ir & 0107400){
+	case 0004000:
+	case 0004400:
+		d->exec = dm == 0 ? exec_ill : exec_jsr; return;
+	case 0104000:	d->exec = exec_EMT; return;
+	case 0104400:	d->exec = exec_TRAP; return;
+	}
+
+	/* Branches */
+	if((ir & 074000) == 0 && (ir & 0103400) != 0) {
+		if((ir & 0103400) == 0000400){
+			d->exec = exec_br; return;
+		}
+		for(i = 0; i < sizeof(branches)/sizeof(branches[0]); i++)
+			if((ir & 0103400) == branches[i].op){
+				d->arg = branches[i].cond;
+				d->exec = exec_cbr; return;
+			}
+	}
+
+	/* Misc */
+	switch(ir & 0777300){
+	case 0100:
+		d->exec = dm == 0 ? exec_ill : exec_jmp; return;
+	case 0200:
+		switch(ir&070){
+		case 000:	d->exec = exec_rts; return;
+		case 010: case 020: case 030:
+			d->exec = exec_ri; return;
+		case 040: case 050:	d->arg = ir&017; d->exec = exec_ccc; return;
+		case 060: case 070:	d->arg = ir&017; d->exec = exec_sec; return;
+		}
+		break;
+	case 0300:
+		d->by = 0;
+		UNARY(swab);
+	}
+#undef UNARY
+
+	/* Operate */
+	switch(ir){
+	case 0:	d->exec = exec_halt; return;
+	case 1:	d->exec = exec_wait; return;
+	case 2:	d->exec = exec_rti; return;
+	case 3:	d->exec = exec_BPT; return;
+	case 4:	d->exec = exec_IOT; return;
+	case 5:	d->exec = exec_reset; return;
+	}
+
+	// All other instructions should be reserved now
+	d->exec = exec_ri;
+}
+
+/* step() with decoding from instruction cache */
+static void
+step_predecoded(KA11 *cpu)
+{
+	KA11_decoded *d, tmp;
+	byte oldpsw = cpu->psw;
+	word fetch_addr;
+
+	{
+		// external interrupt from parallel threads?
+		pthread_mutex_lock(&cpu->mutex) ;
+		bool external_intr = cpu->external_intr ;
+		word external_intrvec = cpu->external_intrvec ;
+		cpu->external_intr = 0 ;
+		pthread_mutex_unlock(&cpu->mutex) ;
+		if (external_intr){
+			cpu->state = KA11_STATE_RUNNING ;
+			TV = external_intrvec;
+			step_complete(cpu, EXEC_TRAP, oldpsw);
+			return;
+		}
+	}
+
+	fetch_addr = PC;
+	BA = fetch_addr;
+	if(dati(cpu, 0)){
+		step_complete(cpu, EXEC_BE, oldpsw);
+		return;
+	}
+	cpu->ir = cpu->bus->data;
+	PC += 2;	/* don't increment on bus error! */
+
+	if(fetch_addr < ICACHE_END){
+		d = &cpu->icache[fetch_addr >> 1];
+		if(d->exec == nil || d->ir != cpu->ir)
+			decode(cpu->ir, d);
+	}else{
+		d = &tmp;
+		decode(cpu->ir, d);
+	}
+	step_complete(cpu, d->exec(cpu, d), oldpsw);
+}
+
+void
+ka11_icache_free(KA11 *cpu)
+{
+	free(cpu->icache);
+	cpu->icache = nil;
+}
 // to be called from parallel threads to signal async intr
 // (unibusadapter worker thread)
 void
@@ -703,7 +1243,12 @@ ka11_condstep(KA11 *cpu)
 		// external_intr WAIT handled atomically in ka11_setintr() !
 
 		svc(cpu, cpu->bus);
-		step(cpu);
+		if(cpu->predecode && cpu->icache == nil)
+			cpu->icache = (KA11_decoded *)calloc(ICACHE_SIZE, sizeof(KA11_decoded));
+		if(cpu->predecode && cpu->icache != nil)
+			step_predecoded(cpu);
+		else
+			step(cpu);
 	}
 }
 
@@ -8,6 +8,7 @@ enum {
 
 
 typedef struct KA11 KA11;
+typedef struct KA11_decoded KA11_decoded;
 struct KA11
 {
 	word r[16];
@@ -32,6 +33,14 @@ struct KA11
 
 	word sw;
 	int swab_vbit;
+
+	// predecoded instruction cache, indexed by PC/2 below the IO page.
+	// allocated on first use. predecode = 0: only reference step()
+	int predecode;
+	KA11_decoded *icache;
+
+	// trace() of bus cycles and EXEC. Set from CPU log level, 0 = no calls
+	int trace;
 };
 
 
@@ -42,4 +51,5 @@ void ka11_setintr(KA11 *cpu, unsigned vec);
 void ka11_pwrfail_trap(KA11 *cpu);
 void ka11_pwrup_vector_fetch(KA11 *cpu);
 void ka11_condstep(KA11 *cpu);
+void ka11_icache_free(KA11 *cpu);
 
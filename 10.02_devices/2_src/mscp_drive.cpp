@@ -209,6 +209,72 @@ uint8_t* mscp_drive_c::Read(uint32_t blockNumber, size_t lengthInBytes)
     return buffer;
 }
 
+//
+// Queues a write of the specified number of bytes from the provided buffer,
+// starting at the specified logical block.  Buffer must stay valid until
+// the request is complete.  The remainder of the last block is cleared
+// by a second request, with its own completion.
+//
+void mscp_drive_c::WriteAsync(storagedrive_io_request_c* request, uint32_t blockNumber, size_t lengthInBytes, uint8_t* buffer)
+{
+    image_write_async(request, buffer, blockNumber * GetBlockSize(), lengthInBytes);
+
+    unsigned remainder = lengthInBytes % GetBlockSize();
+    if (remainder > 0)
+    {
+        storagedrive_io_request_c* clearRequest = new storagedrive_io_request_c();
+        clearRequest->on_complete = [](storagedrive_io_request_c* r) { delete r; };
+        assert(sizeof(zeros) >= GetBlockSize() - remainder);
+        image_write_async(clearRequest, zeros, blockNumber * GetBlockSize() + lengthInBytes,
+            GetBlockSize() - remainder);
+    }
+}
+
+//
+// Queues a read of the specifed number of bytes starting at the specified
+// logical block into the provided buffer.
+//
+void mscp_drive_c::ReadAsync(storagedrive_io_request_c* request, uint32_t blockNumber, size_t lengthInBytes, uint8_t* buffer)
+{
+    image_read_async(request, buffer, blockNumber * GetBlockSize(), lengthInBytes);
+}
+
+//
+// Returns a pointer to the image data of the specified number of bytes
+// starting at the specified logical block, if the image is held in memory
+// (memory mapped images).  Else nullptr is returned and the data has to be
+// accessed with Read()/Write().  For writing, the image must be writable.
+// The image is not closed or changed until the access is ended with
+// UnmapBlocks() or MappedBlocksWritten().
+//
+uint8_t* mscp_drive_c::MapBlocks(uint32_t blockNumber, size_t lengthInBytes, bool write)
+{
+    if (write && image_is_readonly())
+    {
+        return nullptr;
+    }
+    return image_block_ptr(blockNumber * GetBlockSize(), lengthInBytes);
+}
+
+//
+// Ends an access through MapBlocks() without changes.
+//
+void mscp_drive_c::UnmapBlocks(void)
+{
+    image_block_ptr_release();
+}
+
+//
+// Completes a write through MapBlocks(): syncs the image as configured,
+// and clears the remainder of the last block, as Write() does.
+// This ends the access, the image is then accessed by Write().
+//
+void mscp_drive_c::MappedBlocksWritten(uint32_t blockNumber, size_t lengthInBytes)
+{
+    image_block_ptr_written(blockNumber * GetBlockSize(), lengthInBytes);
+    image_clear_remaining_block_bytes(GetBlockSize(), blockNumber * GetBlockSize(), lengthInBytes);
+}
+
 //
 // Writes a single block's worth of data from the provided buffer into the
 // RCT area at the specified RCT block.  Buffer must be at least as large
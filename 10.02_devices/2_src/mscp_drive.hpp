@@ -42,6 +42,19 @@ public:
 
     uint8_t* Read(uint32_t blockNumber, size_t lengthInBytes);
 
+    // Executed by the storage I/O threads, see storagedrive_io.hpp
+    void WriteAsync(storagedrive_io_request_c* request, uint32_t blockNumber, size_t lengthInBytes, uint8_t* buffer);
+
+    void ReadAsync(storagedrive_io_request_c* request, uint32_t blockNumber, size_t lengthInBytes, uint8_t* buffer);
+
+    // Direct access to image memory, nullptr if the image does not support it.
+    // End the access with UnmapBlocks(), or after writing with MappedBlocksWritten().
+    uint8_t* MapBlocks(uint32_t blockNumber, size_t lengthInBytes, bool write);
+
+    void UnmapBlocks(void);
+
+    void MappedBlocksWritten(uint32_t blockNumber, size_t lengthInBytes);
+
     void WriteRCTBlock(uint32_t rctBlockNumber, uint8_t* buffer);
 
     uint8_t* ReadRCTBlock(uint32_t rctBlockNumber);
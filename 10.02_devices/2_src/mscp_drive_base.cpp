@@ -25,6 +25,7 @@
 mscp_drive_base_c::mscp_drive_base_c(storagecontroller_c *_controller, uint32_t _driveNumber) :
     storagedrive_c(_controller)
 {
+    UNUSED(_driveNumber); // unit numbers set by derived drives
     set_workers_count(0) ; // needs no worker()    
     SetOffline();    
 }
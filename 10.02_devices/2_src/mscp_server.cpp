@@ -10,20 +10,18 @@
     the side of implementation simplicity.
 
     In particular:
-         All commands are executed sequentially, as they appear in the
-         command ring.  This includes any commands in the "Immediate"
-         category.  Technically this is incorrect:  Immediate commands
-         should execute as soon as possible, before any other commands.
-         In practice I have yet to find code that cares.
-
-         This simplifies the implementation significantly, and apart
-         from maintaining fealty to the MSCP spec for Immediate commands,
-         there's no good reason to make it more complex:  real MSCP
-         controllers (like the original UDA50) would resequence commands
-         to allow optimal throughput across multiple units, etc.  On the
-         Unibone, the underlying storage and the execution speed of the
-         processor is orders of magnitude faster, so even a brute-force
-         braindead implementation like this can saturate the Unibus.
+         The commands of a unit are executed sequentially, as they appear
+         in the command ring, each unit on a thread of its own; different
+         units run in parallel, sharing the port's DMA channel.
+         Controller commands (SET CONTROLLER CHARACTERISTICS, ABORT,
+         GET COMMAND STATUS) are executed as soon as they are read.
+         Commands within a unit are not resequenced by default: real MSCP
+         controllers (like the original UDA50) would do this to optimize
+         seeks.  On the Unibone, the underlying storage and the execution
+         speed of the processor is orders of magnitude faster, so this does
+         not matter much.  With the port's "seek_order" option, READs and
+         WRITEs are executed in LBN order and adjacent ones are merged into
+         one image access, which helps slow SD cards.
 
     TODO:
     - Some commands aren't checked as thoroughly for errors as they could be.
@@ -34,6 +32,7 @@
     - Same for the "flag" field, this is entirely unpopulated. 
 */
 #include <assert.h>
+#include <algorithm>
 #include <cstddef>
 #include <pthread.h>
 #include <stdio.h>
@@ -42,6 +41,8 @@
  
 #include "logger.hpp"
 #include "utils.hpp"
+#include "timeout.hpp"
+#include "qunibus.h"
 
 #include "mscp_drive.hpp"
 #include "mscp_server_base.hpp"
@@ -50,11 +51,23 @@
 
 namespace mscp {
 
+#pragma pack(push,1)
+struct ReadWriteEraseParameters
+{
+    uint32_t ByteCount;
+    uint32_t BufferPhysicalAddress;  // upper 8 bits are channel address for VAXen
+    uint32_t Unused0;
+    uint32_t Unused1;
+    uint32_t LBN;
+};
+#pragma pack(pop)
+
 mscp_server::mscp_server(
     uda_c *port) :
         mscp_server_base(port),
         _hostTimeout(0),
-        _controllerFlags(0)
+        _controllerFlags(0),
+        _transferBuffers(DRIVE_COUNT)
 {
     name.value = "mscp_server" ;
     type_name.value = "mscp_server_c";
@@ -67,7 +80,7 @@ mscp_server::~mscp_server()
 
 }
 
-uint32_t mscp_server::DispatchCommand(const std::shared_ptr<Message> message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError)
+uint32_t mscp_server::DispatchCommand(Message* message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError)
 {
     uint32_t cmdStatus = 0;
     switch (header->Word3.Command.Opcode)
@@ -136,7 +149,7 @@ mscp_server::Available(
 
 uint32_t
 mscp_server::Access(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber)
 {
     INFO("MSCP ACCESS");
@@ -150,7 +163,7 @@ mscp_server::Access(
 
 uint32_t
 mscp_server::CompareHostData(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber)
 {
     INFO("MSCP COMPARE HOST DATA");
@@ -163,7 +176,7 @@ mscp_server::CompareHostData(
 
 uint32_t
 mscp_server::Erase(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
@@ -176,7 +189,7 @@ mscp_server::Erase(
 
 uint32_t
 mscp_server::GetUnitStatus(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
@@ -280,7 +293,7 @@ mscp_server::GetUnitStatus(
 
 uint32_t
 mscp_server::Online(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
@@ -312,7 +325,7 @@ mscp_server::Online(
 
 uint32_t
 mscp_server::Replace(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber)
 {
     INFO("MSCP REPLACE");
@@ -337,7 +350,7 @@ mscp_server::Replace(
 
 uint32_t
 mscp_server::SetControllerCharacteristics(
-    std::shared_ptr<Message> message)
+    Message* message)
 {
     #pragma pack(push,1)
     struct SetControllerCharacteristicsParameters
@@ -400,7 +413,7 @@ mscp_server::SetControllerCharacteristics(
 
 uint32_t
 mscp_server::SetUnitCharacteristics(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
@@ -427,7 +440,7 @@ mscp_server::SetUnitCharacteristics(
 
 uint32_t
 mscp_server::Read(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
@@ -440,7 +453,7 @@ mscp_server::Read(
 
 uint32_t
 mscp_server::Write(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
@@ -457,7 +470,7 @@ mscp_server::Write(
 //
 uint32_t
 mscp_server::SetUnitCharacteristicsInternal(
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers,
     bool bringOnline)
@@ -528,21 +541,10 @@ mscp_server::SetUnitCharacteristicsInternal(
 uint32_t
 mscp_server::DoDiskTransfer(
     uint16_t operation,
-    std::shared_ptr<Message> message,
+    Message* message,
     uint16_t unitNumber,
     uint16_t modifiers)
 {
-    #pragma pack(push,1)
-    struct ReadWriteEraseParameters
-    {
-        uint32_t ByteCount;
-        uint32_t BufferPhysicalAddress;  // upper 8 bits are channel address for VAXen
-        uint32_t Unused0;
-        uint32_t Unused1;
-        uint32_t LBN;
-    };
-    #pragma pack(pop)
-
     ReadWriteEraseParameters* params =
         reinterpret_cast<ReadWriteEraseParameters*>(GetParameterPointer(message));
 
@@ -611,19 +613,16 @@ mscp_server::DoDiskTransfer(
 
         case Opcodes::COMPARE_HOST_DATA:
         {
-            // Read the data in from disk, read the data in from memory, and compare.
-            std::unique_ptr<uint8_t> diskBuffer;
-
-            if (rctAccess)
+            if (!rctAccess)
             {
-                diskBuffer.reset(drive->ReadRCTBlock(rctBlockNumber));
-            }
-            else
-            {
-                diskBuffer.reset(drive->Read(params->LBN, params->ByteCount));
+                return CompareWithHost(drive, &_transferBuffers[unitNumber],
+                    params->LBN, params->ByteCount, params->BufferPhysicalAddress & 0x00ffffff);
             }
 
-            std::unique_ptr<uint8_t> memBuffer(_port->DMARead(
+            // Read the data in from disk, read the data in from memory, and compare.
+            std::unique_ptr<uint8_t[]> diskBuffer(drive->ReadRCTBlock(rctBlockNumber));
+
+            std::unique_ptr<uint8_t[]> memBuffer(_port->DMARead(
                 params->BufferPhysicalAddress & 0x00ffffff,
                 params->ByteCount,
                 params->ByteCount));
@@ -633,77 +632,76 @@ mscp_server::DoDiskTransfer(
                 return STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
             }
   
-            if (!memcmp(diskBuffer.get(), memBuffer.get(), params->ByteCount))
+            if (memcmp(diskBuffer.get(), memBuffer.get(), params->ByteCount))
             {
                 return STATUS(Status::COMPARE_ERROR, 0, 0);
             }
         }
+        break;
  
         case Opcodes::ERASE:
         {
-            std::unique_ptr<uint8_t> memBuffer(new uint8_t[params->ByteCount]);
-            memset(reinterpret_cast<void*>(memBuffer.get()), 0, params->ByteCount);
-
-            if (rctAccess)
+            if (!rctAccess)
             {
-                drive->WriteRCTBlock(rctBlockNumber,
-                    memBuffer.get());
-            }
-            else
-            {
-                drive->Write(params->LBN,
-                    params->ByteCount,
-                    memBuffer.get());
+                EraseBlocks(drive, &_transferBuffers[unitNumber], params->LBN, params->ByteCount);
+                break;
             }
+
+            std::unique_ptr<uint8_t[]> memBuffer(new uint8_t[params->ByteCount]);
+            memset(reinterpret_cast<void*>(memBuffer.get()), 0, params->ByteCount);
+
+            drive->WriteRCTBlock(rctBlockNumber,
+                memBuffer.get());
         } 
         break;
 
         case Opcodes::READ:
         {
-            std::unique_ptr<uint8_t> diskBuffer;
-        
             if (rctAccess)
             {
-                diskBuffer.reset(drive->ReadRCTBlock(rctBlockNumber));
-            }
-            else
-            { 
-                diskBuffer.reset(drive->Read(params->LBN, params->ByteCount));
+                std::unique_ptr<uint8_t> diskBuffer(drive->ReadRCTBlock(rctBlockNumber));
+
+                if (!_port->DMAWrite(
+                    params->BufferPhysicalAddress & 0x00ffffff,
+                    params->ByteCount,
+                    diskBuffer.get()))
+                {
+                    return STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
+                }
+                break;
             }
 
-            if (!_port->DMAWrite(
-                params->BufferPhysicalAddress & 0x00ffffff,
-                params->ByteCount,
-                diskBuffer.get()))
+            if (!ReadToHost(drive, &_transferBuffers[unitNumber],
+                params->LBN, params->ByteCount, params->BufferPhysicalAddress & 0x00ffffff))
             {
                 return STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
             }
-
         }
         break;
 
         case Opcodes::WRITE:
         {
-            std::unique_ptr<uint8_t> memBuffer(_port->DMARead(
-                params->BufferPhysicalAddress & 0x00ffffff,
-                params->ByteCount,
-                params->ByteCount));
-
-            if (!memBuffer)
-            {
-                return STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
-            }
- 
             if (rctAccess)
             {
+                std::unique_ptr<uint8_t> memBuffer(_port->DMARead(
+                    params->BufferPhysicalAddress & 0x00ffffff,
+                    params->ByteCount,
+                    params->ByteCount));
+
+                if (!memBuffer)
+                {
+                    return STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
+                }
+
                 drive->WriteRCTBlock(rctBlockNumber,
                     memBuffer.get());
+                break;
             }
-            else
+
+            if (!WriteFromHost(drive, &_transferBuffers[unitNumber],
+                params->LBN, params->ByteCount, params->BufferPhysicalAddress & 0x00ffffff))
             {
-                drive->Write(params->LBN,
-                    params->ByteCount,
-                    memBuffer.get());
+                return STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
             }
         }
         break;
@@ -723,4 +721,495 @@ mscp_server::DoDiskTransfer(
     return STATUS(Status::SUCCESS, 0, 0);
 }
 
+//
+// ReadToHost():
+//  Transfers "byteCount" bytes from the image, starting at "lbn", to
+//  Qbus/Unibus memory at "address".  Returns false on NXM.
+//  A memory mapped image is transferred directly.  Else the transfer is
+//  double buffered in the unit's reused segment buffers: the storage I/O
+//  threads read the next segment from the image while the previous one
+//  is transferred to memory.
+//
+bool
+mscp_server::ReadToHost(
+    mscp_drive_c* drive,
+    TransferBuffers* buffers,
+    uint32_t lbn,
+    size_t byteCount,
+    uint32_t address)
+{
+    if (byteCount == 0)
+    {
+        return true;
+    }
+
+    uint8_t* mapped = drive->MapBlocks(lbn, byteCount, false);
+    if (mapped)
+    {
+        bool success = _port->DMAWrite(address, byteCount, mapped);
+        drive->UnmapBlocks();
+        return success;
+    }
+
+    size_t segmentSize = TRANSFER_SEGMENT_BLOCKS * drive->GetBlockSize();
+    size_t bufferSize = std::min(segmentSize, byteCount);
+    buffers->ReserveSegments(bufferSize);
+
+    storagedrive_io_request_c readRequest[2];
+    bool dmaPending = false;
+    unsigned bufferIndex = 0;
+
+    drive->ReadAsync(&readRequest[0], lbn, bufferSize, buffers->segment[0].data());
+
+    for (size_t offset = 0; offset < byteCount; offset += segmentSize)
+    {
+        size_t length = std::min(segmentSize, byteCount - offset);
+        size_t nextOffset = offset + segmentSize;
+
+        // Bus transfer first: other units may use the DMA channel
+        // while we wait for the image.
+        if (dmaPending && !_port->DMAWait())
+        {
+            readRequest[bufferIndex].wait();
+            return false;
+        }
+        readRequest[bufferIndex].wait();
+
+        _port->DMAWriteAsync(
+            address + offset,
+            length,
+            buffers->segment[bufferIndex].data());
+        dmaPending = true;
+
+        // other buffer is free now
+        if (nextOffset < byteCount)
+        {
+            drive->ReadAsync(&readRequest[bufferIndex ^ 1],
+                lbn + nextOffset / drive->GetBlockSize(),
+                std::min(segmentSize, byteCount - nextOffset),
+                buffers->segment[bufferIndex ^ 1].data());
+        }
+        bufferIndex ^= 1;
+    }
+
+    return _port->DMAWait();
+}
+
+//
+// WriteFromHost():
+//  Transfers "byteCount" bytes from Qbus/Unibus memory at "address" to the
+//  image, starting at "lbn".  Returns false on NXM.
+//  A memory mapped image is transferred directly.  Else the transfer is
+//  written behind from the unit's reused segment buffers: the storage I/O
+//  threads write a segment to the image while the next one is transferred
+//  from memory.  Returns when the data is in the image.
+//
+bool
+mscp_server::WriteFromHost(
+    mscp_drive_c* drive,
+    TransferBuffers* buffers,
+    uint32_t lbn,
+    size_t byteCount,
+    uint32_t address)
+{
+    if (byteCount == 0)
+    {
+        return true;
+    }
+
+    uint8_t* mapped = drive->MapBlocks(lbn, byteCount, true);
+    if (mapped)
+    {
+        bool success = _port->DMARead(address, byteCount, mapped);
+        drive->MappedBlocksWritten(lbn, byteCount);
+        return success;
+    }
+
+    size_t segmentSize = TRANSFER_SEGMENT_BLOCKS * drive->GetBlockSize();
+    size_t bufferSize = std::min(segmentSize, byteCount);
+    buffers->ReserveSegments(bufferSize);
+
+    storagedrive_io_request_c writeRequest[2];
+    unsigned bufferIndex = 0;
+    bool success = true;
+
+    for (size_t offset = 0; success && offset < byteCount; offset += segmentSize)
+    {
+        size_t length = std::min(segmentSize, byteCount - offset);
+
+        // buffer still being written by the previous round
+        writeRequest[bufferIndex].wait();
+
+        success = _port->DMARead(
+            address + offset,
+            length,
+            buffers->segment[bufferIndex].data());
+
+        if (success)
+        {
+            drive->WriteAsync(&writeRequest[bufferIndex],
+                lbn + offset / drive->GetBlockSize(),
+                length,
+                buffers->segment[bufferIndex].data());
+        }
+        bufferIndex ^= 1;
+    }
+
+    // End message only when data is in the image
+    drive->image_io_wait();
+    return success;
+}
+
+//
+// CompareWithHost():
+//  Compares "byteCount" bytes of the image, starting at "lbn", with
+//  Qbus/Unibus memory at "address", segment by segment: the storage I/O
+//  threads read a segment from the image while the same segment is
+//  transferred from memory.  Returns the command status.
+//
+uint32_t
+mscp_server::CompareWithHost(
+    mscp_drive_c* drive,
+    TransferBuffers* buffers,
+    uint32_t lbn,
+    size_t byteCount,
+    uint32_t address)
+{
+    size_t segmentSize = TRANSFER_SEGMENT_BLOCKS * drive->GetBlockSize();
+    size_t bufferSize = std::min(segmentSize, byteCount);
+    buffers->ReserveSegments(bufferSize);
+
+    uint8_t* mapped = drive->MapBlocks(lbn, byteCount, false);
+    uint32_t status = STATUS(Status::SUCCESS, 0, 0);
+
+    for (size_t offset = 0; offset < byteCount; offset += segmentSize)
+    {
+        size_t length = std::min(segmentSize, byteCount - offset);
+
+        storagedrive_io_request_c readRequest;
+        uint8_t* diskData;
+        if (mapped)
+        {
+            diskData = mapped + offset;
+        }
+        else
+        {
+            diskData = buffers->segment[0].data();
+            drive->ReadAsync(&readRequest, lbn + offset / drive->GetBlockSize(), length, diskData);
+        }
+
+        bool success = _port->DMARead(address + offset, length, buffers->segment[1].data());
+        readRequest.wait();
+
+        if (!success)
+        {
+            status = STATUS(Status::HOST_BUFFER_ACCESS_ERROR, HostBufferAccessSubcodes::NXM, 0);
+            break;
+        }
+
+        if (memcmp(diskData, buffers->segment[1].data(), length))
+        {
+            status = STATUS(Status::COMPARE_ERROR, 0, 0);
+            break;
+        }
+    }
+
+    if (mapped)
+    {
+        drive->UnmapBlocks();
+    }
+    return status;
+}
+
+//
+// EraseBlocks():
+//  Clears "byteCount" bytes of the image, starting at "lbn", segment by
+//  segment from a reused buffer of zeros.
+//
+void
+mscp_server::EraseBlocks(
+    mscp_drive_c* drive,
+    TransferBuffers* buffers,
+    uint32_t lbn,
+    size_t byteCount)
+{
+    size_t segmentSize = TRANSFER_SEGMENT_BLOCKS * drive->GetBlockSize();
+    size_t bufferSize = std::min(segmentSize, byteCount);
+    if (buffers->zeros.size() < bufferSize)
+    {
+        buffers->zeros.assign(bufferSize, 0);
+    }
+
+    for (size_t offset = 0; offset < byteCount; offset += segmentSize)
+    {
+        drive->Write(lbn + offset / drive->GetBlockSize(),
+            std::min(segmentSize, byteCount - offset),
+            buffers->zeros.data());
+    }
+}
+
+//
+// TransferBenchmark():
+//  Times "count" READs of 64 KB from the image of a unit into memory at
+//  "address", each followed by a WRITE of the same data back to the image.
+//  Once with buffers allocated per transfer, once on the transfer path of
+//  the commands.  The unit should be idle; the memory is overwritten.
+//
+void
+mscp_server::TransferBenchmark(
+    uint16_t unitNumber,
+    uint32_t address,
+    unsigned count)
+{
+    const size_t byteCount = 64 * 1024;
+
+    mscp_drive_c* drive = GetDrive(_port, unitNumber);
+    if (nullptr == drive ||
+        !drive->IsAvailable())
+    {
+        printf("Unit %u has no image.\n", unitNumber);
+        return;
+    }
+
+    uint32_t blocks = byteCount / drive->GetBlockSize();
+    if (drive->GetBlockCount() < blocks)
+    {
+        printf("Unit %u is smaller than 64 KB.\n", unitNumber);
+        return;
+    }
+    bool write = !drive->image_is_readonly();
+
+    // own buffers: the unit thread may be running
+    TransferBuffers buffers;
+    for (int direct = 0; direct <= 1; direct++)
+    {
+        uint64_t readNs = 0;
+        uint64_t writeNs = 0;
+        bool success = true;
+        for (unsigned i = 0; success && i < count; i++)
+        {
+            uint32_t lbn = ((uint64_t)i * blocks) % (drive->GetBlockCount() - blocks + 1);
+            uint64_t startNs = timeout_c::abstime_ns();
+            if (direct)
+            {
+                success = ReadToHost(drive, &buffers, lbn, byteCount, address);
+            }
+            else
+            {
+                std::unique_ptr<uint8_t[]> diskBuffer(drive->Read(lbn, byteCount));
+                success = _port->DMAWrite(address, byteCount, diskBuffer.get());
+            }
+            readNs += timeout_c::abstime_ns() - startNs;
+
+            if (!success || !write)
+            {
+                continue;
+            }
+            startNs = timeout_c::abstime_ns();
+            if (direct)
+            {
+                success = WriteFromHost(drive, &buffers, lbn, byteCount, address);
+            }
+            else
+            {
+                std::unique_ptr<uint8_t[]> memBuffer(_port->DMARead(address, byteCount, byteCount));
+                success = memBuffer != nullptr;
+                if (success)
+                {
+                    drive->Write(lbn, byteCount, memBuffer.get());
+                }
+            }
+            writeNs += timeout_c::abstime_ns() - startNs;
+        }
+
+        if (!success)
+        {
+            printf("Bus timeout in 64 KB at %s.\n", qunibus->addr2text(address));
+            return;
+        }
+        const char* label = "allocated";
+        if (direct)
+        {
+            label = "reused";
+            if (drive->MapBlocks(0, byteCount, false))
+            {
+                label = "mapped";
+                drive->UnmapBlocks();
+            }
+        }
+        printf("%-10s: %u * 64 KB: READ %llu us = %llu KB/s, ", label, count,
+            (unsigned long long)readNs / 1000 / (count ? count : 1),
+            (unsigned long long)count * 64 * 1000000000 / (readNs ? readNs : 1));
+        if (write)
+        {
+            printf("WRITE %llu us = %llu KB/s per transfer.\n",
+                (unsigned long long)writeNs / 1000 / (count ? count : 1),
+                (unsigned long long)count * 64 * 1000000000 / (writeNs ? writeNs : 1));
+        }
+        else
+        {
+            printf("no WRITE, image is read only.\n");
+        }
+    }
+}
+
+//
+// GetBlockRange():
+//  Block range of READ, WRITE, ERASE, COMPARE HOST DATA and ACCESS,
+//  for the command scheduler.  RCT accesses and commands for units
+//  not online are not reordered.
+//
+bool
+mscp_server::GetBlockRange(
+    Message* message,
+    uint32_t* lbn,
+    uint32_t* blockCount)
+{
+    ControlMessageHeader* header = 
+        reinterpret_cast<ControlMessageHeader*>(message->Message);
+    ReadWriteEraseParameters* params =
+        reinterpret_cast<ReadWriteEraseParameters*>(GetParameterPointer(message));
+
+    mscp_drive_c* drive = GetDrive(_port, header->UnitNumber);
+    if (nullptr == drive ||
+        !drive->IsAvailable() ||
+        !drive->IsOnline() ||
+        params->LBN >= drive->GetBlockCount())
+    {
+        return false;
+    }
+
+    *lbn = params->LBN;
+    *blockCount = (params->ByteCount + drive->GetBlockSize() - 1) / drive->GetBlockSize();
+    return true;
+}
+
+//
+// DispatchMergedTransfer():
+//  Executes READs or WRITEs for adjacent block ranges with one image
+//  access and one scatter-gather DMA.
+//  Returns false if any command does not qualify, then nothing is
+//  transferred, or if the DMA fails. A failed READ may have written
+//  part of the host buffers; a failed WRITE has not changed the image,
+//  its data is read completely before the image write. So WRITEs to a
+//  memory mapped image are not merged, they would change the image
+//  during the DMA.
+//  The commands are then executed one by one, which repeats these
+//  transfers and reports errors for the command causing them.
+//
+bool
+mscp_server::DispatchMergedTransfer(
+    const std::vector<Message*>& batch,
+    std::vector<uint32_t>& cmdStatus)
+{
+    ControlMessageHeader* header = 
+        reinterpret_cast<ControlMessageHeader*>(batch[0]->Message);
+    uint16_t operation = header->Word3.Command.Opcode;
+
+    mscp_drive_c* drive = GetDrive(_port, header->UnitNumber);
+    if (nullptr == drive ||
+        !drive->IsAvailable() ||
+        !drive->IsOnline())
+    {
+        return false;
+    }
+
+    uint32_t lbn = reinterpret_cast<ReadWriteEraseParameters*>(GetParameterPointer(batch[0]))->LBN;
+    size_t byteCount = 0;
+    for (Message* message : batch)
+    {
+        ReadWriteEraseParameters* params =
+            reinterpret_cast<ReadWriteEraseParameters*>(GetParameterPointer(message));
+
+        // Whole blocks only, the next command continues at the next block
+        if (params->ByteCount == 0 ||
+            (params->ByteCount % drive->GetBlockSize()) != 0 ||
+            (params->BufferPhysicalAddress & 1) != 0 ||
+            params->LBN != lbn + byteCount / drive->GetBlockSize() ||
+            params->LBN + params->ByteCount / drive->GetBlockSize() > drive->GetBlockCount())
+        {
+            return false;
+        }
+        byteCount += params->ByteCount;
+    }
+
+    DEBUG_FAST("MSCP merged 0x%x unit %d, %d commands lbn %d count %d",
+        operation,
+        header->UnitNumber,
+        (int)batch.size(),
+        lbn,
+        (int)byteCount);
+
+    // READ directly from a memory mapped image, else over the unit's buffer
+    TransferBuffers* buffers = &_transferBuffers[header->UnitNumber];
+    uint8_t* diskBuffer = drive->MapBlocks(lbn, byteCount, operation == Opcodes::WRITE);
+    bool mapped = diskBuffer != nullptr;
+    if (mapped && operation == Opcodes::WRITE)
+    {
+        // single commands write the mapped image directly as well
+        drive->UnmapBlocks();
+        return false;
+    }
+    if (!mapped)
+    {
+        if (buffers->merge.size() < byteCount)
+        {
+            buffers->merge.resize(byteCount);
+        }
+        diskBuffer = buffers->merge.data();
+    }
+
+    std::vector<dma_segment_t> segments(batch.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        ReadWriteEraseParameters* params =
+            reinterpret_cast<ReadWriteEraseParameters*>(GetParameterPointer(batch[i]));
+        segments[i].qunibus_addr = params->BufferPhysicalAddress & 0x00ffffff;
+        segments[i].buffer = reinterpret_cast<uint16_t*>(diskBuffer + offset);
+        segments[i].wordcount = params->ByteCount >> 1;
+        offset += params->ByteCount;
+    }
+
+    if (operation == Opcodes::READ)
+    {
+        if (!mapped)
+        {
+            storagedrive_io_request_c readRequest;
+            drive->ReadAsync(&readRequest, lbn, byteCount, diskBuffer);
+            readRequest.wait();
+        }
+
+        bool success = _port->DMAWrite(segments.data(), segments.size());
+        if (mapped)
+        {
+            drive->UnmapBlocks();
+        }
+        if (!success)
+        {
+            return false;
+        }
+    }
+    else
+    {
+        assert(operation == Opcodes::WRITE);
+        if (!_port->DMARead(segments.data(), segments.size()))
+        {
+            return false;
+        }
+        drive->Write(lbn, byteCount, diskBuffer);
+    }
+
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        ReadWriteEraseParameters* params =
+            reinterpret_cast<ReadWriteEraseParameters*>(GetParameterPointer(batch[i]));
+        batch[i]->MessageLength = sizeof(ReadWriteEraseParameters) + HEADER_SIZE;
+        params->LBN = 0;
+        cmdStatus[i] = STATUS(Status::SUCCESS, 0, 0);
+    }
+
+    return true;
+}
+
 } // end namespace
\ No newline at end of file
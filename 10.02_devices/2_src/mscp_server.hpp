@@ -10,10 +10,17 @@
 
 #include <stdint.h>
 #include <memory>
+#include <vector>
 #include "mscp_server_base.hpp"
 
+class mscp_drive_c;
+
 namespace mscp {
 
+// READ, WRITE, COMPARE HOST DATA and ERASE are split into segments of this
+// many blocks: image I/O of one segment overlaps the DMA of another one.
+#define TRANSFER_SEGMENT_BLOCKS 16
+
 //
 //
 //
@@ -23,38 +30,71 @@ public:
     mscp_server(uda_c *port);
     ~mscp_server();
 
+    void TransferBenchmark(uint16_t unitNumber, uint32_t address, unsigned count);
+
 protected:
-    uint32_t DispatchCommand(const std::shared_ptr<Message> message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError) override;
+    uint32_t DispatchCommand(Message* message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError) override;
+    bool GetBlockRange(Message* message, uint32_t* lbn, uint32_t* blockCount) override;
+    bool DispatchMergedTransfer(const std::vector<Message*>& batch, std::vector<uint32_t>& cmdStatus) override;
 
 private:
     // MSCP-specific implementations
-    uint32_t Access(std::shared_ptr<Message> message, uint16_t unitNumber) override;
+    uint32_t Access(Message* message, uint16_t unitNumber) override;
     uint32_t Available(uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t CompareHostData(std::shared_ptr<Message> message, uint16_t unitNumber) override;
-    uint32_t Erase(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t GetUnitStatus(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t Online(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t Read(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t SetControllerCharacteristics(std::shared_ptr<Message> message) override;
-    uint32_t SetUnitCharacteristics(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t Write(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t CompareHostData(Message* message, uint16_t unitNumber) override;
+    uint32_t Erase(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t GetUnitStatus(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t Online(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t Read(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t SetControllerCharacteristics(Message* message) override;
+    uint32_t SetUnitCharacteristics(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t Write(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
 
 private:
     // Commands unique to MSCP
-    uint32_t Replace(std::shared_ptr<Message> message, uint16_t unitNumber);
+    uint32_t Replace(Message* message, uint16_t unitNumber);
 
 private:
     uint32_t SetUnitCharacteristicsInternal(
-        std::shared_ptr<Message> message,
+        Message* message,
         uint16_t unitNumber,
         uint16_t modifiers,
         bool bringOnline);
-    uint32_t DoDiskTransfer(uint16_t operation, std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers);
+    uint32_t DoDiskTransfer(uint16_t operation, Message* message, uint16_t unitNumber, uint16_t modifiers);
+
+    // Transfer buffers of a unit, allocated on first use and reused.
+    // Used only by the unit's thread.
+    // Transfers are streamed in segments of TRANSFER_SEGMENT_BLOCKS,
+    // so memory use does not depend on the byte count.
+    struct TransferBuffers
+    {
+        std::vector<uint8_t> segment[2];
+        std::vector<uint8_t> zeros;
+        std::vector<uint8_t> merge;
+
+        void ReserveSegments(size_t size)
+        {
+            for (std::vector<uint8_t>& s : segment)
+            {
+                if (s.size() < size)
+                {
+                    s.resize(size);
+                }
+            }
+        }
+    };
+
+    bool ReadToHost(mscp_drive_c* drive, TransferBuffers* buffers, uint32_t lbn, size_t byteCount, uint32_t address);
+    bool WriteFromHost(mscp_drive_c* drive, TransferBuffers* buffers, uint32_t lbn, size_t byteCount, uint32_t address);
+    uint32_t CompareWithHost(mscp_drive_c* drive, TransferBuffers* buffers, uint32_t lbn, size_t byteCount, uint32_t address);
+    void EraseBlocks(mscp_drive_c* drive, TransferBuffers* buffers, uint32_t lbn, size_t byteCount);
 
 private:
     uint32_t _hostTimeout;
     uint32_t _controllerFlags;
 
+    std::vector<TransferBuffers> _transferBuffers;  // by unit number
+
 };
 
 } // end namespace
@@ -13,11 +13,11 @@
     controllers.  Subclasses implement disk/tape-specific commands and behaviors.
 */
 #include <assert.h>
+#include <algorithm>
 #include <cstddef>
 #include <pthread.h>
 #include <stdio.h>
 #include <memory>
-#include <queue>
  
 #include "logger.hpp"
 #include "utils.hpp"
@@ -40,6 +40,18 @@ void* polling_worker(
     return nullptr;
 }
 
+//
+// unit_worker():
+//  Runs the command thread of one unit.
+//
+void* unit_worker(
+    void *context)
+{
+    mscp_server_base::UnitQueue* unit = reinterpret_cast<mscp_server_base::UnitQueue*>(context);
+    unit->server->UnitWorker(unit);
+    return nullptr;
+}
+
 mscp_server_base::mscp_server_base(
     uda_c *port) :
         device_c(),
@@ -47,11 +59,27 @@ mscp_server_base::mscp_server_base(
         _pollState(PollingState::Wait),
         polling_cond(PTHREAD_COND_INITIALIZER),
         polling_mutex(PTHREAD_MUTEX_INITIALIZER),
-        _credits(INIT_CREDITS) 
+        _credits(INIT_CREDITS),
+        _units(DRIVE_COUNT),
+        _unitMutex(PTHREAD_MUTEX_INITIALIZER),
+        _unitIdleCond(PTHREAD_COND_INITIALIZER),
+        _mergedTransfers(0),
+        _transfers(0),
+        _transferBlocks(0),
+        _responseMutex(PTHREAD_MUTEX_INITIALIZER)
 {
     set_workers_count(0);
     _port = port;
 
+    for (UnitQueue& unit : _units)
+    {
+        unit.server = this;
+        unit.started = false;
+        unit.busy = false;
+        unit.headLBN = 0;
+        pthread_cond_init(&unit.cond, NULL);
+    }
+
     enabled.set(true); 
     enabled.readonly = true; // always active
 
@@ -128,15 +156,50 @@ mscp_server_base::AbortPollingThread(void)
     }
 
     DEBUG_FAST("Polling thread aborted.");  
+
+    AbortUnitThreads();
+}
+
+//
+// AbortUnitThreads():
+//  Stops the unit threads, after _abort_polling was set.
+//  Commands still queued are dropped.
+//
+void
+mscp_server_base::AbortUnitThreads(void)
+{
+    pthread_mutex_lock(&_unitMutex);
+    for (UnitQueue& unit : _units)
+    {
+        pthread_cond_signal(&unit.cond);
+    }
+    pthread_mutex_unlock(&_unitMutex);
+
+    for (UnitQueue& unit : _units)
+    {
+        if (unit.started)
+        {
+            pthread_join(unit.pthread, NULL);
+            unit.started = false;
+        }
+        for (Message* message : unit.commands)
+        {
+            _port->ReleaseCommand(message);
+        }
+        unit.commands.clear();
+    }
+
+    DEBUG_FAST("Unit threads aborted.");
 }
 
 //
 // Poll():
 //  The MSCP polling thread.  
 //  This thread waits to be awoken, then pulls messages from the MSCP command
-//  ring and executes them.  When no work is left to be done, it goes back to
-//  sleep.
-//  This is awoken by a write to the UDA IP register.
+//  ring and queues them for execution by the unit threads.  When no work is
+//  left to be done, it goes back to sleep.
+//  This is awoken by a write to the UDA IP register, or by a unit thread
+//  which has completed a command.
 //
 void
 mscp_server_base::Poll(void)
@@ -170,155 +233,560 @@ mscp_server_base::Poll(void)
         }
 
         //
-        // Read all commands from the ring into a queue; then execute them.
+        // Read all commands from the ring and hand them to the unit threads.
+        // Reading is limited by the port's message pool; a unit thread wakes
+        // us when it has released a message, so waiting commands are
+        // picked up then.
         //
-        std::queue<std::shared_ptr<Message>> messages;
-
         int msgCount = 0;
         while (!_abort_polling && _pollState != PollingState::InitRestart)
         {
             bool error = false;
-            std::shared_ptr<Message> message(_port->GetNextCommand(&error));
+            Message* message = _port->GetNextCommand(&error);
             if (error)
             {
                 DEBUG_FAST("Error while reading messages, returning to idle state.");
-                // The lords of STL decreed that queue should have no "clear" method
-                // so we do this garbage instead:
-                messages = std::queue<std::shared_ptr<Message>>(); 
                 break; 
             }
             if (nullptr == message)
             {
-                DEBUG_FAST("End of command ring; %d messages to be executed.", msgCount);
+                DEBUG_FAST("End of command ring; %d messages queued.", msgCount);
                 break;
             }
 
             msgCount++;
-            messages.push(message);
+            QueueCommand(message);
         } 
 
+        // Units see the whole batch, so it can be scheduled
+        StartUnits();
+
         //
-        // Pull commands from the queue until it is empty or we're told to quit.
+        // Go back to sleep.  If a UDA reset is pending, we need to signal
+        // the Reset() call so it knows we've completed our poll and are
+        // returning to sleep (i.e. the polling thread is now reset.)
         //
-        while(!messages.empty() && !_abort_polling && _pollState != PollingState::InitRestart)
+        pthread_mutex_lock(&polling_mutex); 
+        if (_pollState == PollingState::InitRestart)
         {
-            std::shared_ptr<Message> message(messages.front());  
-            messages.pop();
-
-            //
-            // Handle the message.  We dispatch on opcodes to the
-            // appropriate methods.  These methods modify the message
-            // object in place; this message object is then posted back
-            // to the response ring.
-            //
-            ControlMessageHeader* header = 
-                reinterpret_cast<ControlMessageHeader*>(message->Message);
+            DEBUG_FAST("(T)MSCP Polling thread reset.");
+            // Commands not yet started are dropped, running ones complete.
+            pthread_mutex_unlock(&polling_mutex); 
+            DrainUnits();
+            pthread_mutex_lock(&polling_mutex); 
+            // Signal the Reset call that we're done so it can return
+            // and release the Host.
+            _pollState = PollingState::Wait;
+            pthread_cond_broadcast(&polling_cond);
+        }
+        else if (_pollState == PollingState::InitRun)
+        {
+            _pollState = PollingState::Run;
+        }
+        else
+        { 
+            _pollState = PollingState::Wait;
+        }
+        pthread_mutex_unlock(&polling_mutex);
+        
+    }
+    DEBUG_FAST("(T)MSCP Polling thread exiting."); 
+}
 
-            DEBUG_FAST("Message size 0x%x opcode 0x%x rsvd 0x%x mod 0x%x unit %d, ursvd 0x%x, ref 0x%x", 
-                message->MessageLength,
-                header->Word3.Command.Opcode,
-                header->Word3.Command.Reserved,
-                header->Word3.Command.Modifiers,
-                header->UnitNumber,
-                header->Reserved,
-                header->ReferenceNumber);
+//
+// QueueCommand():
+//  Appends a command to the queue of its unit.
+//  Commands not addressed to an existing unit are executed immediately.
+//
+void
+mscp_server_base::QueueCommand(
+    Message* message)
+{
+    ControlMessageHeader* header = 
+        reinterpret_cast<ControlMessageHeader*>(message->Message);
 
-            bool protocolError = false;
-            uint32_t cmdStatus = 0;
-            uint16_t modifiers = header->Word3.Command.Modifiers;
+    switch (header->Word3.Command.Opcode)
+    {
+    case Opcodes::ABORT:
+    case Opcodes::GET_COMMAND_STATUS:
+    case Opcodes::SET_CONTROLLER_CHARACTERISTICS:
+        ExecuteCommand(message);
+        return;
+    }
 
-            // Execute the MSCP/TMSCP command
-            cmdStatus = DispatchCommand(message, header, modifiers, &protocolError);
+    if (header->UnitNumber >= _units.size())
+    {
+        ExecuteCommand(message);
+        return;
+    }
 
-            if (protocolError)
-            {
-                uint16_t subCode = offsetof(ControlMessageHeader, Word3) + HEADER_OFFSET;
-                cmdStatus = STATUS(Status::INVALID_COMMAND, subCode, 0);
-            }
+    UnitQueue* unit = &_units[header->UnitNumber];
 
-            DEBUG_FAST("cmd 0x%x st 0x%x fl 0x%x", cmdStatus, GET_STATUS(cmdStatus), GET_FLAGS(cmdStatus));
+    pthread_mutex_lock(&_unitMutex);
+    if (!unit->started)
+    {
+        int status = pthread_create(
+            &unit->pthread,
+            NULL,
+            &unit_worker,
+            reinterpret_cast<void*>(unit));
 
-            //
-            // Set the endcode and status bits
-            //
-            header->Word3.End.Status = GET_STATUS(cmdStatus);
-            header->Word3.End.Flags = GET_FLAGS(cmdStatus);
+        if (status != 0)
+        {
+            FATAL("Failed to start mscp unit thread.  Status 0x%x", status);
+        }
+        unit->started = true;
+    }
+    unit->commands.push_back(message);
+    pthread_mutex_unlock(&_unitMutex);
+}
 
-            // Set the End code properly -- for a protocol error, 
-            // this is just the End code, for all others it's the End code
-            // or'd with the original opcode.
-            if (protocolError)
-            {
-                 // Just the END code, no opcode
-                 header->Word3.End.Endcode = Endcodes::END;
-            }
-            else
+//
+// StartUnits():
+//  Wakes the unit threads which have commands queued.
+//
+void
+mscp_server_base::StartUnits(void)
+{
+    pthread_mutex_lock(&_unitMutex);
+    for (UnitQueue& unit : _units)
+    {
+        if (!unit.commands.empty())
+        {
+            pthread_cond_signal(&unit.cond);
+        }
+    }
+    pthread_mutex_unlock(&_unitMutex);
+}
+
+//
+// UnitWorker():
+//  Executes the commands of one unit, one after another.
+//
+void
+mscp_server_base::UnitWorker(
+    UnitQueue* unit)
+{
+    worker_init_realtime_priority(rt_device);
+
+    std::vector<Message*> batch;
+    pthread_mutex_lock(&_unitMutex);
+    while (!_abort_polling)
+    {
+        if (unit->commands.empty())
+        {
+            pthread_cond_wait(&unit->cond, &_unitMutex);
+            continue;
+        }
+
+        ScheduleCommands(unit, batch);
+        unit->busy = true;
+        pthread_mutex_unlock(&_unitMutex);
+
+        ExecuteBatch(batch);
+        // message buffers are free again, commands may wait in the ring for them
+        WakePolling();
+
+        pthread_mutex_lock(&_unitMutex);
+        unit->busy = false;
+        pthread_cond_broadcast(&_unitIdleCond);
+    }
+    pthread_mutex_unlock(&_unitMutex);
+}
+
+//
+// TransferOpcode():
+//  True for the commands which access a block range of the unit.
+//
+static bool
+TransferOpcode(
+    uint8_t opcode)
+{
+    switch (opcode)
+    {
+    case Opcodes::ACCESS:
+    case Opcodes::COMPARE_HOST_DATA:
+    case Opcodes::ERASE:
+    case Opcodes::READ:
+    case Opcodes::WRITE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//
+// ScheduleCommands():
+//  Removes the next command(s) to execute from the unit queue.
+//  Without seek ordering this is the first command.
+//  With seek ordering, transfer commands up to the next other command
+//  are executed in ascending LBN order from the end of the previous
+//  transfer, wrapping around to the lowest LBN (circular elevator).
+//  Express commands go first.  A command does not pass an earlier one
+//  with an overlapping block range if one of them writes.
+//  Following READs or WRITEs for adjacent ranges are merged into batch.
+//  Called with _unitMutex held.
+//
+void
+mscp_server_base::ScheduleCommands(
+    UnitQueue* unit,
+    std::vector<Message*>& batch)
+{
+    struct Transfer
+    {
+        uint8_t opcode;
+        bool express;
+        uint32_t lbn;
+        uint32_t blockCount;
+        bool picked;
+    };
+
+    batch.clear();
+
+    // Window of commands which may be reordered
+    std::vector<Transfer> window;
+    if (_port->seek_order.value)
+    {
+        for (Message* message : unit->commands)
+        {
+            ControlMessageHeader* header = 
+                reinterpret_cast<ControlMessageHeader*>(message->Message);
+            Transfer transfer;
+            transfer.opcode = header->Word3.Command.Opcode;
+            transfer.express = header->Word3.Command.Modifiers & MODIFIER_EXPRESS;
+            transfer.picked = false;
+            if (!TransferOpcode(transfer.opcode) ||
+                !GetBlockRange(message, &transfer.lbn, &transfer.blockCount))
             {
-                 header->Word3.End.Endcode |= Endcodes::END;
+                break;
             }
+            window.push_back(transfer);
+        }
+    }
+
+    if (window.empty())
+    {
+        batch.push_back(unit->commands.front());
+        unit->commands.pop_front();
+        return;
+    }
 
-            if (message->Word1.Info.MessageType == MessageTypes::Sequential &&
-                header->Word3.End.Endcode & Endcodes::END)
+    // May window[i] execute before the earlier commands not yet picked?
+    auto eligible = [&window](size_t i)
+    {
+        bool writes = window[i].opcode == Opcodes::WRITE || window[i].opcode == Opcodes::ERASE;
+        for (size_t j = 0; j < i; j++)
+        {
+            if (window[j].picked)
             {
-                //
-                // We steal the credits hack from simh:
-                // The controller gives all of its credits to the host,
-                // thereafter it supplies one credit for every response
-                // packet sent.
-                // 
-                uint8_t grantedCredits = std::min(_credits, static_cast<uint8_t>(MAX_CREDITS));
-                _credits -= grantedCredits;
-                message->Word1.Info.Credits = grantedCredits + 1;
-                DEBUG_FAST("granted credits %d", grantedCredits + 1);
+                continue;
             }
-            else
+            bool overlap = window[j].lbn < window[i].lbn + window[i].blockCount &&
+                window[i].lbn < window[j].lbn + window[j].blockCount;
+            if (overlap &&
+                (writes || window[j].opcode == Opcodes::WRITE || window[j].opcode == Opcodes::ERASE))
             {
-                message->Word1.Info.Credits = 0;
+                return false;
             }
+        }
+        return true;
+    };
 
-            //
-            // Post the response to the port's response ring.
-            // If everything is working properly, there should always be room.
-            //
-            if(!_port->PostResponse(message.get()))
+    // First express command, else next LBN from head; the first command
+    // is always eligible.
+    size_t next = 0;
+    bool ahead = window[0].lbn >= unit->headLBN;
+    for (size_t i = 0; i < window.size(); i++)
+    {
+        if (!eligible(i))
+        {
+            continue;
+        }
+        if (window[i].express)
+        {
+            next = i;
+            break;
+        }
+        bool iAhead = window[i].lbn >= unit->headLBN;
+        if ((iAhead && !ahead) ||
+            (iAhead == ahead && window[i].lbn < window[next].lbn))
+        {
+            next = i;
+            ahead = iAhead;
+        }
+    }
+    bool express = window[next].express;
+    window[next].picked = true;
+    std::vector<size_t> picked(1, next);
+
+    // Merge READs or WRITEs which continue the range
+    uint32_t blockCount = window[next].blockCount;
+    if (!express &&
+        (window[next].opcode == Opcodes::READ || window[next].opcode == Opcodes::WRITE))
+    {
+        bool found = true;
+        while (found &&
+            picked.size() < MAX_MERGE_COMMANDS)
+        {
+            found = false;
+            uint32_t end = window[next].lbn + blockCount;
+            for (size_t i = 0; i < window.size(); i++)
             {
-                FATAL("Unexpected: no room in response ring.");
+                if (!window[i].picked &&
+                    !window[i].express &&
+                    window[i].opcode == window[next].opcode &&
+                    window[i].lbn == end &&
+                    blockCount + window[i].blockCount <= MAX_MERGE_BLOCKS &&
+                    eligible(i))
+                {
+                    window[i].picked = true;
+                    picked.push_back(i);
+                    blockCount += window[i].blockCount;
+                    found = true;
+                    break;
+                }
             }
+        }
+    }
+
+    for (size_t i : picked)
+    {
+        batch.push_back(unit->commands[i]);
+    }
+    // remove from the back, so indexes stay valid
+    std::sort(picked.begin(), picked.end());
+    for (size_t i = picked.size(); i-- > 0;)
+    {
+        unit->commands.erase(unit->commands.begin() + picked[i]);
+    }
+
+    unit->headLBN = window[next].lbn + blockCount;
 
-            //
-            // Go around and pick up the next one.
-            //
+    if (window[next].opcode == Opcodes::READ || window[next].opcode == Opcodes::WRITE)
+    {
+        _mergedTransfers += batch.size() - 1;
+        _transfers++;
+        _transferBlocks += blockCount;
+        _port->merged_transfers.value = _mergedTransfers;
+        _port->transfer_size.value = (double)_transferBlocks / _transfers;
+    }
+
+    DEBUG_FAST("Unit scheduled opcode 0x%x lbn %d, %d blocks, %d commands",
+        window[next].opcode, window[next].lbn, blockCount, (int)batch.size());
+}
+
+//
+// ExecuteBatch():
+//  Executes the commands picked by ScheduleCommands().
+//
+void
+mscp_server_base::ExecuteBatch(
+    std::vector<Message*>& batch)
+{
+    if (batch.size() > 1)
+    {
+        std::vector<uint32_t> cmdStatus(batch.size(), 0);
+        if (DispatchMergedTransfer(batch, cmdStatus))
+        {
+            for (size_t i = 0; i < batch.size(); i++)
+            {
+                PostEnd(batch[i], cmdStatus[i], false);
+            }
+            return;
         }
+    }
 
+    for (Message* message : batch)
+    {
+        ExecuteCommand(message);
+    }
+}
+
+//
+// GetBlockRange():
+//  No reordering by default.
+//
+bool
+mscp_server_base::GetBlockRange(
+    Message* message,
+    uint32_t* lbn,
+    uint32_t* blockCount)
+{
+    UNUSED(message);
+    UNUSED(lbn);
+    UNUSED(blockCount);
+    return false;
+}
+
+//
+// DispatchMergedTransfer():
+//  No merged execution by default.
+//
+bool
+mscp_server_base::DispatchMergedTransfer(
+    const std::vector<Message*>& batch,
+    std::vector<uint32_t>& cmdStatus)
+{
+    UNUSED(batch);
+    UNUSED(cmdStatus);
+    return false;
+}
+
+//
+// ExecuteCommand():
+//  Executes a command, posts the response and returns the message buffer
+//  to the port.
+//
+void
+mscp_server_base::ExecuteCommand(
+    Message* message)
+{
+    //
+    // Handle the message.  We dispatch on opcodes to the
+    // appropriate methods.  These methods modify the message
+    // object in place; this message object is then posted back
+    // to the response ring.
+    //
+    ControlMessageHeader* header = 
+        reinterpret_cast<ControlMessageHeader*>(message->Message);
+
+    DEBUG_FAST("Message size 0x%x opcode 0x%x rsvd 0x%x mod 0x%x unit %d, ursvd 0x%x, ref 0x%x", 
+        message->MessageLength,
+        header->Word3.Command.Opcode,
+        header->Word3.Command.Reserved,
+        header->Word3.Command.Modifiers,
+        header->UnitNumber,
+        header->Reserved,
+        header->ReferenceNumber);
+
+    bool protocolError = false;
+    uint32_t cmdStatus = 0;
+    uint16_t modifiers = header->Word3.Command.Modifiers;
+
+    // Execute the MSCP/TMSCP command
+    cmdStatus = DispatchCommand(message, header, modifiers, &protocolError);
+
+    if (protocolError)
+    {
+        uint16_t subCode = offsetof(ControlMessageHeader, Word3) + HEADER_OFFSET;
+        cmdStatus = STATUS(Status::INVALID_COMMAND, subCode, 0);
+    }
+
+    PostEnd(message, cmdStatus, protocolError);
+}
+
+//
+// PostEnd():
+//  Turns a command into its end message, posts it to the response ring
+//  and returns the message buffer to the port.
+//
+void
+mscp_server_base::PostEnd(
+    Message* message,
+    uint32_t cmdStatus,
+    bool protocolError)
+{
+    ControlMessageHeader* header = 
+        reinterpret_cast<ControlMessageHeader*>(message->Message);
+
+    DEBUG_FAST("cmd 0x%x st 0x%x fl 0x%x", cmdStatus, GET_STATUS(cmdStatus), GET_FLAGS(cmdStatus));
+
+    //
+    // Set the endcode and status bits
+    //
+    header->Word3.End.Status = GET_STATUS(cmdStatus);
+    header->Word3.End.Flags = GET_FLAGS(cmdStatus);
+
+    // Set the End code properly -- for a protocol error, 
+    // this is just the End code, for all others it's the End code
+    // or'd with the original opcode.
+    if (protocolError)
+    {
+         // Just the END code, no opcode
+         header->Word3.End.Endcode = Endcodes::END;
+    }
+    else
+    {
+         header->Word3.End.Endcode |= Endcodes::END;
+    }
+
+    pthread_mutex_lock(&_responseMutex);
+    if (message->Word1.Info.MessageType == MessageTypes::Sequential &&
+        header->Word3.End.Endcode & Endcodes::END)
+    {
         //
-        // Go back to sleep.  If a UDA reset is pending, we need to signal
-        // the Reset() call so it knows we've completed our poll and are
-        // returning to sleep (i.e. the polling thread is now reset.)
-        //
-        pthread_mutex_lock(&polling_mutex); 
-        if (_pollState == PollingState::InitRestart)
+        // We steal the credits hack from simh:
+        // The controller gives all of its credits to the host,
+        // thereafter it supplies one credit for every response
+        // packet sent.
+        // 
+        uint8_t grantedCredits = std::min(_credits, static_cast<uint8_t>(MAX_CREDITS));
+        _credits -= grantedCredits;
+        message->Word1.Info.Credits = grantedCredits + 1;
+        DEBUG_FAST("granted credits %d", grantedCredits + 1);
+    }
+    else
+    {
+        message->Word1.Info.Credits = 0;
+    }
+
+    //
+    // Post the response to the port's response ring.
+    // If everything is working properly, there should always be room.
+    //
+    if(!_port->PostResponse(message))
+    {
+        FATAL("Unexpected: no room in response ring.");
+    }
+    pthread_mutex_unlock(&_responseMutex);
+
+    _port->ReleaseCommand(message);
+}
+
+//
+// DrainUnits():
+//  Drops all queued commands and waits until the unit threads are idle.
+//
+void
+mscp_server_base::DrainUnits(void)
+{
+    pthread_mutex_lock(&_unitMutex);
+    for (UnitQueue& unit : _units)
+    {
+        for (Message* message : unit.commands)
         {
-            DEBUG_FAST("(T)MSCP Polling thread reset.");
-            // Signal the Reset call that we're done so it can return
-            // and release the Host.
-            _pollState = PollingState::Wait;
-            pthread_cond_signal(&polling_cond);
+            _port->ReleaseCommand(message);
         }
-        else if (_pollState == PollingState::InitRun)
+        unit.commands.clear();
+    }
+    for (UnitQueue& unit : _units)
+    {
+        while (unit.busy)
         {
-            _pollState = PollingState::Run;
+            pthread_cond_wait(&_unitIdleCond, &_unitMutex);
         }
-        else
-        { 
-            _pollState = PollingState::Wait;
-        }
-        pthread_mutex_unlock(&polling_mutex);
-        
     }
-    DEBUG_FAST("(T)MSCP Polling thread exiting."); 
+    pthread_mutex_unlock(&_unitMutex);
 }
 
-uint32_t mscp_server_base::DispatchCommand(const std::shared_ptr<Message> message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError)
+//
+// WakePolling():
+//  Makes the polling thread look at the command ring again,
+//  unless a reset is in progress.
+//
+void
+mscp_server_base::WakePolling(void)
+{
+    pthread_mutex_lock(&polling_mutex);
+    if (_pollState != PollingState::InitRestart)
+    {
+        _pollState = PollingState::InitRun;
+        pthread_cond_broadcast(&polling_cond);
+    }
+    pthread_mutex_unlock(&polling_mutex);
+}
+
+uint32_t mscp_server_base::DispatchCommand(Message* message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError)
 {
     uint32_t cmdStatus = 0;
     switch (header->Word3.Command.Opcode)
@@ -413,10 +881,9 @@ mscp_server_base::Abort()
     INFO("MSCP ABORT");
 
     //
-    // Since we do not reorder messages and in fact pick up and execute
-    // them one at a time, sequentially as they appear in the ring buffer,
+    // Commands of a unit are executed in ring order on the unit's thread;
     // by the time we've gotten this command, the command it's referring
-    // to is long gone.
+    // to is usually gone, or will complete normally.
     // This is semi-legal behavior and it's legal for us to ignore ABORT in this
     // case.
     //
@@ -473,7 +940,7 @@ mscp_server_base::DetermineAccessPaths(
 
 uint32_t
 mscp_server_base::GetCommandStatus(
-    std::shared_ptr<Message> message)
+    Message* message)
 {
     DEBUG_FAST("(T)MSCP GET COMMAND STATUS");
 
@@ -493,8 +960,8 @@ mscp_server_base::GetCommandStatus(
             GetParameterPointer(message));
 
     //
-    // This will always return zero; as with the ABORT command, at this
-    // point the command being referenced has already been executed.
+    // This will always return zero; as with the ABORT command, we do
+    // not track the progress of commands handed to the unit threads.
     //
     params->CommandStatus = 0;
 
@@ -507,7 +974,7 @@ mscp_server_base::GetCommandStatus(
 //
 uint8_t*
 mscp_server_base::GetParameterPointer(
-    std::shared_ptr<Message> message)
+    Message* message)
 {
     // We silence a strict aliasing warning here; this is safe (if perhaps not recommended
     // the general case.)
@@ -520,7 +987,7 @@ mscp_server_base::GetParameterPointer(
 //
 // Reset():
 //  Resets the MSCP server:
-//   - Waits for the polling thread to finish its current work
+//   - Waits for the polling and unit threads to finish their current work
 //   - Releases all drives into the Available state
 //
 void 
@@ -528,18 +995,18 @@ mscp_server_base::Reset(void)
 {
     DEBUG_FAST("Aborting polling due to reset.");
 
+    // Even if the polling thread sleeps, unit threads may still be busy:
+    // the polling thread drains them in any case.
     pthread_mutex_lock(&polling_mutex);
-    if (_pollState != PollingState::Wait)
-    {
-        _pollState = PollingState::InitRestart;
+    _pollState = PollingState::InitRestart;
+    pthread_cond_broadcast(&polling_cond);
 
-        while (_pollState != PollingState::Wait)
-        {
-            pthread_cond_wait(
-                &polling_cond,
-                &polling_mutex);
-        }
-    }  
+    while (_pollState != PollingState::Wait)
+    {
+        pthread_cond_wait(
+            &polling_cond,
+            &polling_mutex);
+    }
     pthread_mutex_unlock(&polling_mutex);
 
     _credits = INIT_CREDITS;
@@ -10,6 +10,8 @@
 
 #include <stdint.h>
 #include <memory>
+#include <deque>
+#include <vector>
 
 namespace mscp {
 
@@ -33,6 +35,17 @@ class Message;
 
 #define HEADER_OFFSET 4
 
+// Command modifier: execute before other commands of the unit
+#define MODIFIER_EXPRESS 0x8000
+
+// Limits of a merged READ or WRITE transfer
+#define MAX_MERGE_COMMANDS 16
+#define MAX_MERGE_BLOCKS 256
+
+// The maximum message length we can handle.  This is provided as a sanity check
+// to prevent parsing clearly invalid commands.
+#define MAX_MESSAGE_LENGTH 0x1000
+
 //
 // ControlMessageHeader encapsulates the standard MSCP control
 // message header: a 12-byte header followed by up to 36 bytes of
@@ -65,10 +78,9 @@ struct ControlMessageHeader
         } End;
     } Word3;
 
-    // M9312 DU boot loader writes invalid big messages sizes.
-    // Temporary patch: enlarge buffer behind all reasonable limits.
-    // uint8_t Parameters[512];
-    uint8_t Parameters[10240];	// overkill
+    // M9312 DU boot loader writes message sizes much bigger than
+    // the actual command; the port accepts up to MAX_MESSAGE_LENGTH.
+    uint8_t Parameters[MAX_MESSAGE_LENGTH - 12];
 };
 #pragma pack(pop)
 
@@ -186,33 +198,73 @@ public:
     void on_init_changed(void) override {}
 
 protected:
-    virtual uint32_t DispatchCommand(const std::shared_ptr<Message> message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError);
+    virtual uint32_t DispatchCommand(Message* message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError);
 
 protected:    
     // Commands common to MSCP and TMSCP with unique implementations:
-    virtual uint32_t Access(std::shared_ptr<Message> message, uint16_t unitNumber) = 0;
+    virtual uint32_t Access(Message* message, uint16_t unitNumber) = 0;
     virtual uint32_t Available(uint16_t unitNumber, uint16_t modifiers) = 0;
-    virtual uint32_t CompareHostData(std::shared_ptr<Message> message, uint16_t unitNumber) = 0;
-    virtual uint32_t Erase(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) = 0;
-    virtual uint32_t GetUnitStatus(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) = 0;
-    virtual uint32_t Online(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) = 0;
-    virtual uint32_t Read(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) = 0;
-    virtual uint32_t SetControllerCharacteristics(std::shared_ptr<Message> message) = 0;
-    virtual uint32_t SetUnitCharacteristics(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) = 0;
-    virtual uint32_t Write(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) = 0;
+    virtual uint32_t CompareHostData(Message* message, uint16_t unitNumber) = 0;
+    virtual uint32_t Erase(Message* message, uint16_t unitNumber, uint16_t modifiers) = 0;
+    virtual uint32_t GetUnitStatus(Message* message, uint16_t unitNumber, uint16_t modifiers) = 0;
+    virtual uint32_t Online(Message* message, uint16_t unitNumber, uint16_t modifiers) = 0;
+    virtual uint32_t Read(Message* message, uint16_t unitNumber, uint16_t modifiers) = 0;
+    virtual uint32_t SetControllerCharacteristics(Message* message) = 0;
+    virtual uint32_t SetUnitCharacteristics(Message* message, uint16_t unitNumber, uint16_t modifiers) = 0;
+    virtual uint32_t Write(Message* message, uint16_t unitNumber, uint16_t modifiers) = 0;
 
 private:    
     // Commands that are MSCP/TMSCP-agnostic:
     uint32_t Abort(void);
     uint32_t DetermineAccessPaths(uint16_t unitNumber);
-    uint32_t GetCommandStatus(std::shared_ptr<Message> message);
+    uint32_t GetCommandStatus(Message* message);
 
 protected:
-    uint8_t* GetParameterPointer(std::shared_ptr<Message> message);
+    //
+    // Command scheduler hooks, used if the port's "seek_order" is set.
+    // GetBlockRange() returns the LBN range of a transfer command;
+    // false if the command may not be reordered.
+    // DispatchMergedTransfer() executes READs or WRITEs of adjacent ranges
+    // as one transfer and returns the status of each; false if they have to
+    // be executed one by one. The image must be unchanged then.
+    //
+    virtual bool GetBlockRange(Message* message, uint32_t* lbn, uint32_t* blockCount);
+    virtual bool DispatchMergedTransfer(const std::vector<Message*>& batch, std::vector<uint32_t>& cmdStatus);
+
+protected:
+    uint8_t* GetParameterPointer(Message* message);
 
     void StartPollingThread(void);
     void AbortPollingThread(void);
 
+private:
+    //
+    // Commands for a unit are executed by a thread of their own, in ring order.
+    // Different units run in parallel.
+    //
+    struct UnitQueue
+    {
+        mscp_server_base* server;
+        bool started;
+        bool busy;          // a command is in execution
+        pthread_t pthread;
+        pthread_cond_t cond;
+        std::deque<Message*> commands;
+        uint32_t headLBN;   // end of last transfer, for seek ordering
+    };
+
+    friend void* unit_worker(void *context);
+    void UnitWorker(UnitQueue* unit);
+    void QueueCommand(Message* message);
+    void StartUnits(void);
+    void ScheduleCommands(UnitQueue* unit, std::vector<Message*>& batch);
+    void ExecuteCommand(Message* message);
+    void ExecuteBatch(std::vector<Message*>& batch);
+    void PostEnd(Message* message, uint32_t cmdStatus, bool protocolError);
+    void DrainUnits(void);
+    void AbortUnitThreads(void);
+    void WakePolling(void);
+
 protected:
     uda_c* _port;
 
@@ -235,6 +287,18 @@ private:
 
     // Credits available
     uint8_t _credits;
+
+    std::vector<UnitQueue> _units;
+    pthread_mutex_t _unitMutex;
+    pthread_cond_t _unitIdleCond;
+
+    // Scheduler statistics, access with _unitMutex
+    uint64_t _mergedTransfers;
+    uint64_t _transfers;
+    uint64_t _transferBlocks;
+
+    // Serializes credit accounting and the response ring
+    pthread_mutex_t _responseMutex;
 };
 
 } // end namespace
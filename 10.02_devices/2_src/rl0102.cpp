@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   sector data access by storage I/O threads
  12-nov-2018  JH      entered beta phase
  */
 
@@ -586,7 +587,8 @@ bool RL0102_c::cmd_read_next_sector_header(uint16_t *buffer, unsigned buffer_siz
 // read next data block from rotating platter
 // then increments "sector_segment_under_heads" to next header
 // controller must address sector by waiting for it with cmd_read_next_sector_header()
-bool RL0102_c::cmd_read_next_sector_data(uint16_t *buffer, unsigned buffer_size_words) 
+bool RL0102_c::cmd_read_next_sector_data(uint16_t *buffer, unsigned buffer_size_words,
+        storagedrive_io_request_c *request) 
 {
     if (state.value != RL0102_STATE_lock_on)
         return false; // wrong state
@@ -606,10 +608,16 @@ bool RL0102_c::cmd_read_next_sector_data(uint16_t *buffer, unsigned buffer_size_
 
     // access image file
     // LSB saved before MSB -> word/byte conversion on ARM (little endian) is easy
-    image_read((uint8_t *) buffer, offset, geometry.sector_size_bytes);
-    DEBUG_FAST("File Read 0x%x words from c/h/s=%d/%d/%d, file pos=0x%llx, words = %06o, %06o, ...",
-          geometry.sector_size_bytes / 2, cylinder, head, sectorno, offset, (unsigned )(buffer[0]),
-          (unsigned )(buffer[1]));
+    if (request) {
+        image_read_async(request, (uint8_t *) buffer, offset, geometry.sector_size_bytes);
+        DEBUG_FAST("File Read 0x%x words from c/h/s=%d/%d/%d, file pos=0x%llx queued",
+              geometry.sector_size_bytes / 2, cylinder, head, sectorno, offset);
+    } else {
+        image_read((uint8_t *) buffer, offset, geometry.sector_size_bytes);
+        DEBUG_FAST("File Read 0x%x words from c/h/s=%d/%d/%d, file pos=0x%llx, words = %06o, %06o, ...",
+              geometry.sector_size_bytes / 2, cylinder, head, sectorno, offset, (unsigned )(buffer[0]),
+              (unsigned )(buffer[1]));
+    }
 
     // circular advance to next header: 40x headers, 40x data
     NEXT_SECTOR_SEGMENT_ADVANCE
@@ -621,7 +629,8 @@ bool RL0102_c::cmd_read_next_sector_data(uint16_t *buffer, unsigned buffer_size_
 // write data for current sector under head
 // then increments "stuff_under_heads" to next header
 // controller must address sector by waiting for it with cmd_read_next_sector_header()
-bool RL0102_c::cmd_write_next_sector_data(uint16_t *buffer, unsigned buffer_size_words) 
+bool RL0102_c::cmd_write_next_sector_data(uint16_t *buffer, unsigned buffer_size_words,
+        storagedrive_io_request_c *request) 
 {
     if (state.value != RL0102_STATE_lock_on)
         return false; // wrong state
@@ -649,7 +658,10 @@ bool RL0102_c::cmd_write_next_sector_data(uint16_t *buffer, unsigned buffer_size
 
     // access image file
     // LSB saved before MSB -> word/byte conversion on ARM (little endian) is easy
-    image_write((uint8_t *) buffer, offset, geometry.sector_size_bytes);
+    if (request)
+        image_write_async(request, (uint8_t *) buffer, offset, geometry.sector_size_bytes);
+    else
+        image_write((uint8_t *) buffer, offset, geometry.sector_size_bytes);
     DEBUG_FAST("File Write 0x%x words from c/h/s=%d/%d/%d, file pos=0x%llx, words = %06o, %06o, ...",
           geometry.sector_size_bytes / 2, cylinder, head, sectorno, offset, (unsigned )(buffer[0]),
           (unsigned )(buffer[1]));
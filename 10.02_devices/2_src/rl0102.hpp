@@ -21,6 +21,7 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   sector data access by storage I/O threads
  12-nov-2018  JH      entered beta phase
  */
 #ifndef _RL0102_HPP_
@@ -174,12 +175,16 @@ public:
 	// wait for next data block from rotating platter, read it,
 	// then increments "next_sector_segment_under_heads" to pos before next header
 	// controller must address sector by waiting for it with cmd_read_next_sector_header()
-	bool cmd_read_next_sector_data(uint16_t *buffer, unsigned buffer_size_words);
+	// with "request": image is read asynchronously, buffer valid after request->wait()
+	bool cmd_read_next_sector_data(uint16_t *buffer, unsigned buffer_size_words,
+			storagedrive_io_request_c *request = nullptr);
 
 	// write data for current sector under head
 	// then increments "stuff_under_heads" to pos before next header
 	// controller must address sector by waiting for it with cmd_read_next_sector_header()
-	bool cmd_write_next_sector_data(uint16_t *buffer, unsigned buffer_size_words);
+	// with "request": image is written asynchronously, buffer in use until request complete
+	bool cmd_write_next_sector_data(uint16_t *buffer, unsigned buffer_size_words,
+			storagedrive_io_request_c *request = nullptr);
 
 	void clear_error_register(void);
 
@@ -21,6 +21,9 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   image access by storage I/O threads, WRITE: image write overlaps next DMA
+ 16-oct-2026  agent   BAE write is "posted"
+ 16-oct-2026  agent   READ: non-blocking DMA, next sector read from disk meanwhile
  12-nov-2018  JH      entered beta phase
 
 
@@ -132,6 +135,9 @@ RL11_c::RL11_c(void) :    storagecontroller_c()
     unsigned i;
 
     state = RL11_STATE_CONTROLLER_READY;
+    silo_read_idx = 0;
+    silo_write_idx = 0;
+    dma_pending = false;
     name.value = "rl"; // only one supported
     type_name.value = "RL11";
     log_label = "rl";
@@ -218,6 +224,7 @@ RLV12_c::RLV12_c(): RL11_c()
     strcpy_s(busreg_BAE->name, sizeof(busreg_BAE->name), "BAE");
     busreg_BAE->active_on_dati = false; // read: just storage
     busreg_BAE->active_on_dato = true; // write: just param change 
+    busreg_BAE->posted_dato = true; // CPU need not wait for it
     busreg_BAE->reset_value = 0;
     busreg_BAE->writable_bits = 0x3f;  // 6 bit read only
 
@@ -756,6 +763,35 @@ void RL11_c::state_seek()
 // perhaps a DATA LATE if previous DMA not ready
 // increment diskaddress, read next sector.
 // disk drive is guaranteed to need time_per_sector_us
+
+// READ: wait for DMA of previous sector, started by state_readwrite().
+// On NXM the registers are set back to that sector and the operation ends.
+// result: false if DMA failed
+bool RL11_c::rw_dma_wait()
+{
+    if (!dma_pending)
+        return true;
+    dma_pending = false;
+    if (dma_request.wait())
+        return true;
+    // if timeout: current addr is addr AFTER illegal address (verified)
+    update_qunibus_address(dma_request.qunibus_end_addr + 2);
+    set_register_dati_value(busreg_DA, dma_pending_disk_address, __func__);
+    set_MP_wordcount(dma_pending_wordcount);
+    error_dma_timeout = true;
+    do_operation_incomplete("RL11_STATE_RW_DISK: dma timeout");
+    return false;
+}
+
+// WRITE: wait until all sector data is in the image.
+// Before every end of a READ/WRITE command, also if aborted:
+// READY and the next command must not see writes in flight.
+void RL11_c::rw_write_wait()
+{
+    write_request[0].wait();
+    write_request[1].wait();
+}
+
 void RL11_c::state_readwrite() 
 {
     RL0102_c *drive = selected_drive();
@@ -770,7 +806,9 @@ void RL11_c::state_readwrite()
         function_code == RL11_CMD_READ_DATA_WITHOUT_HEADER_CHECK || function_code == RL11_CMD_READ_DATA || function_code == RL11_CMD_WRITE_DATA || function_code == RL11_CMD_WRITE_CHECK);
 
     if (!drive->drive_ready_line) {
-        do_operation_incomplete("state_readwrite(): drive not ready"); // verified
+        rw_write_wait();
+        if (rw_dma_wait())
+            do_operation_incomplete("state_readwrite(): drive not ready"); // verified
         return;
     }
 
@@ -779,6 +817,11 @@ void RL11_c::state_readwrite()
         // Entry condition: cmd_wordcount > 0
         // diskaddress DA valid.
 
+        // READ of previous command aborted by INIT: DMA must be complete
+        if (dma_pending) {
+            dma_request.wait();
+            dma_pending = false;
+        }
         // setup controller at start of read operation
         clear_errors();
         if (cmd_wordcount == 0)
@@ -799,6 +842,9 @@ void RL11_c::state_readwrite()
                 // - No spiral read/write: if reading past end of track: sector number is incremented to 40 = 050.
                 //   no track change, no head switch, instead OPI error.
                 // - advance past last sector on track: error OPI
+                if (!rw_dma_wait())
+                    break; // NXM of previous sector reported first
+                rw_write_wait();
                 error_header_not_found = true;
                 do_operation_incomplete("RL11_STATE_RW_DISK: !drive->header_on_track()");
                 break;
@@ -822,15 +868,25 @@ void RL11_c::state_readwrite()
 
         if (function_code == RL11_CMD_READ_DATA
                 || function_code == RL11_CMD_READ_DATA_WITHOUT_HEADER_CHECK) {
-            // the requested sector passes the head: read it into the SILO
-            drive->cmd_read_next_sector_data(silo, 128);
+            // the requested sector passes the head: read it into the free SILO buffer,
+            // by the I/O threads while DMA of the previous sector may still run.
+            uint16_t *read_silo = silo_read[silo_read_idx];
+            drive->cmd_read_next_sector_data(read_silo, 128, &read_request);
+            bool dma_ok = rw_dma_wait();
+            read_request.wait();
             //logger.debug_hexdump(LC_RL, "Read data between disk access and DMA",
-            //		(uint8_t *) silo, sizeof(silo), NULL);
-            // start DMA transmission of SILO into memory
-            qunibusadapter->DMA(dma_request, true, QUNIBUS_CYCLE_DATO, qunibus_address, silo,
-                                dma_wordcount);
-            error_dma_timeout = !dma_request.success;
-            qunibus_address = dma_request.qunibus_end_addr;
+            //		(uint8_t *) read_silo, sizeof(silo), NULL);
+            if (!dma_ok)
+                break; // NXM in previous sector
+            // start DMA transmission of SILO into memory, checked before next sector
+            dma_pending_disk_address = disk_address;
+            dma_pending_wordcount = cmd_wordcount;
+            qunibusadapter->DMA(dma_request, false, QUNIBUS_CYCLE_DATO, qunibus_address,
+                                read_silo, dma_wordcount);
+            dma_pending = true;
+            silo_read_idx ^= 1;
+            // last address, if successful
+            qunibus_address += 2 * (dma_wordcount - 1);
         } else if (function_code == RL11_CMD_WRITE_CHECK) {
             // read sector data to compare with sector data
             drive->cmd_read_next_sector_data(silo, 128);
@@ -842,14 +898,18 @@ void RL11_c::state_readwrite()
             error_dma_timeout = !dma_request.success;
             qunibus_address = dma_request.qunibus_end_addr;
         } else if (function_code == RL11_CMD_WRITE_DATA) {
-            // start DMA transmission of memory into SILO
-            qunibusadapter->DMA(dma_request, true, QUNIBUS_CYCLE_DATI, qunibus_address, silo,
-                                dma_wordcount);
+            // start DMA transmission of memory into the free SILO buffer,
+            // image write of the previous sector may still run.
+            write_request[silo_write_idx].wait();
+            memset((uint8_t *) silo_write[silo_write_idx], 0, sizeof(silo));
+            qunibusadapter->DMA(dma_request, true, QUNIBUS_CYCLE_DATI, qunibus_address,
+                                silo_write[silo_write_idx], dma_wordcount);
             error_dma_timeout = !dma_request.success;
             qunibus_address = dma_request.qunibus_end_addr;
         }
 
         // request_client_DMA() was blocking, DMA processed now.
+        // (READ: still running, error checked by rw_dma_wait())
         // qunibus_address updated to last accesses address
         qunibus_address += 2; // was last address, is now next to fill
         // if timeout: yes, current addr is addr AFTER illegal address (verified)
@@ -857,12 +917,15 @@ void RL11_c::state_readwrite()
 
         if (error_dma_timeout) {
             // NXM condition
+            rw_write_wait();
             do_operation_incomplete("RL11_STATE_RW_WAIT_DMA: dma timeout");
             break;
         }
         if (function_code == RL11_CMD_WRITE_DATA) { // data from SILO to disk
             // write whole silo. if less data read from memory, 00s are filled in.
-            drive->cmd_write_next_sector_data(silo, 128);
+            drive->cmd_write_next_sector_data(silo_write[silo_write_idx], 128,
+                                              &write_request[silo_write_idx]);
+            silo_write_idx ^= 1;
             //logger.debug_hexdump(LC_RL, "Write data between DMA and disk access",
             //		(uint8_t *) silo, sizeof(silo),	NULL);
         } else if (function_code == RL11_CMD_WRITE_CHECK) {
@@ -896,7 +959,9 @@ void RL11_c::state_readwrite()
 
         if (cmd_wordcount == 0) {
             // last sector transfered
-            do_command_done();
+            rw_write_wait(); // READY only when data is in the image
+            if (rw_dma_wait())
+                do_command_done();
             // READY/INTR delayed against end of DMA: nanosleep() in worker()
             break;
         }
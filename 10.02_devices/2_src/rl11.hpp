@@ -21,6 +21,8 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   image access by storage I/O threads, WRITE: image write overlaps next DMA
+ 16-oct-2026  agent   READ: disk access of next sector overlaps DMA of previous
  12-nov-2018  JH      entered beta phase
  */
 #ifndef _RL11_HPP_
@@ -59,6 +61,17 @@ private:
     // data buffer to/from drive
     uint16_t silo[128]; // buffer from/to drive
     uint16_t silo_compare[128]; // memory data to be compared with silo
+    // READ: 2 sector buffers, disk read of next sector overlaps DMA of previous
+    uint16_t silo_read[2][128];
+    unsigned silo_read_idx; // buffer for next disk read
+    bool dma_pending; // non-blocking DMA of previous sector not yet checked
+    uint16_t dma_pending_disk_address; // DA and MP of that sector, restored on NXM
+    uint16_t dma_pending_wordcount;
+    storagedrive_io_request_c read_request; // disk read of next sector
+    // WRITE: 2 sector buffers, image write of previous sector overlaps DMA of next
+    uint16_t silo_write[2][128];
+    unsigned silo_write_idx;
+    storagedrive_io_request_c write_request[2];
 
     // RL11 has one INTR and DMA
     dma_request_c dma_request = dma_request_c(this); // operated by qunibusadapter
@@ -88,6 +101,8 @@ private:
     void change_state_INTR(unsigned new_state);
     void state_seek(void);
     void state_readwrite(void);
+    bool rw_dma_wait(void);
+    void rw_write_wait(void);
 
     void connect_to_panel(void);
     void disconnect_from_panel(void);
@@ -34,6 +34,8 @@
   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+  16-oct-2026 agent   home block checksum on bulk words
+  16-oct-2026 agent   home block and directory parsed on views of image data
   06-jan-2022 JH      created
 
  */
@@ -548,10 +550,10 @@ void filesystem_rt11_c::stream_parse_blocks(rt11_stream_c *stream, rt11_blocknr_
 }
 
 // get bytes from loaded buffer
-void filesystem_rt11_c::stream_parse_bytes(rt11_stream_c *stream, rt11_blocknr_t start_block_nr, uint8_t *data, unsigned byte_count)
+void filesystem_rt11_c::stream_parse_bytes(rt11_stream_c *stream, rt11_blocknr_t start_block_nr, const uint8_t *data, unsigned byte_count)
 {
     stream->start_block_nr = start_block_nr;
-    memcpy(stream->data_ptr(), data, byte_count) ;
+    stream->set_data(data, byte_count) ;
     // stream not imported from host
     assert(stream->host_path.empty())  ;
     stream->host_path = stream->get_host_path() ;
@@ -777,20 +779,22 @@ void filesystem_rt11_c::parse_internal_blocks_to_file(std::string _basename, std
 bool filesystem_rt11_c::parse_homeblock()
 {
     uint16_t w;
-    uint8_t *s ;
+    const uint8_t *s ;
 
-    // work on cache
+    // work on image data, or cache
     byte_buffer_c block_buffer(endianness_pdp11) ;
-    image_partition->get_blocks(&block_buffer, 1, 1) ; // work on single block 1
+    byte_buffer_view_c block = image_partition->get_blocks_view(&block_buffer, 1, 1) ; // work on single block 1
 
     // first, verify home block
     bool all_zero = true ;
     unsigned actual_chksum = 0;
-    homeblock_chksum = block_buffer.get_word_at_byte_offset(0776);
+    std::vector<uint16_t> words(get_block_size() / 2) ;
+    block.get_words_at_word_offset(0, words.data(), words.size()) ;
+    homeblock_chksum = words.back() ;
 
     // verify checksum.
-    for (unsigned i = actual_chksum = 0; i < get_block_size()-2; i += 2) {
-        w = block_buffer.get_word_at_byte_offset(i);
+    for (unsigned i = 0; i < words.size()-1; i++) {
+        w = words[i] ;
         actual_chksum += w ;
         if (w != 0)
             all_zero = false ;
@@ -814,27 +818,27 @@ bool filesystem_rt11_c::parse_homeblock()
     // INIT/RESTORE area: ignore
     // BUP ignored
 
-    pack_cluster_size = block_buffer.get_word_at_byte_offset(0722);
-    w = block_buffer.get_word_at_byte_offset(0724);
+    pack_cluster_size = block.get_word_at_byte_offset(0722);
+    w = block.get_word_at_byte_offset(0724);
     if (w != 6)
         throw filesystem_exception("parse_homeblock(): first_dir_blocknr expected 6, is %d", (int)w);
     first_dir_blocknr = w ;
-    w = block_buffer.get_word_at_byte_offset(0726);
+    w = block.get_word_at_byte_offset(0726);
     system_version = rad50_decode(w);
     // 12 char volume id. V3A, or V05, ...
     char buffer[13] ;
-    s = &block_buffer[0730] ;
-    strncpy(buffer, (char *)s, 12);
+    s = block.data_ptr() + 0730 ;
+    strncpy(buffer, (const char *)s, 12);
     buffer[12] = 0;
     volume_id = std::string(buffer) ;
     // 12 char owner name
-    s = &block_buffer[0744] ;
-    strncpy(buffer, (char *)s, 12);
+    s = block.data_ptr() + 0744 ;
+    strncpy(buffer, (const char *)s, 12);
     buffer[12] = 0;
     owner_name = std::string(buffer) ;
     // 12 char system id
-    s = &block_buffer[0760] ;
-    strncpy(buffer, (char *)s, 12);
+    s = block.data_ptr() + 0760 ;
+    strncpy(buffer, (const char *)s, 12);
     buffer[12] = 0;
     system_id = std::string(buffer) ;
 
@@ -862,27 +866,27 @@ void filesystem_rt11_c::parse_directory()
     /*** iterate directory segments ***/
     used_file_blocks = 0;
     free_blocks = 0;
-    byte_buffer_c block_buffer(endianness_pdp11) ;
+    byte_buffer_c block_buffer(endianness_pdp11) ; // if image data not in memory
 
     ds_nr = 1;
-    image_partition->get_blocks(&block_buffer, DIR_SEGMENT_BLOCK_NR(ds_nr), 2) ; // init with 1st seg = 2 blocks
+    byte_buffer_view_c segment = image_partition->get_blocks_view(&block_buffer, DIR_SEGMENT_BLOCK_NR(ds_nr), 2) ; // init with 1st seg = 2 blocks
     do {
         // DEC WORD # : 1	2	3	4	5	6	7  8
         // Byte offset: 0	2	4	6	8  10  12  14
         // read 5 word directory segment header
-        w = block_buffer.get_word_at_byte_offset(0) ; // word #1 total num of segments
+        w = segment.get_word_at_byte_offset(0) ; // word #1 total num of segments
         if (ds_nr == 1)
             dir_total_seg_num = w;
         else if (w != dir_total_seg_num)
             throw filesystem_exception("parse_directory(): ds_header_total_seg_num in entry %d different from entry 1", ds_nr);
         if (ds_nr == 1)
-            dir_max_used_seg_nr = block_buffer.get_word_at_byte_offset(4); // word #3
-        ds_next_nr = block_buffer.get_word_at_byte_offset(2); // word #2 nr of next segment
+            dir_max_used_seg_nr = segment.get_word_at_byte_offset(4); // word #3
+        ds_next_nr = segment.get_word_at_byte_offset(2); // word #2 nr of next segment
         if (ds_next_nr > dir_max_used_seg_nr)
             throw filesystem_exception("parse_directory(): next segment nr %d > maximum %d", ds_next_nr, dir_max_used_seg_nr);
-        de_data_blocknr = block_buffer.get_word_at_byte_offset(8); // word #5 block of data start
+        de_data_blocknr = segment.get_word_at_byte_offset(8); // word #5 block of data start
         if (ds_nr == 1) {
-            dir_entry_extra_bytes = block_buffer.get_word_at_byte_offset(6); // word #4: extra bytes
+            dir_entry_extra_bytes = segment.get_word_at_byte_offset(6); // word #4: extra bytes
             file_space_blocknr = de_data_blocknr; // 1st dir entry
         }
         //
@@ -891,10 +895,10 @@ void filesystem_rt11_c::parse_directory()
         de_len = 14 + dir_entry_extra_bytes ;
         de_nr = 0;
         de_offset = 10; // 1st entry 5 words after segment start
-        while (!(block_buffer.get_word_at_byte_offset(de_offset) & RT11_DIR_EEOS)) { // end of segment?
-            uint16_t de_status = block_buffer.get_word_at_byte_offset(de_offset); // word #1 status
+        while (!(segment.get_word_at_byte_offset(de_offset) & RT11_DIR_EEOS)) { // end of segment?
+            uint16_t de_status = segment.get_word_at_byte_offset(de_offset); // word #1 status
             if (de_status & RT11_FILE_EMPTY) { // skip empty entries
-                w = block_buffer.get_word_at_byte_offset(de_offset + 8); // word #5: file len
+                w = segment.get_word_at_byte_offset(de_offset + 8); // word #5: file len
                 free_blocks += w;
             } else if (de_status & RT11_FILE_EPERM) { // only permanent files
                 // new file! read dir entry
@@ -903,24 +907,24 @@ void filesystem_rt11_c::parse_directory()
                 // basename and ext WITHOUT leading spaces
                 std::string s ;
                 // basename: 6 chars
-                w = block_buffer.get_word_at_byte_offset(de_offset + 2); // word #2
+                w = segment.get_word_at_byte_offset(de_offset + 2); // word #2
                 s.assign(rad50_decode(w)) ;
-                w = block_buffer.get_word_at_byte_offset(de_offset + 4); // word #3
+                w = segment.get_word_at_byte_offset(de_offset + 4); // word #3
                 s.append(rad50_decode(w)) ;
                 f->basename = rtrim_copy(s) ; // " EMPTY.FIL" has leading space
                 // extension: 3 chars
-                w = block_buffer.get_word_at_byte_offset(de_offset + 6); // word #4
+                w = segment.get_word_at_byte_offset(de_offset + 6); // word #4
                 s.assign(rad50_decode(w)) ;
                 f->ext = rtrim_copy(s) ;
 
                 // blocks in data stream
                 f->block_nr = de_data_blocknr; // startblock on disk
-                f->block_count = block_buffer.get_word_at_byte_offset(de_offset + 8); // word #5 file len
+                f->block_count = segment.get_word_at_byte_offset(de_offset + 8); // word #5 file len
                 used_file_blocks += f->block_count;
                 // fprintf(stderr, "parse %s.%s, %d blocks @ %d\n", f->basename, f->ext,	f->block_count, f->block_nr);
                 // ignore job/channel
                 // creation date
-                w = block_buffer.get_word_at_byte_offset(de_offset + 12); // word #7
+                w = segment.get_word_at_byte_offset(de_offset + 12); // word #7
                 // 5 bit year, 2 bit "age". Year since 1972
                 // date "0" is possible, then no display in DIR output
 
@@ -944,7 +948,7 @@ void filesystem_rt11_c::parse_directory()
 
                     stream_parse_bytes(f->stream_dir_ext, // word #8 extra words
                                        DIR_SEGMENT_BLOCK_NR(ds_nr), // current dir block
-                                       block_buffer.data_ptr() + de_offset + 14, dir_entry_extra_bytes) ;
+                                       segment.data_ptr() + de_offset + 14, dir_entry_extra_bytes) ;
                     // generate only a stream if any bytes set <> 00
                     if (f->stream_dir_ext->is_zero_data(0)) {
                         delete f->stream_dir_ext;
@@ -955,7 +959,7 @@ void filesystem_rt11_c::parse_directory()
             }
 
             // advance file start block in data area, also for empty entries
-            de_data_blocknr += block_buffer.get_word_at_byte_offset(de_offset + 8); // word 4 total file len
+            de_data_blocknr += segment.get_word_at_byte_offset(de_offset + 8); // word 4 total file len
 
             // next dir entry
             de_nr++;
@@ -966,7 +970,7 @@ void filesystem_rt11_c::parse_directory()
 
         // next segment, 2 blocks into cache
         ds_nr = ds_next_nr;
-        image_partition->get_blocks(&block_buffer, DIR_SEGMENT_BLOCK_NR(ds_nr), 2) ;
+        segment = image_partition->get_blocks_view(&block_buffer, DIR_SEGMENT_BLOCK_NR(ds_nr), 2) ;
     } while (ds_nr > 0);
 }
 
@@ -986,16 +990,16 @@ void filesystem_rt11_c::parse_file_data()
         if (f->status & RT11_FILE_EPRE) {
             byte_buffer_c block_buffer ;
             // load 1st block for block count
-            image_partition->get_blocks(&block_buffer, f->block_nr, 1) ;
-            prefix_block_count = *block_buffer.data_ptr();// first byte in block
+            byte_buffer_view_c prefix = image_partition->get_blocks_view(&block_buffer, f->block_nr, 1) ;
+            prefix_block_count = prefix[0];// first byte in block
             // 2nd load: all blocks
-            image_partition->get_blocks(&block_buffer, f->block_nr, prefix_block_count) ;
+            prefix = image_partition->get_blocks_view(&block_buffer, f->block_nr, prefix_block_count) ;
             // DEC: low byte of first word = blockcount
             assert(f->stream_prefix == nullptr);
 
             f->stream_prefix = new rt11_stream_c(f, RT11_STREAMNAME_PREFIX);
             // stream is everything behind first word: subtract 1st word from size
-            stream_parse_bytes(f->stream_prefix, f->block_nr, block_buffer.data_ptr()+2, block_buffer.size() - 2);
+            stream_parse_bytes(f->stream_prefix, f->block_nr, prefix.data_ptr()+2, prefix.size() - 2);
         } else
             prefix_block_count = 0;
 
@@ -1256,8 +1260,10 @@ void filesystem_rt11_c::render_homeblock()
     strcpy((char *)s, tmp.append(12-tmp.length(), ' ').c_str()) ;
 
     // build checksum over all words
-    for (sum = i = 0; i < 0776; i += 2)
-        sum += block_buffer.get_word_at_byte_offset(i);
+    uint16_t words[0776 / 2] ;
+    block_buffer.get_words_at_byte_offset(0, words, 0776 / 2) ;
+    for (sum = i = 0; i < 0776 / 2; i++)
+        sum += words[i] ;
     sum &= 0xffff;
     homeblock_chksum = sum;
     block_buffer.set_word_at_byte_offset(0776, sum);
@@ -33,6 +33,7 @@
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+  16-oct-2026 agent   parse on byte_buffer_view_c
   06-jan-2022 JH      created
  */
 #ifndef _SHAREDFILESYSTEM_RT11_HPP_
@@ -206,7 +207,7 @@ private:
     }
 
     void stream_parse_blocks(rt11_stream_c *stream, rt11_blocknr_t start_block_nr, unsigned block_count) ;
-    void stream_parse_bytes(rt11_stream_c *stream, rt11_blocknr_t start_block_nr, uint8_t *data, unsigned byte_count) ;
+    void stream_parse_bytes(rt11_stream_c *stream, rt11_blocknr_t start_block_nr, const uint8_t *data, unsigned byte_count) ;
 
 //    void stream_parse_blocks(rt11_stream_c *stream, rt11_blocknr_t start, uint32_t byte_offset, uint32_t data_size) ;
 //    void stream_render(rt11_stream_c *stream) ;
@@ -33,6 +33,8 @@
   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+  16-oct-2026 agent   bitmap flags as bulk words
+  16-oct-2026 agent   linked blocks moved into list, with their own block number
   06-jan-2022 JH      created from tu58fs
 
  The logical structure of the DOS-11 file system
@@ -136,15 +138,15 @@ void xxdp_linked_block_list_c::add_empty_blocks(xxdp_block_nr_list_c *block_nr_l
 // bytes 0,1 = 1st word in block are # of next. Last blck has link "0".
 void xxdp_linked_block_list_c::load_from_image(xxdp_blocknr_t start_block_nr)
 {
-    xxdp_linked_block_c block(filesystem, start_block_nr) ;
     xxdp_blocknr_t block_nr = start_block_nr;
     clear() ;
     do {
         // load block by block, follow links
+        xxdp_linked_block_c block(filesystem, block_nr) ;
         filesystem->image_partition->get_blocks(&block, block_nr, 1) ;
-        push_back(block) ;
         // follow link to next block
         block_nr = block.get_next_block_nr();
+        push_back(std::move(block)) ; // no copy of block data
     } while (size() < XXDP_MAX_BLOCKS_PER_LIST && block_nr > 0);
     if (block_nr > 0)
         throw filesystem_exception("xxdp_linked_block_list_c::load_from_image(): block list too long or recursion");
@@ -264,9 +266,14 @@ int xxdp_bitmap_c::used_block_count()
     int result = 0;
     for (unsigned i = 0; i < block_list.size(); i++) {
         xxdp_linked_block_c *map_block = &block_list[i];
-        unsigned map_wordcount = map_block->get_word_at_byte_offset(2) ;
+        unsigned map_wordcount = map_block->get_word_at_word_offset(2) ;
+        // image data, may be corrupt
+        if (map_wordcount > XXDP_BITMAP_WORDS_PER_MAP)
+            map_wordcount = XXDP_BITMAP_WORDS_PER_MAP ;
+        uint16_t map_flags_words[XXDP_BITMAP_WORDS_PER_MAP] ;
+        map_block->get_words_at_word_offset(4, map_flags_words, map_wordcount) ;
         for (unsigned j = 0; j < map_wordcount; j++) {
-            uint16_t map_flags = map_block->get_word_at_byte_offset(j + 4);
+            uint16_t map_flags = map_flags_words[j] ;
             // 16 flags per word. count "1" bits
             if (map_flags == 0xffff)
                 result += 16; // most of time
@@ -1192,6 +1199,9 @@ void filesystem_xxdp_c::parse_bitmap()
         assert(bitmap_number == i+1) ; // number of this bitmap block starting at 1
 
         uint16_t bitmap_used_words_count = bitmap_block->get_word_at_word_offset(2);  // always 60 ?
+        if (bitmap_used_words_count > XXDP_BITMAP_WORDS_PER_MAP)
+            throw filesystem_exception("Bitmap block %u: %u flag words, max %d", (unsigned)bitmap_block->get_block_nr(),
+                                       (unsigned)bitmap_used_words_count, XXDP_BITMAP_WORDS_PER_MAP);
         assert(bitmap_used_words_count == XXDP_BITMAP_WORDS_PER_MAP);
 
         // verify link to 1st bitmap bitmap_block
@@ -1199,8 +1209,10 @@ void filesystem_xxdp_c::parse_bitmap()
         assert(bitmap_first_block_nr == bitmap.block_list[0].get_block_nr()) ;
 
         // hexdump(flog, get_block_size() * map_blknr, 512, "Block %u = bitmap %u", map_blknr, i);
+        uint16_t bitmap_flags_words[XXDP_BITMAP_WORDS_PER_MAP] ;
+        bitmap_block->get_words_at_word_offset(4, bitmap_flags_words, bitmap_used_words_count) ;
         for (unsigned j = 0; j < bitmap_used_words_count; j++) {
-            uint16_t bitmap_flags = bitmap_block->get_word_at_word_offset(j + 4);
+            uint16_t bitmap_flags = bitmap_flags_words[j] ;
             // 16 flags per word. LSB = lowest blocknr
             for (unsigned k = 0; k < 16; k++) {
                 assert(image_block_nr == (i * XXDP_BITMAP_WORDS_PER_MAP + j) * 16 + k);
@@ -1465,31 +1477,24 @@ void filesystem_xxdp_c::render_bitmap()
 {
     assert(bitmap.block_list.size() > 0) ;
     xxdp_blocknr_t first_block_nr = bitmap.block_list[0].get_block_nr();
-    xxdp_blocknr_t image_block_nr;
+    xxdp_blocknr_t image_block_nr = 0 ;
 
-    for (image_block_nr = 0; image_block_nr < blockcount; image_block_nr++) {
-        // which bitmap block resides the flag in?
-        int bitmap_block_idx = image_block_nr / (XXDP_BITMAP_WORDS_PER_MAP * 16); // # in list
+    // each bitmap block holds the flags of 960 consecutive image blocks
+    for (unsigned bitmap_block_idx = 0; image_block_nr < blockcount; bitmap_block_idx++) {
+        assert(bitmap_block_idx < bitmap.block_list.size()) ;
         xxdp_linked_block_c *bitmap_block = &bitmap.block_list[bitmap_block_idx];
-        // bit index of this image block in whole bitmap block
-        int bitmap_block_bit_nr = image_block_nr % (XXDP_BITMAP_WORDS_PER_MAP * 16);
-
-        // set metadata for the whole bitmap block only if first flag is processed
-        if (bitmap_block_bit_nr == 0) {
-            bitmap_block->set_word_at_word_offset(1, bitmap_block_idx + 1); // "map number": enumerates map blocks
-            bitmap_block->set_word_at_word_offset(2, XXDP_BITMAP_WORDS_PER_MAP); // always 060
-            bitmap_block->set_word_at_word_offset(3, first_block_nr); // "link to first map"
-        }
-
-        // set a single block flag
-        if (bitmap.used[image_block_nr]) {
-            // word and bit in this block containing the flag
-            int bitmap_block_flags_nr = bitmap_block_bit_nr / 16;
-            int bitmap_block_flags_bitpos = bitmap_block_bit_nr % 16;
-            uint16_t bitmap_flags = bitmap_block->get_word_at_word_offset(bitmap_block_flags_nr + 4);
-            bitmap_flags |= (1 << bitmap_block_flags_bitpos);
-            bitmap_block->set_word_at_word_offset(bitmap_block_flags_nr + 4, bitmap_flags);
-        }
+        bitmap_block->set_word_at_word_offset(1, bitmap_block_idx + 1); // "map number": enumerates map blocks
+        bitmap_block->set_word_at_word_offset(2, XXDP_BITMAP_WORDS_PER_MAP); // always 060
+        bitmap_block->set_word_at_word_offset(3, first_block_nr); // "link to first map"
+
+        // collect the flags, then write all words at once
+        uint16_t bitmap_flags_words[XXDP_BITMAP_WORDS_PER_MAP] ;
+        bitmap_block->get_words_at_word_offset(4, bitmap_flags_words, XXDP_BITMAP_WORDS_PER_MAP) ;
+        for (unsigned bit_nr = 0; bit_nr < XXDP_BITMAP_WORDS_PER_MAP * 16 && image_block_nr < blockcount;
+                bit_nr++, image_block_nr++)
+            if (bitmap.used[image_block_nr])
+                bitmap_flags_words[bit_nr / 16] |= (1 << (bit_nr % 16));
+        bitmap_block->set_words_at_word_offset(4, bitmap_flags_words, XXDP_BITMAP_WORDS_PER_MAP) ;
     }
     bitmap.block_list.write_to_image() ;
 }
@@ -33,6 +33,7 @@
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+  16-oct-2026 agent   get_blocks_view(), interleaved sectors without copy
   03-nov-2022 JH      created
 
   A partition is a sub-area on a disk/tape image.
@@ -245,19 +246,25 @@ void storageimage_partition_c::get_blocks(byte_buffer_c *byte_buffer, uint32_t _
 
     byte_buffer->set_size(_block_count * block_size) ;
     uint8_t *wp = byte_buffer->data_ptr() ;
-    byte_buffer_c sector_buffer ;
-    sector_buffer.set_size(sector_size) ;
 
     // concat all sectors in non-linear order to buffer
     for (unsigned i=0 ; i < phy_sector_nrs.size() ; i++) {
-        // read data into sector buffer, then copy to result
         uint64_t imgpos = get_image_position_from_physical_sector_nr(phy_sector_nrs[i]) ;
-        image->get_bytes(&sector_buffer, imgpos, sector_size) ;
-        memcpy(wp, sector_buffer.data_ptr(), sector_size) ;
+        image->read(wp, imgpos, sector_size) ;
         wp += sector_size ;
     }
 }
 
+// read-only view on partition blocks, for parsing.
+// Without interleave directly on image memory if possible, else blocks are read into "byte_buffer".
+byte_buffer_view_c storageimage_partition_c::get_blocks_view(byte_buffer_c *byte_buffer, uint32_t _start_block_nr, uint32_t _block_count) const
+{
+    if (! is_interleaved() )
+        return image->get_bytes_view(byte_buffer, image_position + _start_block_nr * block_size, _block_count * block_size) ;
+    get_blocks(byte_buffer, _start_block_nr, _block_count) ;
+    return byte_buffer_view_c(*byte_buffer) ;
+}
+
 // write partition blocks to a buffer
 void storageimage_partition_c::set_blocks(byte_buffer_c *byte_buffer, uint32_t _start_block_nr)
 {
@@ -277,15 +284,11 @@ void storageimage_partition_c::set_blocks(byte_buffer_c *byte_buffer, uint32_t _
 
     assert(phy_sector_nrs.size() * image->drive->geometry.sector_size_bytes == _block_count * block_size) ;
 
-    // concat all sectors in non-linear order to buffer
+    // scatter buffer to sectors in non-linear order
     uint8_t *rp = byte_buffer->data_ptr() ;
-    byte_buffer_c sector_buffer ;
-    sector_buffer.set_size(sector_size) ;
-
     for (unsigned i=0 ; i < phy_sector_nrs.size() ; i++) {
-        memcpy(sector_buffer.data_ptr(), rp, sector_size) ;
         uint64_t imgpos = get_image_position_from_physical_sector_nr(phy_sector_nrs[i]) ;
-        image->set_bytes(&sector_buffer, imgpos) ;
+        image->write(rp, imgpos, sector_size) ;
         rp += sector_size ;
     }
 }
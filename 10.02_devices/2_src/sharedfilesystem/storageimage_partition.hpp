@@ -33,6 +33,7 @@
   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
+  16-oct-2026 agent   get_blocks_view()
   03-nov-2022 JH      created
 
   A partition is a sub-area on a disk/tape image.
@@ -116,6 +117,7 @@ public:
     std::vector<unsigned> get_physical_sector_nrs_from_blocks(uint32_t _start_block_nr, uint32_t _block_count) const ;
 
     void get_blocks(byte_buffer_c *byte_buffer, uint32_t _start_block_nr, uint32_t _block_count) const ;
+    byte_buffer_view_c get_blocks_view(byte_buffer_c *byte_buffer, uint32_t _start_block_nr, uint32_t _block_count) const ;
     void set_blocks(byte_buffer_c *byte_buffer, uint32_t _start_block_nr) ;
 
     void set_blocks_zero(uint32_t _start_block_nr, uint32_t _block_count) ; // clear area
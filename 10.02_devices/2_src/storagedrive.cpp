@@ -21,6 +21,13 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026  agent   image snapshots
+ 16-oct-2026  agent   read-ahead track buffer
+ 16-oct-2026  agent   asynchronous image I/O
+ 16-oct-2026  agent   copy-on-write overlay image, image_lock
+ 16-oct-2026  agent   "chunked:" compressed sparse images
+ 16-oct-2026  agent   write-back image cache
+ 16-oct-2026  agent   "mmap:" images, param "image_sync", image_block_ptr()
  may-2019		JD		file_size()
  12-nov-2018  JH      entered beta phase
 
@@ -29,9 +36,21 @@
  supports the "attach" command.
 
  The image maybe an plain binary file, or a shared host directory holding an unpacked DEC filesystem.
+ A binary file with "mmap:" prefix is mapped into memory.
+ With "chunked:" prefix the image is a sparse file of compressed chunks.
+ With "image_overlay" set, the image is only read and changes go to an overlay file.
+ With "cache_blocks" set, any image is accessed over a write-back cache.
+ The first snapshot puts a change tracking layer between overlay and cache.
+ With "readahead" set, a read miss loads the whole track (or n sectors)
+ into a buffer, so sequential sector reads of the controller are served from memory.
+
+ Controller threads, menu and image threads use the image in parallel.
+ "image_lock" is held shared for every image access,
+ and exclusive while the layer stack (cache, snapshot, overlay) or the image changes.
  */
 #include <assert.h>
 
+#include <algorithm>
 #include <fstream>
 #include <ios>
 
@@ -58,6 +77,19 @@ storagedrive_c::storagedrive_c(storagecontroller_c *_controller) :
      */
 
     image = nullptr ; // create on parameter setting
+    pthread_rwlock_init(&image_lock, NULL) ;
+    image_sync.value = "close" ;
+    cache_blocks.value = 0 ;
+    cache_flush_period.value = 1000 ;
+    cache_hit_ratio.value = 0 ;
+    cache_dirty_blocks.value = 0 ;
+    cache_flush_latency.value = 0 ;
+    pthread_mutex_init(&readahead_mutex, NULL) ;
+    readahead.value = 0 ;
+    readahead_position = 0 ;
+    readahead_len = 0 ;
+    readahead_hits = readahead_misses = 0 ;
+    readahead_hit_ratio.value = 0 ;
     // or pure "shared" directory, or syncronizing share<->binary image
 
     // default: shared filesystem not (yet) implementable for this disk type (MSCP)
@@ -67,6 +99,7 @@ storagedrive_c::storagedrive_c(storagecontroller_c *_controller) :
 storagedrive_c::~storagedrive_c() 
 {
     image_delete() ;
+    pthread_rwlock_destroy(&image_lock) ;
 }
 
 // control readonly status of all image-relevant parameters
@@ -75,6 +108,7 @@ void storagedrive_c::image_params_readonly(bool readonly)
     image_filepath.readonly = readonly ;
     image_filesystem.readonly = readonly ;
     image_shareddir.readonly = readonly ;
+    image_overlay_filepath.readonly = readonly ;
 }
 
 bool storagedrive_c::image_is_param(parameter_c *param) 
@@ -87,20 +121,236 @@ bool storagedrive_c::image_is_param(parameter_c *param)
 // implements params, so must handle "change"
 bool storagedrive_c::on_param_changed(parameter_c *param) 
 {
+    if (param == &image_sync) {
+        enum storageimage_mmap_c::sync_policy_e sync_policy ;
+        if (!image_sync_policy(image_sync.new_value, &sync_policy)) {
+            ERROR("image_sync must be \"close\", \"async\" or \"write\"");
+            return false;
+        }
+        pthread_rwlock_rdlock(&image_lock) ;
+        storageimage_mmap_c *mmap_image = dynamic_cast<storageimage_mmap_c *>(image) ;
+        if (mmap_image != nullptr)
+            mmap_image->sync_policy = sync_policy ;
+        pthread_rwlock_unlock(&image_lock) ;
+    } else if (param == &image_overlay_filepath) {
+        if (image_is_open()) {
+            ERROR("image_overlay can not be changed while image is in use");
+            return false;
+        }
+        pthread_rwlock_wrlock(&image_lock) ;
+        image_cache_setup(0) ;
+        image_overlay_setup(image_overlay_filepath.new_value) ;
+        image_cache_setup(cache_blocks.value) ;
+        pthread_rwlock_unlock(&image_lock) ;
+    } else if (param == &cache_blocks) {
+        // image threads may access the cache
+        if (image_is_open()) {
+            ERROR("cache_blocks can not be changed while image is in use");
+            return false;
+        }
+        pthread_rwlock_wrlock(&image_lock) ;
+        image_cache_setup(cache_blocks.new_value) ;
+        pthread_rwlock_unlock(&image_lock) ;
+    } else if (param == &cache_flush_period) {
+        pthread_rwlock_rdlock(&image_lock) ;
+        if (image_cache != nullptr)
+            image_cache->flush_period_ms = cache_flush_period.new_value ;
+        pthread_rwlock_unlock(&image_lock) ;
+    } else if (param == &readahead) {
+        readahead_invalidate() ;
+        readahead_hits = readahead_misses = 0 ;
+        readahead_hit_ratio.value = 0 ;
+    }
     // no own "enable" logic
     return device_c::on_param_changed(param);
 }
 
-// free image, todo: atomic via mutex
+// decode "image_sync" param
+bool storagedrive_c::image_sync_policy(std::string sync_paramval, enum storageimage_mmap_c::sync_policy_e *sync_policy)
+{
+    if (!strcasecmp(sync_paramval.c_str(), "close"))
+        *sync_policy = storageimage_mmap_c::sync_close ;
+    else if (!strcasecmp(sync_paramval.c_str(), "async"))
+        *sync_policy = storageimage_mmap_c::sync_async ;
+    else if (!strcasecmp(sync_paramval.c_str(), "write"))
+        *sync_policy = storageimage_mmap_c::sync_write ;
+    else
+        return false ;
+    return true ;
+}
+
+// free image, after all other threads have finished their access
 void storagedrive_c::image_delete() 
+{
+    image_io_wait() ; // I/O threads need image_lock
+    pthread_rwlock_wrlock(&image_lock) ;
+    image_delete_locked() ;
+    pthread_rwlock_unlock(&image_lock) ;
+}
+
+// caller holds image_lock exclusive
+void storagedrive_c::image_delete_locked()
 {
     if (image == nullptr)
         return ;
+    readahead_invalidate() ;
     storageimage_base_c *tmpimage = image ;
-    image = nullptr ; // semi-atomic
+    image = nullptr ;
+    image_cache = nullptr ; // deleted with image
+    image_snapshot = nullptr ;
+    image_overlay = nullptr ;
     delete tmpimage ;
 }
 
+// put a write-back cache of "block_count" blocks in front of the image,
+// or remove it with block_count = 0. Image keeps open state.
+// Caller holds image_lock exclusive.
+void storagedrive_c::image_cache_setup(unsigned block_count)
+{
+    if (image_cache != nullptr) {
+        storageimage_cache_c *tmpcache = image_cache ;
+        image = image_cache->release_backend() ;
+        image_cache = nullptr ;
+        delete tmpcache ;
+    }
+    if (block_count > 0 && image != nullptr) {
+        image_cache = new storageimage_cache_c(image, block_count) ;
+        image_cache->log_level_ptr = log_level_ptr ; // same log level as drive
+        image_cache->flush_period_ms = cache_flush_period.value ;
+        image_cache->drive = this ;
+        image = image_cache ;
+    }
+    image_cache_statistics_update() ;
+}
+
+// put an overlay with "delta_fname" over the image, or remove it with empty name.
+// Must be below the cache. Caller holds image_lock exclusive.
+void storagedrive_c::image_overlay_setup(std::string delta_fname)
+{
+    assert(image_cache == nullptr) ;
+    readahead_invalidate() ; // other data visible now
+    image_snapshot_setup(false) ;
+    if (image_overlay != nullptr) {
+        storageimage_overlay_c *tmpoverlay = image_overlay ;
+        image = image_overlay->release_base() ;
+        image_overlay = nullptr ;
+        delete tmpoverlay ;
+    }
+    if (!delta_fname.empty() && image != nullptr) {
+        image_overlay = new storageimage_overlay_c(image, delta_fname) ;
+        image_overlay->log_level_ptr = log_level_ptr ; // same log level as drive
+        image_overlay->drive = this ;
+        image = image_overlay ;
+    }
+}
+
+// put snapshot change tracking over the image, or remove it.
+// Removing completes snapshot files. Must be below the cache.
+// Caller holds image_lock exclusive.
+void storagedrive_c::image_snapshot_setup(bool enable)
+{
+    assert(image_cache == nullptr) ;
+    if (image_snapshot != nullptr) {
+        storageimage_snapshot_c *tmpsnapshot = image_snapshot ;
+        image = image_snapshot->release_backend() ;
+        image_snapshot = nullptr ;
+        delete tmpsnapshot ;
+    }
+    if (enable && image != nullptr) {
+        image_snapshot = new storageimage_snapshot_c(image) ;
+        image_snapshot->log_level_ptr = log_level_ptr ; // same log level as drive
+        image_snapshot->drive = this ;
+        image = image_snapshot ;
+    }
+}
+
+// snapshot "snapshot_name" is saved to "<image>.<snapshot_name>.snap"
+std::string storagedrive_c::image_snapshot_fname(std::string snapshot_name)
+{
+    std::string image_path = image_filepath.value ;
+    for (std::string prefix : { "mmap:", "chunked:" })
+        if (image_path.compare(0, prefix.size(), prefix) == 0)
+            image_path = image_path.substr(prefix.size()) ;
+    return image_path + "." + snapshot_name + ".snap" ;
+}
+
+// cache state to parameters
+void storagedrive_c::image_cache_statistics_update(void)
+{
+    if (image_cache == nullptr) {
+        cache_hit_ratio.value = 0 ;
+        cache_dirty_blocks.value = 0 ;
+        return ;
+    }
+    uint64_t accesses = image_cache->hits + image_cache->misses ;
+    cache_hit_ratio.value = accesses ? (double)image_cache->hits / accesses : 0 ;
+    cache_dirty_blocks.value = image_cache->dirty_count ;
+    cache_flush_latency.value = image_cache->last_flush_us ;
+}
+
+// read over the read-ahead buffer. On miss fill it with the track of "position",
+// or "readahead" sectors starting at "position".
+void storagedrive_c::readahead_read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    pthread_mutex_lock(&readahead_mutex) ;
+    if (readahead_len > 0 && position >= readahead_position
+            && position + len <= readahead_position + readahead_len) {
+        readahead_hits++ ;
+        memcpy(buffer, readahead_buffer.data() + (position - readahead_position), len) ;
+        pthread_mutex_unlock(&readahead_mutex) ;
+        return ;
+    }
+    readahead_misses++ ;
+    uint64_t start = position ;
+    uint64_t end ;
+    uint64_t track_capacity = geometry.get_track_capacity() ;
+    if (readahead.value == 1 && track_capacity > 0) {
+        start = position - (position % track_capacity) ;
+        end = start + track_capacity ;
+    } else
+        end = position + (uint64_t)readahead.value * geometry.sector_size_bytes ;
+    // request crossing the track end, or larger than read-ahead
+    if (end < position + len)
+        end = position + len ;
+    // not beyond image end, image may grow
+    uint64_t image_end = image->size() ;
+    if (end > image_end)
+        end = std::max(image_end, position + len) ;
+    if (start > position) // image_end in track
+        start = position ;
+
+    readahead_len = end - start ;
+    if (readahead_buffer.size() < readahead_len)
+        readahead_buffer.resize(readahead_len) ;
+    image->read(readahead_buffer.data(), start, readahead_len) ;
+    readahead_position = start ;
+    memcpy(buffer, readahead_buffer.data() + (position - readahead_position), len) ;
+    pthread_mutex_unlock(&readahead_mutex) ;
+}
+
+// image range changed: drop buffer if it overlaps
+void storagedrive_c::readahead_invalidate(uint64_t position, unsigned len)
+{
+    pthread_mutex_lock(&readahead_mutex) ;
+    if (readahead_len > 0 && position < readahead_position + readahead_len
+            && position + len > readahead_position)
+        readahead_len = 0 ;
+    pthread_mutex_unlock(&readahead_mutex) ;
+}
+
+void storagedrive_c::readahead_invalidate(void)
+{
+    pthread_mutex_lock(&readahead_mutex) ;
+    readahead_len = 0 ;
+    pthread_mutex_unlock(&readahead_mutex) ;
+}
+
+void storagedrive_c::readahead_statistics_update(void)
+{
+    uint64_t accesses = readahead_hits + readahead_misses ;
+    readahead_hit_ratio.value = accesses ? (double)readahead_hits / accesses : 0 ;
+}
+
 
 
 // one of the parameters used for image implementation changed:
@@ -114,13 +364,25 @@ void storagedrive_c::image_delete()
 bool storagedrive_c::image_recreate_on_param_change(parameter_c *param) 
 {
     bool accepted = false ;
+    image_io_wait() ;
+    pthread_rwlock_wrlock(&image_lock) ;
     if (param == &image_filepath) {
         // binary image?
         // todo: well-formed path? else later open() fails
-        image_delete() ;
+        image_delete_locked() ;
 		accepted = image_recreate_shared_on_param_change(image_filepath.new_value, image_filesystem.value, image_shareddir.value) ;
-	    if (image == nullptr)  // not enough params for shared dir: try regular image
-	        image = new storageimage_binfile_c(image_filepath.new_value) ; // dyn size
+	    if (image == nullptr) { // not enough params for shared dir: try regular image
+            const std::string mmap_prefix = "mmap:" ;
+            const std::string chunked_prefix = "chunked:" ;
+            if (image_filepath.new_value.compare(0, mmap_prefix.size(), mmap_prefix) == 0) {
+                enum storageimage_mmap_c::sync_policy_e sync_policy = storageimage_mmap_c::sync_close ;
+                image_sync_policy(image_sync.value, &sync_policy) ;
+                image = new storageimage_mmap_c(image_filepath.new_value.substr(mmap_prefix.size()), sync_policy) ;
+            } else if (image_filepath.new_value.compare(0, chunked_prefix.size(), chunked_prefix) == 0)
+                image = new storageimage_chunked_c(image_filepath.new_value.substr(chunked_prefix.size())) ;
+            else
+	            image = new storageimage_binfile_c(image_filepath.new_value) ; // dyn size
+        }
         accepted = (image != nullptr) ;
     } else if (param == &image_filesystem) {
         // shared image file system change?
@@ -132,17 +394,24 @@ bool storagedrive_c::image_recreate_on_param_change(parameter_c *param)
         // shared image host root dir change?
         accepted = image_recreate_shared_on_param_change(image_filepath.value, image_filesystem.value, image_shareddir.new_value) ;
     }
+    if (image != nullptr && image_cache == nullptr && image_snapshot == nullptr) {
+        if (image_overlay == nullptr)
+            image_overlay_setup(image_overlay_filepath.value) ;
+        image_cache_setup(cache_blocks.value) ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
     return accepted ;
 }
 
 // eval parameter set for shared image
 // result: parameter accepted, image recreated
+// Caller holds image_lock exclusive.
 bool storagedrive_c::image_recreate_shared_on_param_change(std::string image_path, std::string filesystem_paramval, std::string shareddir_paramval) 
 {
     bool ok = false ;
 
     if (! filesystem_paramval.empty() && ! shareddir_paramval.empty()) {
-        image_delete() ;
+        image_delete_locked() ;
         WARNING("TODO: drive size (trunc!) and unitno may change? Propagate to shared image!") ;
 		enum sharedfilesystem::filesystem_type_e filesystem_type ;
 		filesystem_type = sharedfilesystem::filesystem_type2text(filesystem_paramval) ;
@@ -164,66 +433,256 @@ bool storagedrive_c::image_recreate_shared_on_param_change(std::string image_pat
 
 
 // wrap actual image driver
+// open and close change the state of all layers: exclusive
 bool storagedrive_c::image_open(bool create) 
 {
-    if (image == nullptr)
-        return false ;
-
+    bool result = false ;
+    pthread_rwlock_wrlock(&image_lock) ;
+    readahead_invalidate() ;
     // virtual method of implementation
-    return image->open(this, create) ;
+    if (image != nullptr)
+        result = image->open(this, create) ;
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
 }
 
 void storagedrive_c::image_close(void) 
 {
-    if (image == nullptr)
-        return ;
-    image->close() ;
+    // I/O threads need image_lock: wait before locking
+    image_io_wait() ;
+    pthread_rwlock_wrlock(&image_lock) ;
+    readahead_invalidate() ;
+    if (image != nullptr)
+        image->close() ;
+    pthread_rwlock_unlock(&image_lock) ;
 }
 
 bool storagedrive_c::image_is_open(void) 
 {
-    if (image == nullptr)
-        return false ;
-    return image->is_open() ;
+    bool result = false ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr)
+        result = image->is_open() ;
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
 }
 
 bool storagedrive_c::image_is_readonly() 
 {
-    if (image == nullptr)
-        return false ;
-    return image->is_readonly() ;
+    bool result = false ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr)
+        result = image->is_readonly() ;
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
 }
 
 bool storagedrive_c::image_truncate(void) {
-    if (image == nullptr)
-        return false ; // is_open
-    return image->truncate() ;
+    bool result = false ; // is_open
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr) {
+        readahead_invalidate() ;
+        result = image->truncate() ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
 }
 
 uint64_t storagedrive_c::image_size(void) 
 {
-    if (image == nullptr)
-        return 0 ;
-    return image->size() ;
+    uint64_t result = 0 ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr)
+        result = image->size() ;
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
 }
 
 void storagedrive_c::image_read(uint8_t *buffer, uint64_t position, unsigned len) 
 {
-    if (image == nullptr)
-        return ;
-    set_activity_led(true) ; // indicate only read/write access
-    image->read(buffer, position, len) ;
-    set_activity_led(false) ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr) {
+        set_activity_led(true) ; // indicate only read/write access
+        if (readahead.value > 0) {
+            readahead_read(buffer, position, len) ;
+            readahead_statistics_update() ;
+        } else
+            image->read(buffer, position, len) ;
+        set_activity_led(false) ;
+        if (image_cache != nullptr)
+            image_cache_statistics_update() ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
 }
 
 void storagedrive_c::image_write(uint8_t *buffer, uint64_t position, unsigned len) 
 {
-    if (image == nullptr)
-        return ;
-    set_activity_led(true) ;
-    image->write(buffer, position, len) ;
-    set_activity_led(false) ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr) {
+        set_activity_led(true) ;
+        image->write(buffer, position, len) ;
+        // after write: a concurrent fill of the buffer is dropped too
+        readahead_invalidate(position, len) ;
+        set_activity_led(false) ;
+        if (image_cache != nullptr)
+            image_cache_statistics_update() ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
+}
+
+// complete asynchronous I/O, write changed cache blocks and
+// image data held in memory to the host file
+void storagedrive_c::image_flush(void)
+{
+    image_io_wait() ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr && image->is_open()) {
+        image->flush() ; // cache flushes its backend
+        if (image_cache != nullptr)
+            image_cache_statistics_update() ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
+}
+
+// start write back of changed cache blocks, but do not wait for it.
+// For bus INIT and power events.
+void storagedrive_c::image_flush_request(void)
+{
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image_cache != nullptr)
+        image_cache->flush_request() ;
+    pthread_rwlock_unlock(&image_lock) ;
+}
+
+// submit image access to the I/O threads, "request" must stay valid until complete.
+// Accesses of this drive are executed in order.
+void storagedrive_c::image_read_async(storagedrive_io_request_c *request, uint8_t *buffer, uint64_t position, unsigned len)
+{
+    request->drive = this ;
+    request->is_write = false ;
+    request->buffer = buffer ;
+    request->position = position ;
+    request->len = len ;
+    storagedrive_io_service_c::instance()->submit(request) ;
+}
+
+void storagedrive_c::image_write_async(storagedrive_io_request_c *request, uint8_t *buffer, uint64_t position, unsigned len)
+{
+    request->drive = this ;
+    request->is_write = true ;
+    request->buffer = buffer ;
+    request->position = position ;
+    request->len = len ;
+    storagedrive_io_service_c::instance()->submit(request) ;
+}
+
+// all asynchronous accesses complete
+void storagedrive_c::image_io_wait(void)
+{
+    storagedrive_io_service_c::instance()->wait_drive(this) ;
+}
+
+// write overlay changes into the base image
+bool storagedrive_c::image_overlay_commit(void)
+{
+    bool result = false ;
+    image_flush() ;
+    // overlay serializes commit() against its own read()/write()
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image_overlay != nullptr && image_overlay->is_open())
+        result = image_overlay->commit() ;
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
+}
+
+// drop overlay changes, image is the base again. Cache has stale blocks then.
+// Other threads must not access the image between discard and new cache.
+bool storagedrive_c::image_overlay_discard(void)
+{
+    bool result = false ;
+    image_io_wait() ;
+    pthread_rwlock_wrlock(&image_lock) ;
+    if (image_overlay != nullptr && image_overlay->is_open()) {
+        image_cache_setup(0) ;
+        image_snapshot_setup(false) ; // changes below tracking
+        image_overlay->discard() ;
+        readahead_invalidate() ;
+        image_cache_setup(cache_blocks.value) ;
+        result = true ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
 }
+
+// Consistent snapshot of image, saved in the background.
+// Drive continues, changed blocks are kept until saved.
+// No other thread accesses the image while the layers change and the snapshot is taken.
+bool storagedrive_c::image_snapshot_take(std::string snapshot_name)
+{
+    bool result = false ;
+    image_io_wait() ;
+    pthread_rwlock_wrlock(&image_lock) ;
+    if (image != nullptr && image->is_open()) {
+        if (image_snapshot == nullptr) {
+            // first snapshot: insert tracking under the cache
+            image_cache_setup(0) ;
+            image_snapshot_setup(true) ;
+            image_cache_setup(cache_blocks.value) ;
+        } else if (image_cache != nullptr)
+            image_cache->flush() ;
+        result = image_snapshot->take(image_snapshot_fname(snapshot_name)) ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
+}
+
+// restore image to snapshot "snapshot_name". Cache content is stale then.
+bool storagedrive_c::image_snapshot_rollback(std::string snapshot_name)
+{
+    bool result = false ;
+    image_io_wait() ;
+    pthread_rwlock_wrlock(&image_lock) ;
+    if (image != nullptr && image->is_open()) {
+        image_cache_setup(0) ;
+        if (image_snapshot == nullptr)
+            image_snapshot_setup(true) ; // only rollback from file
+        result = image_snapshot->rollback(image_snapshot_fname(snapshot_name)) ;
+        readahead_invalidate() ;
+        image_cache_setup(cache_blocks.value) ;
+    }
+    pthread_rwlock_unlock(&image_lock) ;
+    return result ;
+}
+
+// direct access to image data, if image supports it. else nullptr.
+// While the pointer is used, image_lock stays shared, so the image is
+// not closed or unmapped. End the access with image_block_ptr_release()
+// or image_block_ptr_written().
+uint8_t *storagedrive_c::image_block_ptr(uint64_t position, unsigned len)
+{
+    uint8_t *result = nullptr ;
+    pthread_rwlock_rdlock(&image_lock) ;
+    if (image != nullptr)
+        result = image->block_ptr(position, len) ;
+    if (result == nullptr)
+        pthread_rwlock_unlock(&image_lock) ;
+    return result ;
+}
+
+// end of unchanged access via image_block_ptr()
+void storagedrive_c::image_block_ptr_release(void)
+{
+    pthread_rwlock_unlock(&image_lock) ;
+}
+
+// data changed via image_block_ptr(), ends the access
+void storagedrive_c::image_block_ptr_written(uint64_t position, unsigned len)
+{
+    image->block_ptr_written(position, len) ;
+    readahead_invalidate(position, len) ;
+    pthread_rwlock_unlock(&image_lock) ;
+}
+
 // Service function for disk drive who need to clear unwritten bytes in last block of transaction
 // Sometimes when writing incomplete disk blocks, the remaining bytes must be filled with 00s
 // Some disk are guaranteed to write only whole blocks, then always unused_byte_count=0
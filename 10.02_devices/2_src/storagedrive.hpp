@@ -20,6 +20,13 @@
  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+ 16-oct-2026  agent   image snapshots
+ 16-oct-2026  agent   read-ahead track buffer
+ 16-oct-2026  agent   asynchronous image I/O
+ 16-oct-2026  agent   copy-on-write overlay image
+ 16-oct-2026  agent   "chunked:" compressed sparse images
+ 16-oct-2026  agent   write-back image cache
+ 16-oct-2026  agent   "mmap:" images, param "image_sync", image_block_ptr()
  may-2019		JD		file_size()
  12-nov-2018  JH      entered beta phase
 
@@ -31,9 +38,16 @@
 #include <string>
 #include <fstream>
 #include <assert.h>
+#include <pthread.h>
+#include <vector>
 
 #include "utils.hpp"
 #include "storageimage.hpp"
+#include "storageimage_cache.hpp"
+#include "storageimage_chunked.hpp"
+#include "storageimage_overlay.hpp"
+#include "storageimage_snapshot.hpp"
+#include "storagedrive_io.hpp"
 #include "device.hpp"
 #include "parameter.hpp"
 
@@ -76,12 +90,38 @@ class storagecontroller_c;
 
 class storagedrive_c: public device_c {
     friend class storagedrive_selftest_c ;
-private:
+protected:
     uint8_t	zeros[4096] ; // a block of 00s
+private:
 
     // several implementations of the "magnetic surface" possible
     // hide from devices
     storageimage_base_c	*image = nullptr ;
+    // shared: image access. exclusive: change of "image" and its layers
+    pthread_rwlock_t image_lock ;
+    void image_delete_locked() ;
+    // if cache_blocks > 0: "image" is this cache, in front of actual image
+    storageimage_cache_c *image_cache = nullptr ;
+    void image_cache_setup(unsigned block_count) ;
+    // if image_overlay set: base image under "image", writes go to delta file
+    storageimage_overlay_c *image_overlay = nullptr ;
+    void image_overlay_setup(std::string delta_fname) ;
+    // after first snapshot: tracks changes for snapshots, between overlay and cache
+    storageimage_snapshot_c *image_snapshot = nullptr ;
+    void image_snapshot_setup(bool enable) ;
+    std::string image_snapshot_fname(std::string snapshot_name) ;
+    void image_cache_statistics_update(void) ;
+
+    // read-ahead: last read track or block range, on top of all image layers
+    pthread_mutex_t readahead_mutex ; // drive worker and I/O threads
+    std::vector<uint8_t> readahead_buffer ;
+    uint64_t readahead_position ;
+    unsigned readahead_len ; // 0 = buffer invalid
+    uint64_t readahead_hits, readahead_misses ;
+    void readahead_read(uint8_t *buffer, uint64_t position, unsigned len) ;
+    void readahead_invalidate(uint64_t position, unsigned len) ;
+    void readahead_invalidate(void) ;
+    void readahead_statistics_update(void) ;
 
 public:
     storagecontroller_c *controller; // link to parent
@@ -101,7 +141,13 @@ public:
 
     // if binary image
     parameter_string_c image_filepath = parameter_string_c(this, "image", "img", /*readonly*/
-                                        false, "Path to binary image file. Empty to detach. \".gz\" archive also searched.");
+                                        false, "Path to binary image file. Empty to detach. \".gz\" archive also searched. Prefix \"mmap:\" to map into memory, \"chunked:\" for compressed sparse image.");
+    // when memory mapped image is written back
+    parameter_string_c image_sync = parameter_string_c(this, "image_sync", "ims", /*readonly*/
+                                    false, "Write back of \"mmap:\" image: \"close\" (default), \"async\" or \"write\" after each write.");
+    // copy-on-write
+    parameter_string_c image_overlay_filepath = parameter_string_c(this, "image_overlay", "ovl", /*readonly*/
+            false, "Path to overlay file receiving all changes, \"image\" is not written. Set before \"image\".");
     // if shared host dir
 //		image_shareddir - path to directory root of shared host file tree
     parameter_string_c image_shareddir = parameter_string_c(this, "shared_dir", "shd", /*readonly*/
@@ -109,6 +155,24 @@ public:
     parameter_string_c image_filesystem = parameter_string_c(this, "shared_filesystem", "shfs", /*readonly*/
                                           false, "Encode shared dir in this file system (empty, RT11, XXDP).");
 
+    // write-back cache
+    parameter_unsigned_c cache_blocks = parameter_unsigned_c(this, "cache_blocks", "cb", /*readonly*/
+                                        false, "", "%d", "Write-back image cache size in 4KB blocks. 0 = no cache.", 16, 10);
+    parameter_unsigned_c cache_flush_period = parameter_unsigned_c(this, "cache_flush_period", "cfp", /*readonly*/
+            false, "ms", "%d", "Period to flush changed cache blocks to image. 0 = only on close, INIT, power down.", 32, 10);
+    parameter_double_c cache_hit_ratio = parameter_double_c(this, "cache_hit_ratio", "chr", /*readonly*/
+                                         true, "", "%0.3f", "Ratio of image blocks accesses served from cache");
+    parameter_unsigned_c cache_dirty_blocks = parameter_unsigned_c(this, "cache_dirty_blocks", "cdb", /*readonly*/
+            true, "", "%d", "Changed cache blocks not yet written to image", 16, 10);
+    parameter_unsigned_c cache_flush_latency = parameter_unsigned_c(this, "cache_flush_latency", "cfl", /*readonly*/
+            true, "us", "%d", "Duration of last flush", 32, 10);
+
+    // read-ahead
+    parameter_unsigned_c readahead = parameter_unsigned_c(this, "readahead", "ra", /*readonly*/
+                                     false, "", "%d", "Read-ahead on miss. 0 = off, 1 = whole track, n = n sectors.", 16, 10);
+    parameter_double_c readahead_hit_ratio = parameter_double_c(this, "readahead_hit_ratio", "rahr", /*readonly*/
+            true, "", "%0.3f", "Ratio of image reads served from read-ahead buffer");
+
     parameter_unsigned_c activity_led = parameter_unsigned_c(this, "activityled", "al", /*readonly*/
                                         false, "", "%d", "Number of LED to used for activity display.", 8, 10);
 
@@ -129,6 +193,7 @@ public:
     void image_delete() ;
 private:
     bool image_recreate_shared_on_param_change(std::string image_path, std::string filesystem_paramval, std::string shareddir_paramval);
+    bool image_sync_policy(std::string sync_paramval, enum storageimage_mmap_c::sync_policy_e *sync_policy) ;
 
 public:
     bool image_open(bool create) ;
@@ -136,9 +201,21 @@ public:
     bool image_is_open(void) ;
     bool image_is_readonly() ;
     bool image_truncate(void) ;
+    void image_flush(void) ;
+    void image_flush_request(void) ;
+    bool image_overlay_commit(void) ;
+    bool image_overlay_discard(void) ;
+    bool image_snapshot_take(std::string snapshot_name) ;
+    bool image_snapshot_rollback(std::string snapshot_name) ;
     uint64_t image_size(void) ;
     void image_read(uint8_t *buffer, uint64_t position, unsigned len) ;
     void image_write(uint8_t *buffer, uint64_t position, unsigned len) ;
+    void image_read_async(storagedrive_io_request_c *request, uint8_t *buffer, uint64_t position, unsigned len) ;
+    void image_write_async(storagedrive_io_request_c *request, uint8_t *buffer, uint64_t position, unsigned len) ;
+    void image_io_wait(void) ;
+    uint8_t *image_block_ptr(uint64_t position, unsigned len) ;
+    void image_block_ptr_release(void) ;
+    void image_block_ptr_written(uint64_t position, unsigned len) ;
     void image_clear_remaining_block_bytes(unsigned block_size_bytes, uint64_t position, unsigned len) ;
 
     void set_activity_led(bool onoff) ;
@@ -0,0 +1,160 @@
+/* storagedrive_io.cpp: asynchronous image I/O for all storage drives
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ The I/O threads run with the RT priority of the storage workers,
+ else a busy controller worker would starve its own image I/O.
+ */
+#include <assert.h>
+#include <sched.h>
+
+#include "logger.hpp"
+#include "pru.hpp"
+#include "storagedrive.hpp"
+#include "storagedrive_io.hpp"
+
+void storagedrive_io_request_c::wait(void)
+{
+    storagedrive_io_service_c::instance()->wait(this) ;
+}
+
+void *storagedrive_io_pthread_wrapper(void *context)
+{
+    storagedrive_io_service_c *service = (storagedrive_io_service_c *)context ;
+    service->worker() ;
+    return NULL;
+}
+
+// singleton, threads started on first use.
+// Never deleted: drives may wait for it in static destructors.
+storagedrive_io_service_c *storagedrive_io_service_c::instance(void)
+{
+    static storagedrive_io_service_c *service = new storagedrive_io_service_c() ;
+    return service ;
+}
+
+storagedrive_io_service_c::storagedrive_io_service_c()
+{
+    log_label = "DRVIO" ;
+    completed_count = 0 ;
+    max_in_flight = 0 ;
+    pthread_mutex_init(&mutex, NULL) ;
+    pthread_cond_init(&work_cond, NULL) ;
+    pthread_cond_init(&done_cond, NULL) ;
+    for (unsigned i = 0; i < thread_count; i++) {
+        int status = pthread_create(&threads[i], NULL, &storagedrive_io_pthread_wrapper, this) ;
+        if (status != 0)
+            FATAL("Failed to create storagedrive_io_service_c thread with status = %d", status);
+    }
+}
+
+void storagedrive_io_service_c::submit(storagedrive_io_request_c *request)
+{
+    assert(request->drive != nullptr) ;
+    assert(request->is_complete()) ; // not reused while in flight
+    pthread_mutex_lock(&mutex) ;
+    request->complete = false ;
+    queue.push_back(request) ;
+    drive_requests[request->drive]++ ;
+    if (queue.size() > max_in_flight)
+        max_in_flight = queue.size() ;
+    pthread_cond_signal(&work_cond) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// only for requests without on_complete callback
+void storagedrive_io_service_c::wait(storagedrive_io_request_c *request)
+{
+    pthread_mutex_lock(&mutex) ;
+    while (!request->complete)
+        pthread_cond_wait(&done_cond, &mutex) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// all requests of a drive complete, also with callbacks
+void storagedrive_io_service_c::wait_drive(storagedrive_c *drive)
+{
+    pthread_mutex_lock(&mutex) ;
+    while (drive_requests[drive] > 0)
+        pthread_cond_wait(&done_cond, &mutex) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// oldest request of a drive without request in execution.
+// Caller holds mutex.
+storagedrive_io_request_c *storagedrive_io_service_c::next_request(void)
+{
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        storagedrive_io_request_c *request = *it ;
+        if (!drive_busy[request->drive]) {
+            queue.erase(it) ;
+            return request ;
+        }
+    }
+    return nullptr ;
+}
+
+void storagedrive_io_service_c::worker(void)
+{
+    // like device_c::worker_init_realtime_priority(rt_device)
+    if (!pru || !pru->is_virtual()) {
+        struct sched_param params ;
+        params.sched_priority = 50 ;
+        if (pthread_setschedparam(pthread_self(), SCHED_RR, &params) != 0)
+            DEBUG("Unsuccessful in setting thread realtime prio") ;
+    }
+
+    pthread_mutex_lock(&mutex) ;
+    while (true) {
+        storagedrive_io_request_c *request = next_request() ;
+        if (request == nullptr) {
+            pthread_cond_wait(&work_cond, &mutex) ;
+            continue ;
+        }
+        storagedrive_c *drive = request->drive ;
+        drive_busy[drive] = true ;
+        pthread_mutex_unlock(&mutex) ;
+
+        if (request->is_write)
+            drive->image_write(request->buffer, request->position, request->len) ;
+        else
+            drive->image_read(request->buffer, request->position, request->len) ;
+
+        // callback may delete request: not touched afterwards
+        bool has_callback = (bool)request->on_complete ;
+        if (has_callback) {
+            request->complete = true ;
+            request->on_complete(request) ;
+        }
+
+        pthread_mutex_lock(&mutex) ;
+        if (!has_callback)
+            request->complete = true ; // waiter may reuse request now
+        drive_busy[drive] = false ;
+        drive_requests[drive]-- ;
+        completed_count++ ;
+        pthread_cond_broadcast(&done_cond) ;
+        pthread_cond_broadcast(&work_cond) ; // next request of drive may run
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
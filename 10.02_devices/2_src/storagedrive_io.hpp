@@ -0,0 +1,98 @@
+/* storagedrive_io.hpp: asynchronous image I/O for all storage drives
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ Controller workers submit image reads and writes and continue with
+ register and DMA work, while a pool of I/O threads accesses the images.
+ Requests of one drive are executed in order of submission,
+ requests of different drives in parallel.
+ */
+#ifndef _STORAGEDRIVE_IO_HPP_
+#define _STORAGEDRIVE_IO_HPP_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <deque>
+#include <map>
+#include <functional>
+
+#include "logsource.hpp"
+
+class storagedrive_c ;
+
+class storagedrive_io_request_c {
+    friend class storagedrive_io_service_c ;
+public:
+    storagedrive_c *drive = nullptr ;
+    bool is_write = false ;
+    uint8_t *buffer = nullptr ;
+    uint64_t position = 0 ;
+    unsigned len = 0 ;
+
+    // Called by the I/O thread after image access. May delete the request.
+    // Requests with callback are not wait()ed for, use wait_drive().
+    std::function<void(storagedrive_io_request_c *)> on_complete ;
+
+    bool is_complete(void) {
+        return complete ;
+    }
+    void wait(void) ;
+
+private:
+    volatile bool complete = true ;
+} ;
+
+class storagedrive_io_service_c: public logsource_c {
+    friend void *storagedrive_io_pthread_wrapper(void *context) ;
+public:
+    static const unsigned thread_count = 4 ;
+
+private:
+    pthread_t threads[thread_count] ;
+
+    pthread_mutex_t mutex ;
+    pthread_cond_t work_cond ; // new request, or drive no longer busy
+    pthread_cond_t done_cond ; // request complete
+
+    std::deque<storagedrive_io_request_c *> queue ;
+    std::map<storagedrive_c *, bool> drive_busy ; // a request of drive in execution
+    std::map<storagedrive_c *, unsigned> drive_requests ; // queued and executing
+
+    storagedrive_io_request_c *next_request(void) ;
+    void worker(void) ;
+
+    storagedrive_io_service_c() ;
+
+public:
+    static storagedrive_io_service_c *instance(void) ;
+
+    // statistics
+    uint64_t completed_count ;
+    unsigned max_in_flight ; // max queued requests
+
+    void submit(storagedrive_io_request_c *request) ;
+    void wait(storagedrive_io_request_c *request) ;
+    void wait_drive(storagedrive_c *drive) ;
+} ;
+
+#endif
@@ -21,6 +21,11 @@
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
+ 16-oct-2026	agent   get_bytes_view()
+ 16-oct-2026	agent   storageimage_memory_c: growth fixed, pages allocated on demand, lazy load
+ 16-oct-2026	agent   flush() for all images
+ 16-oct-2026	agent   storageimage_binfile_c: read() and size() after read beyond end of file
+ 16-oct-2026	agent   storageimage_mmap_c
  07-mar-2021	JH      start
 
  A storagedrive is a disk or tape drive, with an image file as storage medium.
@@ -32,9 +37,11 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
 #include <ios>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 
 #ifndef O_BINARY
@@ -44,6 +51,7 @@
 #include "logger.hpp"
 #include "utils.hpp"
 #include "storageimage.hpp"
+#include "storagedrive.hpp"
 
 
 // BIG use of memory
@@ -68,6 +76,60 @@ bool storageimage_base_c::is_zero(uint64_t position, unsigned len)
 }
 
 
+// default: no direct access to image data
+uint8_t *storageimage_base_c::block_ptr(uint64_t position, unsigned len)
+{
+    UNUSED(position) ;
+    UNUSED(len) ;
+    return nullptr ;
+}
+
+void storageimage_base_c::block_ptr_written(uint64_t position, unsigned len)
+{
+    UNUSED(position) ;
+    UNUSED(len) ;
+}
+
+// default: all data already written to file
+void storageimage_base_c::flush(void)
+{
+}
+
+// read-only view on "len" bytes at "byte_offset".
+// Points into image memory if possible, else data is read into "buffer".
+// Valid until the next write(), close() or change of "buffer".
+byte_buffer_view_c storageimage_base_c::get_bytes_view(byte_buffer_c *buffer, uint64_t byte_offset, uint32_t len)
+{
+    uint8_t *ptr = block_ptr(byte_offset, len) ;
+    if (ptr != nullptr)
+        return byte_buffer_view_c(ptr, len, buffer->get_endianness()) ;
+    get_bytes(buffer, byte_offset, len) ;
+    return byte_buffer_view_c(*buffer) ;
+}
+
+
+// file could not be opened, neither rw nor read only
+// try to unzip <image_fname>.gz to <image_fname>
+// result: true = expanded, retry opening
+static bool uncompress_gz(std::string image_fname)
+{
+    std::string compressed_image_fname = image_fname + ".gz" ;
+    if (FILE *fz = fopen(compressed_image_fname.c_str(), "r")) {
+        fclose(fz);
+        std::string uncompress_cmd = "zcat " + compressed_image_fname + " >" + image_fname ;
+        printf("Only compressed image file %s found, expanding \"%s\" ...\n", image_fname.c_str(), uncompress_cmd.c_str()) ;
+        int ret = system(uncompress_cmd.c_str()) ;
+        if (ret != 0) {
+            printf(" FAILED!\n") ;
+            return false ;
+        }
+        printf("... complete.\n") ;
+        return true ;
+    }
+    return false ;
+}
+
+
 // http://www.cplusplus.com/doc/tutorial/files/
 
 // open a file, if possible.
@@ -99,24 +161,8 @@ bool storageimage_binfile_c::open(storagedrive_c *_drive, bool create)
         }
 
         retries-- ;
-        if (retries > 0) {
-            // file could not be opened, neither rw nor read only
-            // try to unzip, then retry opening
-            std::string compressed_image_fname = image_fname + ".gz" ;
-            if (FILE *fz = fopen(compressed_image_fname.c_str(), "r")) {
-                fclose(fz);
-                std::string uncompress_cmd = "zcat " + compressed_image_fname + " >" + image_fname ;
-                printf("Only compressed image file %s found, expanding \"%s\" ...\n", image_fname.c_str(), uncompress_cmd.c_str()) ;
-                int ret = system(uncompress_cmd.c_str()) ;
-                if (ret != 0) {
-                    printf(" FAILED!\n") ;
-                    retries = 0 ; // not again
-                } else
-                    printf("... complete.\n") ;
-
-            } else
-                retries = 0 ; // not again
-        }
+        if (retries > 0 && !uncompress_gz(image_fname))
+            retries = 0 ; // not again
     }
 
     // definitely no image file neither plain nor zipped
@@ -169,6 +215,7 @@ void storageimage_binfile_c::read(uint8_t *buffer, uint64_t position, unsigned l
     memset(buffer, 0, len);
 
     // 2. move read pointer
+    f.clear(); // clear fail bit of previous read beyond end of file
     f.seekg(position);
     // may be at eof now, doesn't matter
 
@@ -233,6 +280,7 @@ void storageimage_binfile_c::write(uint8_t *buffer, uint64_t position, unsigned
 
 uint64_t storageimage_binfile_c::size(void) 
 {
+    f.clear(); // clear fail bit
     f.seekp(0, std::ios::end);
     return f.tellp();
 }
@@ -286,6 +334,311 @@ void storageimage_binfile_c::save_to_file(std::string _host_filename)
 
 
 
+// open and map the image file, if possible.
+// set the file_readonly flag
+// creates file, if not existing and "create"
+// result: OK= true, else false
+bool storageimage_mmap_c::open(storagedrive_c *_drive, bool create)
+{
+    drive = _drive ;
+    if (is_open())
+        close(); // after RL11 INIT
+    readonly = false;
+    if (image_fname.empty())
+        return true ; // ! is_open
+
+    fd = ::open(image_fname.c_str(), O_BINARY | O_RDWR) ;
+    if (fd < 0) {
+        fd = ::open(image_fname.c_str(), O_BINARY | O_RDONLY) ;
+        readonly = (fd >= 0) ;
+    }
+    if (fd < 0 && uncompress_gz(image_fname))
+        fd = ::open(image_fname.c_str(), O_BINARY | O_RDWR) ;
+    if (fd < 0 && create) {
+        fd = ::open(image_fname.c_str(), O_BINARY | O_RDWR | O_CREAT, 0666) ;
+        if (fd >= 0)
+            INFO("Created empty image file %s.", image_fname.c_str()) ;
+        else
+            INFO("Creating empty image file %s FAILED.", image_fname.c_str()) ;
+    }
+    if (fd < 0)
+        return false ;
+
+    struct stat file_status ;
+    if (fstat(fd, &file_status) != 0) {
+        ERROR("storageimage_mmap_c.open(): fstat() failure on %s", image_fname.c_str());
+        close() ;
+        return false ;
+    }
+    // Map the whole drive capacity now, so the mapping never moves
+    // and block_ptr()s stay valid while the image grows.
+    // Pages beyond file end are not touched until the file is enlarged.
+    map_size = file_status.st_size ;
+    map_capacity = map_size ;
+    if (!readonly && drive != nullptr)
+        map_capacity = std::max(map_capacity, (uint64_t)drive->capacity.value) ;
+    if (map_capacity > 0) {
+        void *addr = mmap(NULL, map_capacity, readonly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) ;
+        if (addr == MAP_FAILED) {
+            ERROR("storageimage_mmap_c: mmap() of %" PRIu64 " bytes failed for %s", map_capacity, image_fname.c_str());
+            close() ;
+            return false ;
+        }
+        map = (uint8_t *)addr ;
+        // controllers access mostly sequentially
+        madvise(map, map_capacity, MADV_SEQUENTIAL) ;
+    }
+    return true ;
+}
+
+bool storageimage_mmap_c::is_open()
+{
+    return fd >= 0 ;
+}
+
+// set file size. File is enlarged with 00s, if needed.
+// The mapping is never moved: block_ptr()s given out stay valid.
+// Bytes of the mapping beyond file size are never accessed,
+// file data beyond the mapping is accessed with pread()/pwrite().
+bool storageimage_mmap_c::resize(uint64_t new_size)
+{
+    if (!readonly && ::ftruncate(fd, new_size) != 0) {
+        ERROR("storageimage_mmap_c: can not resize %s to %" PRIu64 " bytes", image_fname.c_str(), new_size);
+        return false ;
+    }
+    map_size = new_size ;
+    return true ;
+}
+
+// file bytes accessible via the mapping
+uint64_t storageimage_mmap_c::mapped_size(void)
+{
+    return std::min(map_size, map_capacity) ;
+}
+
+// write back pages after a change, as given by sync_policy
+void storageimage_mmap_c::sync(uint64_t position, unsigned len)
+{
+    if (sync_policy == sync_close)
+        return ;
+    // msync() needs page aligned start
+    uint64_t page_mask = (uint64_t)sysconf(_SC_PAGESIZE) - 1 ;
+    uint64_t start = position & ~page_mask ;
+    if (position + len > mapped_size())
+        return ; // pwrite() beyond mapping
+    msync(map + start, position + len - start, sync_policy == sync_write ? MS_SYNC : MS_ASYNC) ;
+}
+
+// set file size to 0
+bool storageimage_mmap_c::truncate()
+{
+    assert(is_open());
+    assert(!readonly); // caller must take care
+    return resize(0) ;
+}
+
+/* read "len" bytes from mapping into buffer
+ * if file is too short, 00s are read
+ */
+void storageimage_mmap_c::read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(is_open());
+    assert(buffer != nullptr) ;
+    assert(len) ;
+    unsigned bytes_copied = 0 ;
+    if (position < mapped_size()) {
+        bytes_copied = std::min((uint64_t)len, mapped_size() - position) ;
+        memcpy(buffer, map + position, bytes_copied) ;
+    }
+    if (bytes_copied < len && position + bytes_copied < map_size) {
+        // file grew beyond mapping
+        ssize_t bytes_read = ::pread(fd, buffer + bytes_copied, len - bytes_copied, position + bytes_copied) ;
+        if (bytes_read > 0)
+            bytes_copied += bytes_read ;
+    }
+    if (bytes_copied < len)
+        memset(buffer + bytes_copied, 0, len - bytes_copied) ;
+}
+
+/* write "len" bytes from buffer into mapping at "position"
+ * if file too short, it is extended
+ */
+void storageimage_mmap_c::write(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(buffer);
+    assert(is_open());
+    assert(!readonly); // caller must take care
+
+    if (position + len > map_size && !resize(position + len))
+        return ;
+    unsigned bytes_copied = 0 ;
+    if (position < mapped_size()) {
+        bytes_copied = std::min((uint64_t)len, mapped_size() - position) ;
+        memcpy(map + position, buffer, bytes_copied) ;
+    }
+    if (bytes_copied < len
+            && ::pwrite(fd, buffer + bytes_copied, len - bytes_copied, position + bytes_copied)
+            != (ssize_t)(len - bytes_copied))
+        ERROR("storageimage_mmap_c: write to %s failed", image_fname.c_str());
+    sync(position, len) ;
+}
+
+bool storageimage_mmap_c::is_zero(uint64_t position, unsigned len)
+{
+    assert(is_open());
+    // bytes beyond file end are 00
+    for (uint64_t i = position ; i < position + len && i < mapped_size() ; i++)
+        if (map[i] != 0)
+            return false ;
+    if (position + len > mapped_size() && mapped_size() < map_size)
+        return storageimage_base_c::is_zero(position, len) ;
+    return true ;
+}
+
+// only inside the current file and the mapping
+uint8_t *storageimage_mmap_c::block_ptr(uint64_t position, unsigned len)
+{
+    if (!is_open() || position + len > mapped_size())
+        return nullptr ;
+    return map + position ;
+}
+
+void storageimage_mmap_c::block_ptr_written(uint64_t position, unsigned len)
+{
+    sync(position, len) ;
+}
+
+uint64_t storageimage_mmap_c::size(void)
+{
+    return map_size ;
+}
+
+// wait until kernel has written back all changed pages
+void storageimage_mmap_c::flush(void)
+{
+    if (!is_open() || readonly || map == nullptr || mapped_size() == 0)
+        return ;
+    msync(map, mapped_size(), MS_SYNC) ;
+}
+
+void storageimage_mmap_c::close(void)
+{
+    if (!is_open())
+        return ;
+    if (map != nullptr) {
+        if (!readonly && mapped_size() > 0)
+            msync(map, mapped_size(), MS_SYNC) ;
+        munmap(map, map_capacity) ;
+        map = nullptr ;
+    }
+    map_size = map_capacity = 0 ;
+    ::close(fd) ;
+    fd = -1 ;
+    readonly = false;
+}
+
+// read data from image into memory buffer (cache)
+void storageimage_mmap_c::get_bytes(byte_buffer_c* byte_buffer, uint64_t byte_offset, uint32_t len)
+{
+    byte_buffer->set_size(len) ;
+    read(byte_buffer->data_ptr(), byte_offset, len) ;
+}
+
+// write cache buffer to image
+void storageimage_mmap_c::set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)
+{
+    write(byte_buffer->data_ptr(), byte_offset, byte_buffer->size()) ;
+}
+
+// make a snapshot
+// must be locked against parallel write()/close()
+void storageimage_mmap_c::save_to_file(std::string _host_filename)
+{
+    std::string host_filename = absolute_path(&_host_filename) ;
+    assert(is_open()) ;
+
+    try {
+        int32_t file_descriptor;
+        file_descriptor = ::open(host_filename.c_str(), O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (file_descriptor < 0)
+            throw printf_exception("storageimage_mmap_c::save_to_file() cannot open \"%s\"",
+                                   host_filename.c_str());
+        bool ok = (mapped_size() == 0 || ::write(file_descriptor, map, mapped_size()) == (ssize_t)mapped_size()) ;
+        // file data beyond mapping
+        uint8_t buffer[65536] ;
+        for (uint64_t position = mapped_size() ; ok && position < map_size ; position += sizeof(buffer)) {
+            unsigned len = std::min((uint64_t)sizeof(buffer), map_size - position) ;
+            read(buffer, position, len) ;
+            ok = (::write(file_descriptor, buffer, len) == (ssize_t)len) ;
+        }
+        ::close(file_descriptor);
+        if (!ok)
+            throw printf_exception("storageimage_mmap_c::save_to_file() cannot write \"%s\"",
+                                   host_filename.c_str());
+    }
+    catch(std::exception& e) {
+        ERROR(e.what()) ;
+    }
+}
+
+
+
+static const uint8_t memory_zero_page[storageimage_memory_c::page_size] = { 0 } ;
+
+void storageimage_memory_c::pages_free(void)
+{
+    std::lock_guard<std::mutex> lock(pages_mutex) ;
+    for (auto page : pages)
+        free(page) ;
+    pages.clear() ;
+    page_loaded.clear() ;
+    if (load_fd >= 0)
+        ::close(load_fd) ;
+    load_fd = -1 ;
+    load_size = 0 ;
+}
+
+// enough pages for "size" bytes. New pages are 00s.
+// Image grows to "size", never shrinks.
+void storageimage_memory_c::pages_resize(uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(pages_mutex) ;
+    data_size = std::max(data_size, size) ;
+    uint64_t page_count = (size + page_size - 1) / page_size ;
+    if (page_count > pages.size()) {
+        pages.resize(page_count, nullptr) ;
+        page_loaded.resize(page_count, false) ;
+    }
+}
+
+// page memory, loaded from file on first access.
+// nullptr: page is all 00s, only allocated if "alloc".
+// Pages are materialized by parallel I/O threads: page table under lock.
+// Returned page memory remains valid until pages_free().
+uint8_t *storageimage_memory_c::page_data(uint64_t page_idx, bool alloc)
+{
+    std::lock_guard<std::mutex> lock(pages_mutex) ;
+    if (page_idx >= pages.size())
+        return nullptr ; // beyond image end: 00s
+    if (!page_loaded[page_idx]) {
+        page_loaded[page_idx] = true ;
+        uint64_t page_pos = page_idx * page_size ;
+        if (load_fd >= 0 && page_pos < load_size) {
+            uint8_t *page = (uint8_t *)calloc(1, page_size) ;
+            unsigned load_len = std::min((uint64_t)page_size, load_size - page_pos) ;
+            if (::pread(load_fd, page, load_len, page_pos) != (ssize_t)load_len)
+                ERROR("storageimage_memory_c: cannot read %u bytes at %" PRIu64, load_len, page_pos) ;
+            if (!memcmp(page, memory_zero_page, page_size))
+                free(page) ; // keep unallocated
+            else
+                pages[page_idx] = page ;
+        }
+    }
+    if (pages[page_idx] == nullptr && alloc)
+        pages[page_idx] = (uint8_t *)calloc(1, page_size) ;
+    return pages[page_idx] ;
+}
+
 // result: OK= true, else false
 bool storageimage_memory_c::open(storagedrive_c *_drive, bool create)
 {
@@ -293,8 +646,7 @@ bool storageimage_memory_c::open(storagedrive_c *_drive, bool create)
     UNUSED(create);
     if (is_open())
         close(); // after RL11 INIT
-    if (data_size)
-        data = (uint8_t *)malloc(data_size) ;
+    pages_resize(data_size) ; // no memory until written
     opened = true ;
     return true ;
 }
@@ -309,8 +661,7 @@ bool storageimage_memory_c::truncate(void)
     assert(is_open()) ;
     // fixed size
 
-    free(data) ;
-    data = nullptr ;
+    pages_free() ;
     data_size = 0;
     return true ;
 }
@@ -320,26 +671,21 @@ void storageimage_memory_c::read(uint8_t *buffer, uint64_t position, unsigned le
     assert(is_open()) ;
     assert(buffer != nullptr) ;
     assert(len) ;
-    // if len > data_size, fill up with 00s
-
-    uint8_t *dest = buffer ;
-    unsigned bytes_copied = 0 ;
-    if (position < data_size) {
-        // copy bytes from data[] to buffer
-        uint8_t *src = &data[position] ;
-        uint64_t stop_pos = position + len ; // idx of byte after last byte to fill
-        if (stop_pos <= data_size)
-            bytes_copied = len ; // all wanted bytes in data[]
+    // beyond data_size 00s: unused end of last page is 00s
+
+    while (len > 0) {
+        uint64_t page_idx = position / page_size ;
+        unsigned page_offset = position % page_size ;
+        unsigned chunk_len = std::min(len, page_size - page_offset) ;
+        uint8_t *page = page_data(page_idx, false) ;
+        if (page != nullptr)
+            memcpy(buffer, page + page_offset, chunk_len) ;
         else
-            bytes_copied = data_size - position ;
-        // copy
-        memcpy(dest, src, bytes_copied) ;
-        dest += bytes_copied ;
+            memset(buffer, 0, chunk_len) ;
+        buffer += chunk_len ;
+        position += chunk_len ;
+        len -= chunk_len ;
     }
-    // fill up 00s
-    assert (bytes_copied <= len) ;
-    if (bytes_copied != len)
-        memset(dest, 0, len - bytes_copied) ;
 }
 
 
@@ -347,14 +693,49 @@ void storageimage_memory_c::write(uint8_t *buffer, uint64_t position, unsigned l
 {
     assert(buffer) ;
     assert(is_open()) ;
-    // re-allocate?
-    uint64_t new_size = position + len - 1 ;
-    if (new_size > data_size) {
-        data = (uint8_t *)realloc(data, data_size) ; // conent preserved
-        data_size = new_size ;
+    // grow: only the touched pages get memory
+    pages_resize(position + len) ;
+    while (len > 0) {
+        uint64_t page_idx = position / page_size ;
+        unsigned page_offset = position % page_size ;
+        unsigned chunk_len = std::min(len, page_size - page_offset) ;
+        uint8_t *page = page_data(page_idx, false) ;
+        if (page == nullptr && memcmp(buffer, memory_zero_page, chunk_len))
+            page = page_data(page_idx, true) ;
+        if (page != nullptr) // else 00s to 00 page
+            memcpy(page + page_offset, buffer, chunk_len) ;
+        buffer += chunk_len ;
+        position += chunk_len ;
+        len -= chunk_len ;
     }
-    uint8_t *dest = &(data[position]);
-    memcpy(dest, buffer, len) ;
+}
+
+// unallocated pages are 00s
+bool storageimage_memory_c::is_zero(uint64_t position, unsigned len)
+{
+    assert(is_open()) ;
+    while (len > 0) {
+        uint64_t page_idx = position / page_size ;
+        unsigned page_offset = position % page_size ;
+        unsigned chunk_len = std::min(len, page_size - page_offset) ;
+        uint8_t *page = page_data(page_idx, false) ;
+        if (page != nullptr && memcmp(page + page_offset, memory_zero_page, chunk_len))
+            return false ;
+        position += chunk_len ;
+        len -= chunk_len ;
+    }
+    return true ;
+}
+
+// only inside one page
+uint8_t *storageimage_memory_c::block_ptr(uint64_t position, unsigned len)
+{
+    if (!is_open() || position + len > data_size)
+        return nullptr ;
+    unsigned page_offset = position % page_size ;
+    if (page_offset + len > page_size)
+        return nullptr ;
+    return page_data(position / page_size, true) + page_offset ;
 }
 
 uint64_t storageimage_memory_c::size(void)
@@ -367,8 +748,7 @@ uint64_t storageimage_memory_c::size(void)
 void storageimage_memory_c::close(void)
 {
     assert(is_open()) ;
-    free(data) ;
-    data = nullptr ;
+    pages_free() ;
     // data size remains for next open()
     opened = false ;
 }
@@ -377,25 +757,23 @@ void storageimage_memory_c::close(void)
 void storageimage_memory_c::get_bytes(byte_buffer_c* byte_buffer, uint64_t byte_offset, uint32_t len)
 {
     byte_buffer->set_size(len) ;
-    assert(byte_offset < data_size) ;
-    uint8_t *src = &(data[byte_offset]) ;
-    uint8_t *dest = byte_buffer->data_ptr() ;
-    assert(src+len <= data+size()) ; // no overrun allowed
-    memcpy(dest, src, len) ;
+    assert(byte_offset + len <= data_size) ; // no overrun allowed
+    if (len > 0)
+        read(byte_buffer->data_ptr(), byte_offset, len) ;
 }
 
 // write and free cache buffer
 void storageimage_memory_c::set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)
 {
-    uint8_t *src = byte_buffer->data_ptr() ;
     assert(byte_offset < data_size) ;
-    uint8_t *dest = &(data[byte_offset]);
-    memcpy(dest, src, byte_buffer->size()) ;
+    if (byte_buffer->size() > 0)
+        write(byte_buffer->data_ptr(), byte_offset, byte_buffer->size()) ;
 }
 
 
 
-// load complete image from a host file
+// attach image to a host file, pages are loaded on first access.
+// File stays open until close() or truncate().
 // if result_file_created:
 bool storageimage_memory_c::load_from_file(std::string _host_filename,
         bool allowcreate, bool *result_file_created)
@@ -404,6 +782,7 @@ bool storageimage_memory_c::load_from_file(std::string _host_filename,
 
     bool result ;
     bool file_created = false ;
+    assert(is_open()) ;
     try {
         host_filename = absolute_path(&_host_filename) ;
 
@@ -428,25 +807,21 @@ bool storageimage_memory_c::load_from_file(std::string _host_filename,
         ::stat(host_filename.c_str(), &file_status);
 
         // clear image
-        memset(data, 0, data_size);
+        pages_free() ;
+        pages_resize(data_size) ;
 
-        if (!file_created) {
-            // read existing file
+        if (file_created)
+            ::close(file_descriptor) ;
+        else {
+            // existing file
             if (!is_fileset(&host_filename, 0, data_size))
                 if (file_status.st_size > (off_t)data_size) { // trunc ?
+                    ::close(file_descriptor) ;
                     FATAL("storageimage_memory_c::load_from_disk(): File \"%s\" is %" PRId64 " bytes, shall be trunc'd to %" PRId64 " bytes, non-zero data would be lost",
                           host_filename.c_str(), (uint64_t)file_status.st_size, data_size) ;
                 }
-
-            int res = ::read(file_descriptor, data, data_size);
-            ::close(file_descriptor) ;
-
-            // read file to memory
-            if (res < 0)
-                throw printf_exception("storageimage_memory_c::load_from_disk(): cannot read \"%s\"", host_filename.c_str()) ;
-            if (res < file_status.st_size)
-                throw printf_exception("storageimage_memory_c::load_from_disk(): cannot read %" PRId64 " bytes from \"%s\"",
-                                       (uint64_t)file_status.st_size, host_filename.c_str()) ;
+            load_fd = file_descriptor ;
+            load_size = std::min((uint64_t)file_status.st_size, data_size) ;
         }
 
         result = true ;
@@ -466,13 +841,28 @@ void storageimage_memory_c::save_to_file(std::string _host_filename)
     std::string host_filename = absolute_path(&_host_filename) ;
 
     try {
+        // file may be the one to load from: load all pages now
+        if (load_fd >= 0) {
+            for (uint64_t page_idx = 0; page_idx < pages.size(); page_idx++)
+                page_data(page_idx, false) ;
+            ::close(load_fd) ;
+            load_fd = -1 ;
+        }
         // opens image file for full rewrite or creates it
         int32_t file_descriptor;
         file_descriptor = ::open(host_filename.c_str(), O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666);
         if (file_descriptor < 0)
             throw printf_exception("storageimage_memory_c::data_save_to_disk() cannot open \"%s\"",
                                    host_filename.c_str());
-        ::write(file_descriptor, data, data_size);
+        // 00 pages as holes
+        for (uint64_t page_idx = 0; page_idx < pages.size(); page_idx++) {
+            uint64_t page_pos = page_idx * page_size ;
+            if (pages[page_idx] != nullptr)
+                ::pwrite(file_descriptor, pages[page_idx], std::min((uint64_t)page_size, data_size - page_pos), page_pos);
+        }
+        if (::ftruncate(file_descriptor, data_size) != 0)
+            throw printf_exception("storageimage_memory_c::data_save_to_disk() cannot write \"%s\"",
+                                   host_filename.c_str());
         ::close(file_descriptor);
     }
     catch(std::exception& e) {
@@ -20,12 +20,16 @@
  IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
  CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
+ 16-oct-2026	agent   get_bytes_view()
+ 16-oct-2026	agent   storageimage_memory_c in pages, lazy load
+ 16-oct-2026	agent   storageimage_mmap_c, block_ptr()
  07-mar-2021	JH      start
 
  A disk/tape emulation (storage drive) saves data onto some magnetic surface,
  organized as filesystem.
  On Linux side this is saves a
  - plain binary file (SimH compatible block stream)
+ - same, but memory mapped
  - an unpacked shared directory with file tree
 
 
@@ -36,6 +40,8 @@
 #include <stdint.h>
 #include <string>
 #include <fstream>
+#include <mutex>
+#include <vector>
 #include "logsource.hpp"
 #include "bytebuffer.hpp"
 
@@ -57,10 +63,20 @@ public:
     virtual void set_zero(uint64_t position, unsigned len) ;
     virtual bool is_zero(uint64_t position, unsigned len) ;
 
+    // Direct pointer to "len" bytes at "position", if the image holds them in memory.
+    // nullptr: not possible, use read()/write().
+    // Valid until next write() beyond image end, truncate() or close().
+    // After changing data via the pointer, call block_ptr_written().
+    virtual uint8_t *block_ptr(uint64_t position, unsigned len) ;
+    virtual void block_ptr_written(uint64_t position, unsigned len) ;
+
     virtual uint64_t size(void)= 0;
+    // write data held in memory to the host file, image stays open
+    virtual void flush(void) ;
     virtual void close(void)= 0;
     virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) = 0;
     virtual void set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)= 0 ;
+    byte_buffer_view_c get_bytes_view(byte_buffer_c *buffer, uint64_t byte_offset, uint32_t data_size) ;
 
     //	bool image_load_from_disk(string host_filename, 		bool allowcreate, bool *filecreated) ;
     virtual void save_to_file(std::string host_filename) = 0 ; // make a snapshot
@@ -104,26 +120,102 @@ public:
 
 } ;
 
+// Same file format as storageimage_binfile_c, but the whole file is mmap()ed.
+// read()/write() are memcpy() without syscall, block_ptr() gives access
+// without any copy. Kernel writes pages back, msync() as given by "sync_policy".
+// The mapping does not move while the image is open.
+class storageimage_mmap_c: public storageimage_base_c {
+public:
+    enum sync_policy_e {
+        sync_close, // msync() only on close()
+        sync_async, // schedule write back after each write()
+        sync_write // wait for write back after each write()
+    } ;
+    enum sync_policy_e sync_policy ;
+
+private:
+    bool readonly ;
+    int fd ; // image file, -1 if closed
+    std::string image_fname ;
+    uint8_t *map ; // whole image file, nullptr if empty
+    uint64_t map_size ; // = file size
+    uint64_t map_capacity ; // mapped bytes, fixed on open(). Drive capacity.
+
+    bool resize(uint64_t new_size) ;
+    uint64_t mapped_size(void) ;
+    void sync(uint64_t position, unsigned len) ;
+
+public:
+    storageimage_mmap_c(std::string _image_fname, enum sync_policy_e _sync_policy) {
+        image_fname = _image_fname ;
+        sync_policy = _sync_policy ;
+        readonly = false ;
+        fd = -1 ;
+        map = nullptr ;
+        map_size = map_capacity = 0 ;
+    }
+
+    virtual ~storageimage_mmap_c() override {
+        close() ;
+    }
+
+    virtual bool is_readonly() override {
+        return readonly ;
+    }
+    virtual bool open(storagedrive_c *drive, bool create) override;
+    virtual bool is_open(	void) override;
+    virtual bool truncate(void) override;
+    virtual void read(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual void write(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual bool is_zero(uint64_t position, unsigned len) override ;
+    virtual uint8_t *block_ptr(uint64_t position, unsigned len) override ;
+    virtual void block_ptr_written(uint64_t position, unsigned len) override ;
+    virtual uint64_t size(void) override;
+    virtual void flush(void) override;
+    virtual void close(void) override;
+    virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) override;
+    virtual void set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset) override ;
+    virtual void save_to_file(std::string host_filename) override ;
+} ;
+
 // in-memory version of disk image file
+// Image is held in pages, allocated on first write. Pages never written are 00s
+// and need no memory, so writes beyond the end cost only the new page.
+// After load_from_file() pages are read from the file on first access.
 class storageimage_memory_c: public storageimage_base_c {
+public:
+    static const unsigned page_size = 4096 ;
+
 private:
     bool readonly ;
     std::fstream f; // image file
     // std::string image_fname ;
-    uint8_t 	*data ; // the disk image content
+    std::vector<uint8_t *> pages ; // the disk image content, nullptr = 00s
+    std::vector<bool> page_loaded ; // page content taken from "load_fd"
+    std::mutex pages_mutex ; // pages[], page_loaded[] against parallel I/O threads
     uint64_t	data_size ;
     bool opened ; // between open() and close()
 
+    // file for lazy page loading
+    int load_fd ;
+    uint64_t load_size ; // bytes of file to load
+
+    void pages_free(void) ;
+    void pages_resize(uint64_t size) ;
+    uint8_t *page_data(uint64_t page_idx, bool alloc) ;
+
 public:
     storageimage_memory_c(unsigned _capacity) {
+        readonly = false ;
         opened = false;
-        data = nullptr ;
+        load_fd = -1 ;
+        load_size = 0 ;
         data_size = _capacity ;
     }
 
-    // nothing to free
     virtual ~storageimage_memory_c() override {
-        close() ;
+        if (is_open())
+            close() ;
     }
 
     virtual bool is_readonly() override {
@@ -134,6 +226,8 @@ public:
     virtual bool truncate(void) override;
     virtual void read(uint8_t *buffer, uint64_t position, unsigned len) override;
     virtual void write(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual bool is_zero(uint64_t position, unsigned len) override ;
+    virtual uint8_t *block_ptr(uint64_t position, unsigned len) override ;
     virtual uint64_t size(void) override;
     virtual void close(void) override;
     virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) override;
@@ -0,0 +1,375 @@
+/* storageimage_cache.cpp: write-back block cache in front of a storage image
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ Write-back cache for any storageimage_base_c.
+ The backend image sees only whole changed byte ranges of 4KB blocks,
+ written in ascending block order on flush().
+ Backend file size grows only on flush, size() reports the cached size.
+ */
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+
+#include "logger.hpp"
+#include "utils.hpp"
+#include "timeout.hpp"
+#include "storageimage_cache.hpp"
+
+storageimage_cache_c::storageimage_cache_c(storageimage_base_c *_backend, unsigned _block_count)
+{
+    backend = _backend ;
+    log_label = "imgcache" ;
+    block_count = _block_count ;
+    assert(block_count > 0) ;
+    data = (uint8_t *)malloc((size_t)block_count * block_size) ;
+    assert(data) ;
+    blocks.resize(block_count) ;
+    dirty.resize(block_count) ;
+    pthread_mutex_init(&mutex, NULL) ;
+    pthread_cond_init(&flusher_cond, NULL) ;
+    invalidate() ;
+    // may be installed on open image
+    image_size = backend->is_open() ? backend->size() : 0 ;
+    hits = misses = 0 ;
+    last_flush_us = 0 ;
+    flush_period_ms = 1000 ;
+    last_flush_ns = timeout_c::abstime_ns() ;
+
+    flusher_terminate = false ;
+    flush_requested = false ;
+    int status = pthread_create(&flusher_pthread, NULL, &storageimage_cache_flusher_pthread_wrapper, this) ;
+    if (status != 0)
+        FATAL("Failed to create storageimage_cache_c.flusher_pthread with status = %d", status);
+}
+
+storageimage_cache_c::~storageimage_cache_c()
+{
+    pthread_mutex_lock(&mutex) ;
+    flusher_terminate = true ;
+    pthread_cond_signal(&flusher_cond) ;
+    pthread_mutex_unlock(&mutex) ;
+    int status = pthread_join(flusher_pthread, NULL) ;
+    if (status != 0)
+        FATAL("Failed to join with storageimage_cache_c.flusher_pthread with status = %d", status);
+    if (backend != nullptr) {
+        if (backend->is_open())
+            flush() ;
+        delete backend ;
+    }
+    free(data) ;
+    pthread_cond_destroy(&flusher_cond) ;
+    pthread_mutex_destroy(&mutex) ;
+}
+
+// flush and hand the image back, cache is unusable then
+storageimage_base_c *storageimage_cache_c::release_backend(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (backend->is_open())
+        flush_locked() ;
+    invalidate() ;
+    storageimage_base_c *result = backend ;
+    backend = nullptr ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+
+/*** LRU list and slot management. Caller holds mutex ***/
+
+void storageimage_cache_c::lru_unlink(unsigned slot)
+{
+    cache_block_t *b = &blocks[slot] ;
+    if (b->lru_prev >= 0)
+        blocks[b->lru_prev].lru_next = b->lru_next ;
+    else
+        lru_head = b->lru_next ;
+    if (b->lru_next >= 0)
+        blocks[b->lru_next].lru_prev = b->lru_prev ;
+    else
+        lru_tail = b->lru_prev ;
+    b->lru_prev = b->lru_next = -1 ;
+}
+
+void storageimage_cache_c::lru_push_head(unsigned slot)
+{
+    cache_block_t *b = &blocks[slot] ;
+    b->lru_prev = -1 ;
+    b->lru_next = lru_head ;
+    if (lru_head >= 0)
+        blocks[lru_head].lru_prev = slot ;
+    lru_head = slot ;
+    if (lru_tail < 0)
+        lru_tail = slot ;
+}
+
+// forget all cached blocks, dirty data is lost
+void storageimage_cache_c::invalidate(void)
+{
+    slot_of_block.clear() ;
+    lru_head = lru_tail = -1 ;
+    for (unsigned slot = 0; slot < block_count; slot++) {
+        blocks[slot].valid = false ;
+        dirty[slot] = false ;
+        lru_push_head(slot) ;
+    }
+    dirty_count = 0 ;
+}
+
+// write changed bytes of a block to backend
+void storageimage_cache_c::write_back(unsigned slot)
+{
+    cache_block_t *b = &blocks[slot] ;
+    assert(dirty[slot]) ;
+    backend->write(data + (size_t)slot * block_size + b->dirty_from,
+                   b->block_number * block_size + b->dirty_from, b->dirty_to - b->dirty_from) ;
+    dirty[slot] = false ;
+    dirty_count-- ;
+}
+
+// find block in cache, or load it into the least recently used slot.
+// fill = false: caller overwrites whole block, no backend read needed.
+unsigned storageimage_cache_c::slot_get(uint64_t block_number, bool fill)
+{
+    unsigned slot ;
+    auto it = slot_of_block.find(block_number) ;
+    if (it != slot_of_block.end()) {
+        hits++ ;
+        slot = it->second ;
+    } else {
+        misses++ ;
+        assert(lru_tail >= 0) ;
+        slot = lru_tail ;
+        cache_block_t *b = &blocks[slot] ;
+        if (b->valid) {
+            if (dirty[slot])
+                write_back(slot) ;
+            slot_of_block.erase(b->block_number) ;
+        }
+        b->block_number = block_number ;
+        b->valid = true ;
+        slot_of_block[block_number] = slot ;
+        if (fill)
+            backend->read(data + (size_t)slot * block_size, block_number * block_size, block_size) ;
+    }
+    lru_unlink(slot) ;
+    lru_push_head(slot) ;
+    return slot ;
+}
+
+// write all dirty blocks in ascending order, sequential for the SD card
+void storageimage_cache_c::flush_locked(void)
+{
+    if (dirty_count == 0)
+        return ;
+    uint64_t start_ns = timeout_c::abstime_ns() ;
+    std::vector<unsigned> slots ;
+    for (unsigned slot = 0; slot < block_count; slot++)
+        if (dirty[slot])
+            slots.push_back(slot) ;
+    std::sort(slots.begin(), slots.end(), [this](unsigned a, unsigned b) {
+        return blocks[a].block_number < blocks[b].block_number ;
+    }) ;
+    for (unsigned slot : slots)
+        write_back(slot) ;
+    last_flush_ns = timeout_c::abstime_ns() ;
+    last_flush_us = (last_flush_ns - start_ns) / 1000 ;
+    DEBUG("flushed %u blocks in %u us", (unsigned)slots.size(), last_flush_us) ;
+}
+
+// write dirty blocks, then let the backend persist them
+void storageimage_cache_c::flush(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (backend != nullptr && backend->is_open()) {
+        flush_locked() ;
+        backend->flush() ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void *storageimage_cache_flusher_pthread_wrapper(void *context)
+{
+    storageimage_cache_c *storageimage_cache = (storageimage_cache_c *)context ;
+    storageimage_cache->flusher_worker() ;
+    return NULL;
+}
+
+// Let the flusher thread write back all dirty blocks, do not wait.
+// For callers which must not block, like bus INIT and power events.
+void storageimage_cache_c::flush_request(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    flush_requested = true ;
+    pthread_cond_signal(&flusher_cond) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// flush on request and periodically, check every 100ms
+void storageimage_cache_c::flusher_worker(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    while (!flusher_terminate) {
+        struct timespec abstime ;
+        clock_gettime(CLOCK_REALTIME, &abstime) ;
+        abstime.tv_nsec += 100 * 1000000L ;
+        abstime.tv_sec += abstime.tv_nsec / 1000000000 ;
+        abstime.tv_nsec %= 1000000000 ;
+        if (!flush_requested)
+            pthread_cond_timedwait(&flusher_cond, &mutex, &abstime) ;
+        bool flush_due = flush_requested ;
+        flush_requested = false ;
+        if (flush_period_ms > 0 && timeout_c::abstime_ns() - last_flush_ns >= (uint64_t)flush_period_ms * 1000000)
+            flush_due = true ;
+        if (flush_due && dirty_count > 0 && backend != nullptr && backend->is_open()) {
+            flush_locked() ;
+            backend->flush() ;
+        }
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+
+/*** storageimage_base_c interface ***/
+
+bool storageimage_cache_c::is_readonly()
+{
+    return backend->is_readonly() ;
+}
+
+bool storageimage_cache_c::open(storagedrive_c *_drive, bool create)
+{
+    drive = _drive ;
+    pthread_mutex_lock(&mutex) ;
+    if (backend->is_open())
+        flush_locked() ; // open() closes: after RL11 INIT
+    invalidate() ;
+    bool result = backend->open(_drive, create) ;
+    image_size = backend->is_open() ? backend->size() : 0 ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+bool storageimage_cache_c::is_open(void)
+{
+    return backend->is_open() ;
+}
+
+// discard cache content and image
+bool storageimage_cache_c::truncate(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    invalidate() ;
+    bool result = backend->truncate() ;
+    image_size = 0 ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+void storageimage_cache_c::read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(is_open());
+    assert(buffer != nullptr) ;
+    pthread_mutex_lock(&mutex) ;
+    while (len > 0) {
+        uint64_t block_number = position / block_size ;
+        unsigned offset = position % block_size ;
+        unsigned chunk = std::min(len, block_size - offset) ;
+        unsigned slot = slot_get(block_number, true) ;
+        memcpy(buffer, data + (size_t)slot * block_size + offset, chunk) ;
+        buffer += chunk ;
+        position += chunk ;
+        len -= chunk ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_cache_c::write(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(buffer) ;
+    assert(is_open());
+    assert(!is_readonly()); // caller must take care
+    pthread_mutex_lock(&mutex) ;
+    image_size = std::max(image_size, position + len) ;
+    while (len > 0) {
+        uint64_t block_number = position / block_size ;
+        unsigned offset = position % block_size ;
+        unsigned chunk = std::min(len, block_size - offset) ;
+        unsigned slot = slot_get(block_number, /*fill*/chunk != block_size) ;
+        cache_block_t *b = &blocks[slot] ;
+        memcpy(data + (size_t)slot * block_size + offset, buffer, chunk) ;
+        if (dirty[slot]) {
+            b->dirty_from = std::min(b->dirty_from, offset) ;
+            b->dirty_to = std::max(b->dirty_to, offset + chunk) ;
+        } else {
+            dirty[slot] = true ;
+            dirty_count++ ;
+            b->dirty_from = offset ;
+            b->dirty_to = offset + chunk ;
+        }
+        buffer += chunk ;
+        position += chunk ;
+        len -= chunk ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+uint64_t storageimage_cache_c::size(void)
+{
+    return image_size ;
+}
+
+void storageimage_cache_c::close(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (backend->is_open()) {
+        flush_locked() ;
+        backend->close() ;
+    }
+    invalidate() ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_cache_c::get_bytes(byte_buffer_c* byte_buffer, uint64_t byte_offset, uint32_t len)
+{
+    byte_buffer->set_size(len) ;
+    read(byte_buffer->data_ptr(), byte_offset, len) ;
+}
+
+void storageimage_cache_c::set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)
+{
+    write(byte_buffer->data_ptr(), byte_offset, byte_buffer->size()) ;
+}
+
+// snapshot of backend is complete after flush
+void storageimage_cache_c::save_to_file(std::string host_filename)
+{
+    pthread_mutex_lock(&mutex) ;
+    flush_locked() ;
+    backend->save_to_file(host_filename) ;
+    pthread_mutex_unlock(&mutex) ;
+}
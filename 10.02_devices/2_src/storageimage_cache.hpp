@@ -0,0 +1,112 @@
+/* storageimage_cache.hpp: write-back block cache in front of a storage image
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ Write-back cache for any storageimage_base_c.
+ Image is cached in blocks of 4KB, replaced in LRU order.
+ Written blocks are marked in a dirty bitmap and written to the "backend"
+ image on flush(): on close(), on the "flush" menu command and by a
+ flusher thread, periodically and on flush_request().
+ Bus INIT and power down only request the flush, so the bus event
+ processing is not blocked by image I/O.
+ */
+#ifndef _STORAGEIMAGE_CACHE_HPP_
+#define _STORAGEIMAGE_CACHE_HPP_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+#include <unordered_map>
+
+#include "storageimage.hpp"
+
+class storageimage_cache_c: public storageimage_base_c {
+public:
+    static const unsigned block_size = 4096 ;
+
+private:
+    storageimage_base_c *backend ; // owned
+
+    pthread_mutex_t mutex ; // drive worker, flusher thread and menu
+
+    struct cache_block_t {
+        uint64_t block_number ;
+        bool valid ;
+        unsigned dirty_from, dirty_to ; // changed byte range, if dirty
+        int lru_prev, lru_next ; // slot indexes, -1 = none
+    } ;
+    unsigned block_count ; // capacity
+    uint8_t *data ; // block_count * block_size
+    std::vector<cache_block_t> blocks ;
+    std::vector<bool> dirty ; // dirty bitmap, by slot
+    std::unordered_map<uint64_t, unsigned> slot_of_block ;
+    int lru_head, lru_tail ; // head = most recently used
+
+    uint64_t image_size ; // with written data not yet flushed
+
+    void lru_unlink(unsigned slot) ;
+    void lru_push_head(unsigned slot) ;
+    void invalidate(void) ;
+    void write_back(unsigned slot) ;
+    unsigned slot_get(uint64_t block_number, bool fill) ;
+    void flush_locked(void) ;
+
+    // periodic and requested flush. flags under "mutex"
+    pthread_t flusher_pthread ;
+    pthread_cond_t flusher_cond ;
+    bool flusher_terminate ;
+    bool flush_requested ;
+    uint64_t last_flush_ns ;
+
+public:
+    storageimage_cache_c(storageimage_base_c *backend, unsigned block_count) ;
+    virtual ~storageimage_cache_c() override ;
+
+    unsigned flush_period_ms ; // 0 = no periodic flush
+
+    // statistics
+    uint64_t hits, misses ;
+    unsigned dirty_count ;
+    unsigned last_flush_us ; // duration of last flush with data
+
+    virtual void flush(void) override ;
+    void flush_request(void) ;
+    storageimage_base_c *release_backend(void) ;
+    void flusher_worker(void) ;
+
+    virtual bool is_readonly() override ;
+    virtual bool open(storagedrive_c *drive, bool create) override;
+    virtual bool is_open(	void) override;
+    virtual bool truncate(void) override;
+    virtual void read(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual void write(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual uint64_t size(void) override;
+    virtual void close(void) override;
+    virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) override;
+    virtual void set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset) override ;
+    virtual void save_to_file(std::string host_filename) override ;
+} ;
+
+void *storageimage_cache_flusher_pthread_wrapper(void *context) ;
+
+#endif
@@ -0,0 +1,499 @@
+/* storageimage_chunked.cpp: sparse image file of compressed chunks
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ If the image file does not exist, but <image>.gz, the gzip stream is
+ converted once into chunks. Chunks of 00s are not stored.
+ */
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <algorithm>
+
+#ifndef O_BINARY
+#define O_BINARY 0		// for linux compatibility
+#endif
+
+#include "logger.hpp"
+#include "utils.hpp"
+#include "storageimage_chunked.hpp"
+
+static const char chunked_magic[16] = { 'Q', 'U', 'N', 'I', 'B', 'O', 'N', 'E', '-', 'C', 'H', 'U', 'N', 'K', 'E', 'D' } ;
+
+storageimage_chunked_c::storageimage_chunked_c(std::string _image_fname)
+{
+    image_fname = _image_fname ;
+    log_label = "imgchunk" ;
+    readonly = false ;
+    fd = -1 ;
+    pthread_mutex_init(&mutex, NULL) ;
+    use_counter = 0 ;
+    for (unsigned i = 0; i < chunk_cache_count; i++) {
+        chunk_cache[i].valid = false ;
+        chunk_cache[i].dirty = false ;
+        chunk_cache[i].data = (uint8_t *)malloc(chunk_size) ;
+        assert(chunk_cache[i].data) ;
+    }
+    compress_buffer = (uint8_t *)malloc(compressBound(chunk_size)) ;
+    assert(compress_buffer) ;
+}
+
+storageimage_chunked_c::~storageimage_chunked_c()
+{
+    close() ;
+    for (unsigned i = 0; i < chunk_cache_count; i++)
+        free(chunk_cache[i].data) ;
+    free(compress_buffer) ;
+    pthread_mutex_destroy(&mutex) ;
+}
+
+// read header and index of open file
+bool storageimage_chunked_c::header_read(void)
+{
+    struct stat file_status ;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+            || memcmp(header.magic, chunked_magic, sizeof(chunked_magic))
+            || header.version != 1 || header.chunk_size != chunk_size)
+        return false ;
+    index.resize(header.chunk_count) ;
+    ssize_t index_bytes = header.chunk_count * sizeof(index_entry_t) ;
+    if (index_bytes > 0 && pread(fd, index.data(), index_bytes, header.index_position) != index_bytes)
+        return false ;
+    fstat(fd, &file_status) ;
+    file_end = file_status.st_size ;
+    index_changed = false ;
+    return true ;
+}
+
+// append index, then let header point to it
+// previous index stays valid until header is written
+bool storageimage_chunked_c::header_index_write(void)
+{
+    ssize_t index_bytes = index.size() * sizeof(index_entry_t) ;
+    if (index_bytes > 0 && pwrite(fd, index.data(), index_bytes, file_end) != index_bytes)
+        return false ;
+    fdatasync(fd) ;
+    header.chunk_count = index.size() ;
+    header.index_position = file_end ;
+    file_end += index_bytes ;
+    if (pwrite(fd, &header, sizeof(header), 0) != sizeof(header))
+        return false ;
+    index_changed = false ;
+    return true ;
+}
+
+// decompress chunk from file
+bool storageimage_chunked_c::chunk_load(uint32_t chunk_number, uint8_t *data)
+{
+    if (chunk_number >= index.size() || index[chunk_number].position == 0) {
+        memset(data, 0, chunk_size) ;
+        return true ;
+    }
+    index_entry_t *entry = &index[chunk_number] ;
+    if (entry->length == chunk_size)
+        return pread(fd, data, chunk_size, entry->position) == chunk_size ;
+    uLongf data_len = chunk_size ;
+    if (pread(fd, compress_buffer, entry->length, entry->position) != (ssize_t)entry->length
+            || uncompress(data, &data_len, compress_buffer, entry->length) != Z_OK
+            || data_len != chunk_size) {
+        ERROR("%s: chunk %u corrupt", image_fname.c_str(), chunk_number) ;
+        memset(data, 0, chunk_size) ;
+        return false ;
+    }
+    return true ;
+}
+
+// compress chunk and append to "dest_fd" at "dest_position", chunks of 00s are not written.
+// result: bytes written
+uint32_t storageimage_chunked_c::chunk_store(const uint8_t *data, int dest_fd, uint64_t *dest_position,
+        index_entry_t *entry)
+{
+    entry->reserved = 0 ;
+    if (data[0] == 0 && !memcmp(data, data + 1, chunk_size - 1)) {
+        entry->position = 0 ;
+        entry->length = 0 ;
+        return 0 ;
+    }
+    uLongf len = compressBound(chunk_size) ;
+    const uint8_t *src = compress_buffer ;
+    if (compress2(compress_buffer, &len, data, chunk_size, Z_BEST_SPEED) != Z_OK || len >= chunk_size) {
+        // incompressible
+        src = data ;
+        len = chunk_size ;
+    }
+    if (pwrite(dest_fd, src, len, *dest_position) != (ssize_t)len)
+        ERROR("%s: write failure", image_fname.c_str()) ;
+    entry->position = *dest_position ;
+    entry->length = len ;
+    *dest_position += len ;
+    return len ;
+}
+
+// decompressed chunk from cache, least recently used one is replaced
+storageimage_chunked_c::cached_chunk_t *storageimage_chunked_c::chunk_get(uint32_t chunk_number)
+{
+    cached_chunk_t *victim = &chunk_cache[0] ;
+    for (unsigned i = 0; i < chunk_cache_count; i++) {
+        cached_chunk_t *cc = &chunk_cache[i] ;
+        if (cc->valid && cc->chunk_number == chunk_number) {
+            cc->last_use = ++use_counter ;
+            return cc ;
+        }
+        if (!cc->valid)
+            victim = cc ;
+        else if (victim->valid && cc->last_use < victim->last_use)
+            victim = cc ;
+    }
+    if (victim->valid && victim->dirty)
+        chunk_write_back(victim) ;
+    chunk_load(chunk_number, victim->data) ;
+    victim->chunk_number = chunk_number ;
+    victim->valid = true ;
+    victim->dirty = false ;
+    victim->last_use = ++use_counter ;
+    return victim ;
+}
+
+// changed chunk: append, old location becomes garbage
+void storageimage_chunked_c::chunk_write_back(cached_chunk_t *cc)
+{
+    assert(cc->chunk_number < index.size()) ;
+    chunk_store(cc->data, fd, &file_end, &index[cc->chunk_number]) ;
+    cc->dirty = false ;
+    index_changed = true ;
+}
+
+void storageimage_chunked_c::chunk_cache_flush(bool invalidate)
+{
+    for (unsigned i = 0; i < chunk_cache_count; i++) {
+        cached_chunk_t *cc = &chunk_cache[i] ;
+        if (cc->valid && cc->dirty)
+            chunk_write_back(cc) ;
+        if (invalidate)
+            cc->valid = false ;
+    }
+}
+
+void storageimage_chunked_c::set_image_size(uint64_t new_size)
+{
+    header.image_size = new_size ;
+    index_entry_t hole = { 0, 0, 0 } ;
+    index.resize((new_size + chunk_size - 1) / chunk_size, hole) ;
+    index_changed = true ;
+}
+
+// one-time conversion of a gzip'd plain image, streamed chunk by chunk
+bool storageimage_chunked_c::convert_from_gz(std::string gz_fname)
+{
+    gzFile gz = gzopen(gz_fname.c_str(), "rb") ;
+    if (gz == NULL)
+        return false ;
+    INFO("Converting \"%s\" to chunked image \"%s\" ...", gz_fname.c_str(), image_fname.c_str()) ;
+
+    memset(&header, 0, sizeof(header)) ;
+    memcpy(header.magic, chunked_magic, sizeof(chunked_magic)) ;
+    header.version = 1 ;
+    header.chunk_size = chunk_size ;
+    index.clear() ;
+    file_end = sizeof(header) ;
+    uint8_t *data = chunk_cache[0].data ;
+    uint64_t image_size = 0 ;
+    unsigned stored_count = 0 ;
+    bool eof = false ;
+    while (!eof) {
+        unsigned fill = 0 ;
+        while (fill < chunk_size) {
+            int n = gzread(gz, data + fill, chunk_size - fill) ;
+            if (n < 0) {
+                ERROR("\"%s\" is corrupt", gz_fname.c_str()) ;
+                gzclose(gz) ;
+                return false ;
+            }
+            if (n == 0) {
+                eof = true ;
+                break ;
+            }
+            fill += n ;
+        }
+        if (fill == 0)
+            break ;
+        memset(data + fill, 0, chunk_size - fill) ;
+        index_entry_t entry ;
+        if (chunk_store(data, fd, &file_end, &entry) > 0)
+            stored_count++ ;
+        index.push_back(entry) ;
+        image_size += fill ;
+    }
+    gzclose(gz) ;
+    header.image_size = image_size ;
+    if (!header_index_write())
+        return false ;
+    INFO("... complete: %" PRIu64 " bytes, %u of %u chunks stored, file size %" PRIu64 ".",
+         image_size, stored_count, (unsigned)index.size(), file_end) ;
+    return true ;
+}
+
+// open chunked image file, read only header and index
+bool storageimage_chunked_c::open(storagedrive_c *_drive, bool create)
+{
+    drive = _drive ;
+    if (is_open())
+        close(); // after RL11 INIT
+    readonly = false ;
+    if (image_fname.empty())
+        return true ; // ! is_open
+
+    fd = ::open(image_fname.c_str(), O_BINARY | O_RDWR) ;
+    if (fd < 0) {
+        fd = ::open(image_fname.c_str(), O_BINARY | O_RDONLY) ;
+        readonly = (fd >= 0) ;
+    }
+    if (fd < 0) {
+        std::string gz_fname = image_fname + ".gz" ;
+        if (file_exists(&gz_fname)) {
+            fd = ::open(image_fname.c_str(), O_BINARY | O_RDWR | O_CREAT | O_TRUNC, 0666) ;
+            if (fd >= 0 && !convert_from_gz(gz_fname)) {
+                ::close(fd) ;
+                fd = -1 ;
+                unlink(image_fname.c_str()) ;
+            }
+        } else if (create) {
+            fd = ::open(image_fname.c_str(), O_BINARY | O_RDWR | O_CREAT, 0666) ;
+            if (fd >= 0) {
+                memset(&header, 0, sizeof(header)) ;
+                memcpy(header.magic, chunked_magic, sizeof(chunked_magic)) ;
+                header.version = 1 ;
+                header.chunk_size = chunk_size ;
+                index.clear() ;
+                file_end = sizeof(header) ;
+                header_index_write() ;
+                INFO("Created empty image file %s.", image_fname.c_str()) ;
+            } else
+                INFO("Creating empty image file %s FAILED.", image_fname.c_str()) ;
+        }
+    }
+    if (fd < 0)
+        return false ;
+    if (!header_read()) {
+        ERROR("\"%s\" is not a chunked image file", image_fname.c_str()) ;
+        ::close(fd) ;
+        fd = -1 ;
+        return false ;
+    }
+    return true ;
+}
+
+bool storageimage_chunked_c::is_open()
+{
+    return fd >= 0 ;
+}
+
+// empty image
+bool storageimage_chunked_c::truncate()
+{
+    assert(is_open());
+    assert(!readonly); // caller must take care
+    pthread_mutex_lock(&mutex) ;
+    for (unsigned i = 0; i < chunk_cache_count; i++)
+        chunk_cache[i].valid = false ;
+    index.clear() ;
+    header.image_size = 0 ;
+    file_end = sizeof(header) ;
+    bool result = (ftruncate(fd, file_end) == 0) && header_index_write() ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+/* read "len" bytes into buffer
+ * beyond image size 00s are read
+ */
+void storageimage_chunked_c::read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(is_open());
+    assert(buffer != nullptr) ;
+    pthread_mutex_lock(&mutex) ;
+    while (len > 0) {
+        uint32_t chunk_number = position / chunk_size ;
+        unsigned offset = position % chunk_size ;
+        unsigned part = std::min(len, chunk_size - offset) ;
+        if (chunk_number >= index.size())
+            memset(buffer, 0, part) ;
+        else
+            memcpy(buffer, chunk_get(chunk_number)->data + offset, part) ;
+        buffer += part ;
+        position += part ;
+        len -= part ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+/* write "len" bytes from buffer into image at "position"
+ * if image too short, it is extended
+ */
+void storageimage_chunked_c::write(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(buffer);
+    assert(is_open());
+    assert(!readonly); // caller must take care
+    pthread_mutex_lock(&mutex) ;
+    if (position + len > header.image_size)
+        set_image_size(position + len) ;
+    while (len > 0) {
+        uint32_t chunk_number = position / chunk_size ;
+        unsigned offset = position % chunk_size ;
+        unsigned part = std::min(len, chunk_size - offset) ;
+        cached_chunk_t *cc = chunk_get(chunk_number) ;
+        memcpy(cc->data + offset, buffer, part) ;
+        cc->dirty = true ;
+        buffer += part ;
+        position += part ;
+        len -= part ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+uint64_t storageimage_chunked_c::size(void)
+{
+    return is_open() ? header.image_size : 0 ;
+}
+
+// rewrite file with only the current chunks, if more than half is garbage
+// index must be current
+void storageimage_chunked_c::compact(void)
+{
+    uint64_t live_bytes = sizeof(header) + index.size() * sizeof(index_entry_t) ;
+    for (unsigned i = 0; i < index.size(); i++)
+        live_bytes += index[i].length ;
+    if (file_end < 2 * live_bytes + 0x100000)
+        return ;
+
+    std::string tmp_fname = image_fname + ".compact" ;
+    int tmp_fd = ::open(tmp_fname.c_str(), O_BINARY | O_RDWR | O_CREAT | O_TRUNC, 0666) ;
+    if (tmp_fd < 0)
+        return ;
+    uint64_t tmp_end = sizeof(header) ;
+    std::vector<index_entry_t> tmp_index = index ;
+    bool ok = true ;
+    for (unsigned i = 0; ok && i < index.size(); i++) {
+        if (index[i].position == 0)
+            continue ;
+        // copy compressed data as is
+        ok = pread(fd, compress_buffer, index[i].length, index[i].position) == (ssize_t)index[i].length
+             && pwrite(tmp_fd, compress_buffer, index[i].length, tmp_end) == (ssize_t)index[i].length ;
+        tmp_index[i].position = tmp_end ;
+        tmp_end += index[i].length ;
+    }
+    ssize_t index_bytes = tmp_index.size() * sizeof(index_entry_t) ;
+    header_t tmp_header = header ;
+    tmp_header.index_position = tmp_end ;
+    ok = ok && (index_bytes == 0 || pwrite(tmp_fd, tmp_index.data(), index_bytes, tmp_end) == index_bytes)
+         && pwrite(tmp_fd, &tmp_header, sizeof(tmp_header), 0) == sizeof(tmp_header)
+         && fsync(tmp_fd) == 0 ;
+    ::close(tmp_fd) ;
+    if (ok && rename(tmp_fname.c_str(), image_fname.c_str()) == 0)
+        INFO("%s compacted from %" PRIu64 " to %" PRIu64 " bytes", image_fname.c_str(), file_end, tmp_end + index_bytes) ;
+    else
+        unlink(tmp_fname.c_str()) ;
+}
+
+// write changed chunks and index, file is then consistent with all writes.
+// Replaced chunks and indexes stay in the file until close() compacts.
+void storageimage_chunked_c::flush(void)
+{
+    if (!is_open())
+        return ;
+    pthread_mutex_lock(&mutex) ;
+    if (!readonly) {
+        chunk_cache_flush(/*invalidate*/false) ;
+        if (index_changed && !header_index_write())
+            ERROR("%s: can not write index", image_fname.c_str()) ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_chunked_c::close(void)
+{
+    if (!is_open())
+        return ;
+    pthread_mutex_lock(&mutex) ;
+    if (!readonly) {
+        chunk_cache_flush(/*invalidate*/true) ;
+        if (index_changed) {
+            if (!header_index_write())
+                ERROR("%s: can not write index", image_fname.c_str()) ;
+            compact() ;
+        }
+    }
+    for (unsigned i = 0; i < chunk_cache_count; i++)
+        chunk_cache[i].valid = false ;
+    ::close(fd) ;
+    fd = -1 ;
+    readonly = false;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_chunked_c::get_bytes(byte_buffer_c* byte_buffer, uint64_t byte_offset, uint32_t len)
+{
+    byte_buffer->set_size(len) ;
+    read(byte_buffer->data_ptr(), byte_offset, len) ;
+}
+
+void storageimage_chunked_c::set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)
+{
+    write(byte_buffer->data_ptr(), byte_offset, byte_buffer->size()) ;
+}
+
+// write as plain binary image
+void storageimage_chunked_c::save_to_file(std::string _host_filename)
+{
+    std::string host_filename = absolute_path(&_host_filename) ;
+    assert(is_open()) ;
+
+    try {
+        int32_t file_descriptor;
+        file_descriptor = ::open(host_filename.c_str(), O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (file_descriptor < 0)
+            throw printf_exception("storageimage_chunked_c::save_to_file() cannot open \"%s\"",
+                                   host_filename.c_str());
+        pthread_mutex_lock(&mutex) ;
+        bool ok = true ;
+        for (uint32_t chunk_number = 0; ok && chunk_number < index.size(); chunk_number++) {
+            uint64_t position = (uint64_t)chunk_number * chunk_size ;
+            ssize_t len = std::min((uint64_t)chunk_size, header.image_size - position) ;
+            ok = ::write(file_descriptor, chunk_get(chunk_number)->data, len) == len ;
+        }
+        pthread_mutex_unlock(&mutex) ;
+        ::close(file_descriptor);
+        if (!ok)
+            throw printf_exception("storageimage_chunked_c::save_to_file() cannot write \"%s\"",
+                                   host_filename.c_str());
+    }
+    catch(std::exception& e) {
+        ERROR(e.what()) ;
+    }
+}
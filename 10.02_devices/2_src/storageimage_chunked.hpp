@@ -0,0 +1,119 @@
+/* storageimage_chunked.hpp: sparse image file of compressed chunks
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ Image file format:
+ - header: magic, chunk size, image size, position of index
+ - chunks: 32KB of image data, each compressed with zlib
+ - index: file position and length of each chunk. Position 0 = all 00s.
+ All numbers little endian.
+
+ Only header and index are read on open(), chunks are decompressed on access.
+ Changed chunks are never overwritten: they are compressed and appended,
+ the index is appended and the header updated on flush() and close().
+ Until then the previous index is valid, the file is always consistent.
+ Space of replaced chunks is reclaimed by compacting on close().
+ */
+#ifndef _STORAGEIMAGE_CHUNKED_HPP_
+#define _STORAGEIMAGE_CHUNKED_HPP_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <vector>
+
+#include "storageimage.hpp"
+
+class storageimage_chunked_c: public storageimage_base_c {
+public:
+    static const unsigned chunk_size = 0x8000 ;
+    static const unsigned chunk_cache_count = 8 ; // decompressed chunks in memory
+
+private:
+    struct header_t {
+        char magic[16] ;
+        uint32_t version ;
+        uint32_t chunk_size ;
+        uint64_t image_size ;
+        uint64_t index_position ;
+        uint32_t chunk_count ;
+        uint32_t reserved ;
+    } ;
+    struct index_entry_t {
+        uint64_t position ; // 0 = chunk is all 00s, not stored
+        uint32_t length ; // compressed size. == chunk_size: stored uncompressed
+        uint32_t reserved ;
+    } ;
+    struct cached_chunk_t {
+        uint32_t chunk_number ;
+        bool valid ;
+        bool dirty ;
+        uint64_t last_use ;
+        uint8_t *data ;
+    } ;
+
+    bool readonly ;
+    int fd ; // image file, -1 if closed
+    std::string image_fname ;
+    pthread_mutex_t mutex ;
+
+    header_t header ;
+    std::vector<index_entry_t> index ;
+    uint64_t file_end ; // append position
+    bool index_changed ;
+
+    cached_chunk_t chunk_cache[chunk_cache_count] ;
+    uint64_t use_counter ;
+    uint8_t *compress_buffer ;
+
+    bool header_read(void) ;
+    bool header_index_write(void) ;
+    bool chunk_load(uint32_t chunk_number, uint8_t *data) ;
+    uint32_t chunk_store(const uint8_t *data, int dest_fd, uint64_t *dest_position, index_entry_t *entry) ;
+    cached_chunk_t *chunk_get(uint32_t chunk_number) ;
+    void chunk_write_back(cached_chunk_t *cc) ;
+    void chunk_cache_flush(bool invalidate) ;
+    bool convert_from_gz(std::string gz_fname) ;
+    void compact(void) ;
+    void set_image_size(uint64_t new_size) ;
+
+public:
+    storageimage_chunked_c(std::string _image_fname) ;
+    virtual ~storageimage_chunked_c() override ;
+
+    virtual bool is_readonly() override {
+        return readonly ;
+    }
+    virtual bool open(storagedrive_c *drive, bool create) override;
+    virtual bool is_open(	void) override;
+    virtual bool truncate(void) override;
+    virtual void read(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual void write(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual uint64_t size(void) override;
+    virtual void flush(void) override;
+    virtual void close(void) override;
+    virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) override;
+    virtual void set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset) override ;
+    virtual void save_to_file(std::string host_filename) override ; // plain binary image
+} ;
+
+#endif
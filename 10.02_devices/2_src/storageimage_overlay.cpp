@@ -0,0 +1,365 @@
+/* storageimage_overlay.cpp: copy-on-write overlay over a read-only base image
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ Many sessions can boot from the same "golden" base image,
+ each with its own delta file. Reset = discard().
+ */
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+
+#ifndef O_BINARY
+#define O_BINARY 0		// for linux compatibility
+#endif
+
+#include "logger.hpp"
+#include "utils.hpp"
+#include "storageimage_overlay.hpp"
+
+static const char overlay_magic[16] = { 'Q', 'U', 'N', 'I', 'B', 'O', 'N', 'E', '-', 'O', 'V', 'E', 'R', 'L', 'A', 'Y' } ;
+
+storageimage_overlay_c::storageimage_overlay_c(storageimage_base_c *_base, std::string _delta_fname)
+{
+    base = _base ;
+    delta_fname = _delta_fname ;
+    log_label = "imgovl" ;
+    fd = -1 ;
+    readonly = false ;
+    file_end = 0 ;
+    memset(&header, 0, sizeof(header)) ;
+    pthread_mutex_init(&mutex, NULL) ;
+}
+
+storageimage_overlay_c::~storageimage_overlay_c()
+{
+    close() ;
+    if (base != nullptr)
+        delete base ;
+    pthread_mutex_destroy(&mutex) ;
+}
+
+// close delta and hand the base image back
+storageimage_base_c *storageimage_overlay_c::release_base(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (fd >= 0) {
+        ::close(fd) ;
+        fd = -1 ;
+    }
+    data_position_of_block.clear() ;
+    storageimage_base_c *result = base ;
+    base = nullptr ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+bool storageimage_overlay_c::header_write(void)
+{
+    return pwrite(fd, &header, sizeof(header), 0) == sizeof(header) ;
+}
+
+// read header and rebuild block index from records
+bool storageimage_overlay_c::delta_load(void)
+{
+    struct stat file_status ;
+    fstat(fd, &file_status) ;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header)
+            || memcmp(header.magic, overlay_magic, sizeof(overlay_magic))
+            || header.version != 1 || header.block_size != block_size)
+        return false ;
+    data_position_of_block.clear() ;
+    const unsigned record_size = sizeof(record_header_t) + block_size ;
+    uint64_t position = sizeof(header) ;
+    record_header_t record_header ;
+    while (position + record_size <= (uint64_t)file_status.st_size) {
+        if (pread(fd, &record_header, sizeof(record_header), position) != sizeof(record_header))
+            break ;
+        data_position_of_block[record_header.block_number] = position + sizeof(record_header) ;
+        position += record_size ;
+    }
+    file_end = position ; // an incomplete last record is overwritten
+    return true ;
+}
+
+// base data, with 00s where hidden by truncate()
+void storageimage_overlay_c::base_read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    unsigned base_len = 0 ;
+    if (position < header.base_size)
+        base_len = std::min((uint64_t)len, header.base_size - position) ;
+    if (base_len > 0)
+        base->read(buffer, position, base_len) ;
+    if (base_len < len)
+        memset(buffer + base_len, 0, len - base_len) ;
+}
+
+// open base and delta. A missing delta file is created.
+bool storageimage_overlay_c::open(storagedrive_c *_drive, bool create)
+{
+    drive = _drive ;
+    if (is_open())
+        close(); // after RL11 INIT
+    if (!base->open(_drive, create))
+        return false ;
+
+    readonly = false ;
+    fd = ::open(delta_fname.c_str(), O_BINARY | O_RDWR | O_CREAT, 0666) ;
+    if (fd < 0) {
+        ERROR("Can not open overlay file \"%s\"", delta_fname.c_str()) ;
+        base->close() ;
+        return false ;
+    }
+    struct stat file_status ;
+    fstat(fd, &file_status) ;
+    if (file_status.st_size == 0) {
+        memcpy(header.magic, overlay_magic, sizeof(overlay_magic)) ;
+        header.version = 1 ;
+        header.block_size = block_size ;
+        discard_locked() ;
+        INFO("Created overlay file %s.", delta_fname.c_str()) ;
+    } else if (!delta_load()) {
+        ERROR("\"%s\" is not an overlay file", delta_fname.c_str()) ;
+        ::close(fd) ;
+        fd = -1 ;
+        base->close() ;
+        return false ;
+    } else
+        INFO("Overlay file %s: %u changed blocks.", delta_fname.c_str(),
+             (unsigned)data_position_of_block.size()) ;
+    return true ;
+}
+
+bool storageimage_overlay_c::is_open()
+{
+    return fd >= 0 ;
+}
+
+// empty image: delta is cleared, base hidden
+bool storageimage_overlay_c::truncate()
+{
+    assert(is_open()) ;
+    pthread_mutex_lock(&mutex) ;
+    data_position_of_block.clear() ;
+    file_end = sizeof(header) ;
+    header.image_size = 0 ;
+    header.base_size = 0 ;
+    bool result = ftruncate(fd, file_end) == 0 && header_write() ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+void storageimage_overlay_c::read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(is_open());
+    assert(buffer != nullptr) ;
+    pthread_mutex_lock(&mutex) ;
+    while (len > 0) {
+        uint64_t block_number = position / block_size ;
+        unsigned offset = position % block_size ;
+        unsigned part = std::min(len, block_size - offset) ;
+        auto it = data_position_of_block.find(block_number) ;
+        if (it == data_position_of_block.end())
+            base_read(buffer, position, part) ;
+        else if (pread(fd, buffer, part, it->second + offset) != (ssize_t)part)
+            ERROR("%s: read failure", delta_fname.c_str()) ;
+        buffer += part ;
+        position += part ;
+        len -= part ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// first write to a block copies it from the base into the delta
+void storageimage_overlay_c::write(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(buffer);
+    assert(is_open());
+    assert(!readonly); // caller must take care
+    pthread_mutex_lock(&mutex) ;
+    if (position + len > header.image_size) {
+        header.image_size = position + len ;
+        header_write() ;
+    }
+    uint8_t record[sizeof(record_header_t) + block_size] ;
+    while (len > 0) {
+        uint64_t block_number = position / block_size ;
+        unsigned offset = position % block_size ;
+        unsigned part = std::min(len, block_size - offset) ;
+        auto it = data_position_of_block.find(block_number) ;
+        if (it != data_position_of_block.end()) {
+            if (pwrite(fd, buffer, part, it->second + offset) != (ssize_t)part)
+                ERROR("%s: write failure", delta_fname.c_str()) ;
+        } else {
+            // new record: block number and data in one write
+            ((record_header_t *)record)->block_number = block_number ;
+            uint8_t *block_data = record + sizeof(record_header_t) ;
+            if (part < block_size)
+                base_read(block_data, block_number * block_size, block_size) ;
+            memcpy(block_data + offset, buffer, part) ;
+            if (pwrite(fd, record, sizeof(record), file_end) != sizeof(record))
+                ERROR("%s: write failure", delta_fname.c_str()) ;
+            data_position_of_block[block_number] = file_end + sizeof(record_header_t) ;
+            file_end += sizeof(record) ;
+        }
+        buffer += part ;
+        position += part ;
+        len -= part ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+uint64_t storageimage_overlay_c::size(void)
+{
+    return is_open() ? header.image_size : 0 ;
+}
+
+// delta records to disk. base is only written by commit().
+void storageimage_overlay_c::flush(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (fd >= 0)
+        fdatasync(fd) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_overlay_c::close(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (fd >= 0) {
+        ::close(fd) ;
+        fd = -1 ;
+    }
+    data_position_of_block.clear() ;
+    if (base != nullptr && base->is_open())
+        base->close() ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+unsigned storageimage_overlay_c::delta_block_count(void)
+{
+    return data_position_of_block.size() ;
+}
+
+// forget all changes, image is the base again. Caller holds mutex.
+void storageimage_overlay_c::discard_locked(void)
+{
+    data_position_of_block.clear() ;
+    file_end = sizeof(header) ;
+    if (ftruncate(fd, file_end) != 0)
+        ERROR("%s: can not truncate", delta_fname.c_str()) ;
+    header.image_size = header.base_size = base->size() ;
+    header_write() ;
+}
+
+void storageimage_overlay_c::discard(void)
+{
+    assert(is_open()) ;
+    pthread_mutex_lock(&mutex) ;
+    unsigned block_count = data_position_of_block.size() ;
+    discard_locked() ;
+    pthread_mutex_unlock(&mutex) ;
+    INFO("%s: %u changed blocks discarded.", delta_fname.c_str(), block_count) ;
+}
+
+// write changed blocks into base in ascending order, then empty delta
+bool storageimage_overlay_c::commit(void)
+{
+    assert(is_open()) ;
+    if (base->is_readonly()) {
+        ERROR("Base image is read only, can not commit %s", delta_fname.c_str()) ;
+        return false ;
+    }
+    pthread_mutex_lock(&mutex) ;
+    if (header.base_size < base->size())
+        base->truncate() ; // was truncated via overlay
+    std::vector<uint64_t> block_numbers ;
+    for (auto const &it : data_position_of_block)
+        block_numbers.push_back(it.first) ;
+    std::sort(block_numbers.begin(), block_numbers.end()) ;
+    uint8_t block_buffer[block_size] ;
+    bool ok = true ;
+    for (uint64_t block_number : block_numbers) {
+        uint64_t position = block_number * block_size ;
+        unsigned len = std::min((uint64_t)block_size, header.image_size - position) ;
+        if (pread(fd, block_buffer, len, data_position_of_block[block_number]) != (ssize_t)len) {
+            ok = false ;
+            break ;
+        }
+        base->write(block_buffer, position, len) ;
+    }
+    if (ok) {
+        base->flush() ; // base persistent before delta is emptied
+        discard_locked() ;
+    } else
+        ERROR("%s: read failure, commit aborted", delta_fname.c_str()) ;
+    pthread_mutex_unlock(&mutex) ;
+    if (ok)
+        INFO("%s: %u changed blocks committed.", delta_fname.c_str(), (unsigned)block_numbers.size()) ;
+    return ok ;
+}
+
+void storageimage_overlay_c::get_bytes(byte_buffer_c* byte_buffer, uint64_t byte_offset, uint32_t len)
+{
+    byte_buffer->set_size(len) ;
+    read(byte_buffer->data_ptr(), byte_offset, len) ;
+}
+
+void storageimage_overlay_c::set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)
+{
+    write(byte_buffer->data_ptr(), byte_offset, byte_buffer->size()) ;
+}
+
+// write as plain binary image
+void storageimage_overlay_c::save_to_file(std::string _host_filename)
+{
+    std::string host_filename = absolute_path(&_host_filename) ;
+    assert(is_open()) ;
+
+    try {
+        int32_t file_descriptor;
+        file_descriptor = ::open(host_filename.c_str(), O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if (file_descriptor < 0)
+            throw printf_exception("storageimage_overlay_c::save_to_file() cannot open \"%s\"",
+                                   host_filename.c_str());
+        uint8_t block_buffer[block_size] ;
+        bool ok = true ;
+        for (uint64_t position = 0; ok && position < header.image_size; position += block_size) {
+            unsigned len = std::min((uint64_t)block_size, header.image_size - position) ;
+            read(block_buffer, position, len) ;
+            ok = ::write(file_descriptor, block_buffer, len) == (ssize_t)len ;
+        }
+        ::close(file_descriptor);
+        if (!ok)
+            throw printf_exception("storageimage_overlay_c::save_to_file() cannot write \"%s\"",
+                                   host_filename.c_str());
+    }
+    catch(std::exception& e) {
+        ERROR(e.what()) ;
+    }
+}
@@ -0,0 +1,100 @@
+/* storageimage_overlay.hpp: copy-on-write overlay over a read-only base image
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ The "base" image is never written, all changes go to a "delta" file.
+ Delta file format:
+ - header: magic, block size, image size, visible size of base
+ - records of block number + 4KB block data, in order of first write.
+ The block index is rebuilt from the records on open().
+ Modified blocks are rewritten in place.
+
+ commit() copies the delta blocks into the base, discard() empties the delta.
+ */
+#ifndef _STORAGEIMAGE_OVERLAY_HPP_
+#define _STORAGEIMAGE_OVERLAY_HPP_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <unordered_map>
+
+#include "storageimage.hpp"
+
+class storageimage_overlay_c: public storageimage_base_c {
+public:
+    static const unsigned block_size = 4096 ;
+
+private:
+    struct header_t {
+        char magic[16] ;
+        uint32_t version ;
+        uint32_t block_size ;
+        uint64_t image_size ;
+        uint64_t base_size ; // base data beyond is hidden, after truncate()
+    } ;
+    struct record_header_t {
+        uint64_t block_number ;
+    } ;
+
+    storageimage_base_c *base ; // owned
+    std::string delta_fname ;
+    int fd ; // delta file, -1 if closed
+    bool readonly ;
+    pthread_mutex_t mutex ; // drive worker and menu
+
+    header_t header ;
+    // file position of block data in delta
+    std::unordered_map<uint64_t, uint64_t> data_position_of_block ;
+    uint64_t file_end ; // append position
+
+    bool header_write(void) ;
+    bool delta_load(void) ;
+    void base_read(uint8_t *buffer, uint64_t position, unsigned len) ;
+    void discard_locked(void) ;
+
+public:
+    storageimage_overlay_c(storageimage_base_c *base, std::string delta_fname) ;
+    virtual ~storageimage_overlay_c() override ;
+
+    unsigned delta_block_count(void) ;
+    bool commit(void) ;
+    void discard(void) ;
+    storageimage_base_c *release_base(void) ;
+
+    virtual bool is_readonly() override {
+        return readonly ;
+    }
+    virtual bool open(storagedrive_c *drive, bool create) override;
+    virtual bool is_open(	void) override;
+    virtual bool truncate(void) override;
+    virtual void read(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual void write(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual uint64_t size(void) override;
+    virtual void flush(void) override;
+    virtual void close(void) override;
+    virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) override;
+    virtual void set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset) override ;
+    virtual void save_to_file(std::string host_filename) override ; // base with delta applied
+} ;
+
+#endif
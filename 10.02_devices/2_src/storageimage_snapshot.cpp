@@ -0,0 +1,445 @@
+/* storageimage_snapshot.cpp: point-in-time snapshots of a storage image
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ All backend accesses are serialized by the mutex,
+ the writer thread reads the image block by block in between drive accesses.
+ Snapshot files are written as "<fname>.tmp" and renamed when complete.
+ */
+#include <assert.h>
+#include <inttypes.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <vector>
+
+#ifndef O_BINARY
+#define O_BINARY 0		// for linux compatibility
+#endif
+
+#include "logger.hpp"
+#include "utils.hpp"
+#include "timeout.hpp"
+#include "storageimage_snapshot.hpp"
+
+static const uint8_t snapshot_zero_block[storageimage_snapshot_c::block_size] = { 0 } ;
+
+storageimage_snapshot_c::storageimage_snapshot_c(storageimage_base_c *_backend)
+{
+    backend = _backend ;
+    log_label = "imgsnap" ;
+    pthread_mutex_init(&mutex, NULL) ;
+    pthread_cond_init(&cond, NULL) ;
+
+    writer_terminate = false ;
+    int status = pthread_create(&writer_pthread, NULL, &storageimage_snapshot_writer_pthread_wrapper, this) ;
+    if (status != 0)
+        FATAL("Failed to create storageimage_snapshot_c.writer_pthread with status = %d", status);
+}
+
+storageimage_snapshot_c::~storageimage_snapshot_c()
+{
+    pthread_mutex_lock(&mutex) ;
+    wait_saved_locked() ;
+    writer_terminate = true ;
+    pthread_cond_broadcast(&cond) ;
+    pthread_mutex_unlock(&mutex) ;
+    int status = pthread_join(writer_pthread, NULL) ;
+    if (status != 0)
+        FATAL("Failed to join with storageimage_snapshot_c.writer_pthread with status = %d", status);
+    snapshots_clear() ;
+    if (backend != nullptr)
+        delete backend ;
+    pthread_cond_destroy(&cond) ;
+    pthread_mutex_destroy(&mutex) ;
+}
+
+// complete snapshot files and hand the image back, snapshots are not tracked any more.
+storageimage_base_c *storageimage_snapshot_c::release_backend(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    wait_saved_locked() ;
+    snapshots_clear() ;
+    storageimage_base_c *result = backend ;
+    backend = nullptr ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+void storageimage_snapshot_c::snapshot_free(snapshot_t *snapshot)
+{
+    for (auto &kept : snapshot->kept_blocks)
+        free(kept.second) ;
+    delete snapshot ;
+}
+
+// forget tracking, snapshot files remain. Caller holds mutex.
+void storageimage_snapshot_c::snapshots_clear(void)
+{
+    for (auto &it : snapshots)
+        snapshot_free(it.second) ;
+    snapshots.clear() ;
+}
+
+// Caller holds mutex
+void storageimage_snapshot_c::wait_saved_locked(void)
+{
+    bool all_saved ;
+    do {
+        all_saved = true ;
+        for (auto &it : snapshots)
+            all_saved &= it.second->saved ;
+        if (!all_saved)
+            pthread_cond_wait(&cond, &mutex) ;
+    } while (!all_saved) ;
+}
+
+void storageimage_snapshot_c::wait_saved(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    wait_saved_locked() ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// blocks in range are changed: remember them for all snapshots,
+// keep original content for snapshots not yet saved. Caller holds mutex.
+void storageimage_snapshot_c::copy_on_write(uint64_t position, unsigned len)
+{
+    if (snapshots.empty() || len == 0)
+        return ;
+    uint64_t first_block = position / block_size ;
+    uint64_t last_block = (position + len - 1) / block_size ;
+    for (uint64_t block_number = first_block; block_number <= last_block; block_number++)
+        for (auto &it : snapshots) {
+            snapshot_t *snapshot = it.second ;
+            if (!snapshot->changed_blocks.insert(block_number).second || snapshot->file_valid)
+                continue ; // already changed, or original in file
+            uint8_t *data = (uint8_t *)calloc(1, block_size) ;
+            if (block_number * block_size < snapshot->image_size) // else 00s
+                backend->read(data, block_number * block_size, block_size) ;
+            snapshot->kept_blocks[block_number] = data ;
+        }
+}
+
+// Caller holds mutex
+void storageimage_snapshot_c::write_locked(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    copy_on_write(position, len) ;
+    backend->write(buffer, position, len) ;
+}
+
+// new snapshot of current image state.
+// An older snapshot with same file is replaced.
+bool storageimage_snapshot_c::take(std::string fname)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (backend == nullptr || !backend->is_open()) {
+        pthread_mutex_unlock(&mutex) ;
+        return false ;
+    }
+    auto it = snapshots.find(fname) ;
+    if (it != snapshots.end()) {
+        wait_saved_locked() ; // writer may use it
+        it = snapshots.find(fname) ;
+        snapshot_free(it->second) ;
+        snapshots.erase(it) ;
+    }
+    snapshot_t *snapshot = new snapshot_t() ;
+    snapshot->fname = fname ;
+    snapshot->image_size = backend->size() ;
+    snapshot->saved = false ;
+    snapshot->file_valid = false ;
+    snapshots[fname] = snapshot ;
+    pthread_cond_broadcast(&cond) ; // start writer
+    pthread_mutex_unlock(&mutex) ;
+    return true ;
+}
+
+// write snapshot into file. Called by writer thread without mutex.
+bool storageimage_snapshot_c::save(snapshot_t *snapshot)
+{
+    std::string tmp_fname = snapshot->fname + ".tmp" ;
+    int fd = ::open(tmp_fname.c_str(), O_BINARY | O_WRONLY | O_CREAT | O_TRUNC, 0666) ;
+    if (fd < 0) {
+        ERROR("Cannot create snapshot file \"%s\"", tmp_fname.c_str()) ;
+        return false ;
+    }
+    uint64_t start_ns = timeout_c::abstime_ns() ;
+    uint8_t buffer[block_size] ;
+    bool ok = true ;
+    uint64_t block_count = (snapshot->image_size + block_size - 1) / block_size ;
+    for (uint64_t block_number = 0; ok && block_number < block_count; block_number++) {
+        uint64_t position = block_number * block_size ;
+        unsigned len = std::min((uint64_t)block_size, snapshot->image_size - position) ;
+        // drive accesses between blocks
+        pthread_mutex_lock(&mutex) ;
+        auto it = snapshot->kept_blocks.find(block_number) ;
+        if (it != snapshot->kept_blocks.end())
+            memcpy(buffer, it->second, len) ;
+        else
+            backend->read(buffer, position, len) ; // unchanged since take()
+        pthread_mutex_unlock(&mutex) ;
+        if (memcmp(buffer, snapshot_zero_block, len)) // 00s as holes
+            ok = (::pwrite(fd, buffer, len, position) == (ssize_t)len) ;
+    }
+    ok = ok && (::ftruncate(fd, snapshot->image_size) == 0) && (::fdatasync(fd) == 0) ;
+    ::close(fd) ;
+    ok = ok && (::rename(tmp_fname.c_str(), snapshot->fname.c_str()) == 0) ;
+    if (!ok) {
+        ERROR("Cannot write snapshot file \"%s\"", snapshot->fname.c_str()) ;
+        ::unlink(tmp_fname.c_str()) ;
+        return false ;
+    }
+    INFO("Snapshot \"%s\" saved in %u ms", snapshot->fname.c_str(),
+         (unsigned)((timeout_c::abstime_ns() - start_ns) / 1000000)) ;
+    return true ;
+}
+
+void *storageimage_snapshot_writer_pthread_wrapper(void *context)
+{
+    storageimage_snapshot_c *storageimage_snapshot = (storageimage_snapshot_c *)context ;
+    storageimage_snapshot->writer_worker() ;
+    return NULL;
+}
+
+// save snapshots in order of take()
+void storageimage_snapshot_c::writer_worker(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    while (!writer_terminate) {
+        snapshot_t *snapshot = nullptr ;
+        for (auto &it : snapshots)
+            if (!it.second->saved) {
+                snapshot = it.second ;
+                break ;
+            }
+        if (snapshot == nullptr) {
+            pthread_cond_wait(&cond, &mutex) ;
+            continue ;
+        }
+        pthread_mutex_unlock(&mutex) ;
+        bool ok = save(snapshot) ;
+        pthread_mutex_lock(&mutex) ;
+        snapshot->saved = true ;
+        snapshot->file_valid = ok ;
+        if (ok) {
+            // originals now in file
+            for (auto &kept : snapshot->kept_blocks)
+                free(kept.second) ;
+            snapshot->kept_blocks.clear() ;
+        }
+        pthread_cond_broadcast(&cond) ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// restore image to state of snapshot
+bool storageimage_snapshot_c::rollback(std::string fname)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (backend == nullptr || !backend->is_open()) {
+        pthread_mutex_unlock(&mutex) ;
+        return false ;
+    }
+    auto it = snapshots.find(fname) ;
+    if (it == snapshots.end()) {
+        pthread_mutex_unlock(&mutex) ;
+        return rollback_from_file(fname) ;
+    }
+    snapshot_t *snapshot = it->second ;
+    std::vector<uint64_t> block_numbers(snapshot->changed_blocks.begin(), snapshot->changed_blocks.end()) ;
+    std::sort(block_numbers.begin(), block_numbers.end()) ;
+    uint64_t start_ns = timeout_c::abstime_ns() ;
+    uint64_t image_size = backend->size() ;
+    uint8_t buffer[block_size] ;
+    int fd = -1 ;
+    bool ok = true ;
+    for (uint64_t block_number : block_numbers) {
+        uint64_t position = block_number * block_size ;
+        if (position >= image_size)
+            continue ;
+        unsigned len = std::min((uint64_t)block_size, image_size - position) ;
+        auto kept_it = snapshot->kept_blocks.find(block_number) ;
+        if (kept_it != snapshot->kept_blocks.end())
+            memcpy(buffer, kept_it->second, len) ;
+        else {
+            // saved: original in file, 00s beyond its end
+            if (fd < 0)
+                fd = ::open(fname.c_str(), O_BINARY | O_RDONLY) ;
+            memset(buffer, 0, len) ;
+            if (fd < 0 || ::pread(fd, buffer, len, position) < 0) {
+                ERROR("Cannot read snapshot file \"%s\"", fname.c_str()) ;
+                ok = false ;
+                break ;
+            }
+        }
+        write_locked(buffer, position, len) ;
+    }
+    if (fd >= 0)
+        ::close(fd) ;
+    if (ok) {
+        // image is snapshot again
+        snapshot->changed_blocks.clear() ;
+        for (auto &kept : snapshot->kept_blocks)
+            free(kept.second) ;
+        snapshot->kept_blocks.clear() ;
+        DEBUG("Rollback to \"%s\": %u blocks in %u us", fname.c_str(), (unsigned)block_numbers.size(),
+              (unsigned)((timeout_c::abstime_ns() - start_ns) / 1000)) ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+    return ok ;
+}
+
+// snapshot not tracked: compare whole image with file, write different blocks
+bool storageimage_snapshot_c::rollback_from_file(std::string fname)
+{
+    int fd = ::open(fname.c_str(), O_BINARY | O_RDONLY) ;
+    if (fd < 0) {
+        ERROR("Snapshot file \"%s\" not found", fname.c_str()) ;
+        return false ;
+    }
+    uint8_t file_buffer[block_size] ;
+    uint8_t image_buffer[block_size] ;
+    bool ok = true ;
+    pthread_mutex_lock(&mutex) ;
+    uint64_t image_size = backend->size() ;
+    for (uint64_t position = 0; position < image_size; position += block_size) {
+        unsigned len = std::min((uint64_t)block_size, image_size - position) ;
+        memset(file_buffer, 0, len) ; // 00s beyond end of file
+        if (::pread(fd, file_buffer, len, position) < 0) {
+            ERROR("Cannot read snapshot file \"%s\"", fname.c_str()) ;
+            ok = false ;
+            break ;
+        }
+        backend->read(image_buffer, position, len) ;
+        if (memcmp(file_buffer, image_buffer, len))
+            write_locked(file_buffer, position, len) ;
+    }
+    pthread_mutex_unlock(&mutex) ;
+    ::close(fd) ;
+    return ok ;
+}
+
+
+/*** storageimage_base_c interface ***/
+
+bool storageimage_snapshot_c::is_readonly()
+{
+    return backend->is_readonly() ;
+}
+
+// open() closes: after RL11 INIT. Tracking of old image state lost.
+bool storageimage_snapshot_c::open(storagedrive_c *_drive, bool create)
+{
+    drive = _drive ;
+    pthread_mutex_lock(&mutex) ;
+    wait_saved_locked() ;
+    snapshots_clear() ;
+    bool result = backend->open(_drive, create) ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+bool storageimage_snapshot_c::is_open(void)
+{
+    return backend->is_open() ;
+}
+
+// all blocks of snapshots are changed then
+bool storageimage_snapshot_c::truncate(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    wait_saved_locked() ;
+    uint64_t block_count = (backend->size() + block_size - 1) / block_size ;
+    for (uint64_t block_number = 0; block_number < block_count; block_number++)
+        copy_on_write(block_number * block_size, block_size) ;
+    bool result = backend->truncate() ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+void storageimage_snapshot_c::read(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(is_open());
+    pthread_mutex_lock(&mutex) ;
+    backend->read(buffer, position, len) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_snapshot_c::write(uint8_t *buffer, uint64_t position, unsigned len)
+{
+    assert(buffer) ;
+    assert(is_open());
+    assert(!is_readonly()); // caller must take care
+    pthread_mutex_lock(&mutex) ;
+    write_locked(buffer, position, len) ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+uint64_t storageimage_snapshot_c::size(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    uint64_t result = backend->size() ;
+    pthread_mutex_unlock(&mutex) ;
+    return result ;
+}
+
+void storageimage_snapshot_c::flush(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    if (backend != nullptr && backend->is_open())
+        backend->flush() ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+// snapshot files are completed, then no longer tracked
+void storageimage_snapshot_c::close(void)
+{
+    pthread_mutex_lock(&mutex) ;
+    wait_saved_locked() ;
+    snapshots_clear() ;
+    if (backend->is_open())
+        backend->close() ;
+    pthread_mutex_unlock(&mutex) ;
+}
+
+void storageimage_snapshot_c::get_bytes(byte_buffer_c* byte_buffer, uint64_t byte_offset, uint32_t len)
+{
+    byte_buffer->set_size(len) ;
+    read(byte_buffer->data_ptr(), byte_offset, len) ;
+}
+
+void storageimage_snapshot_c::set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset)
+{
+    write(byte_buffer->data_ptr(), byte_offset, byte_buffer->size()) ;
+}
+
+void storageimage_snapshot_c::save_to_file(std::string host_filename)
+{
+    pthread_mutex_lock(&mutex) ;
+    backend->save_to_file(host_filename) ;
+    pthread_mutex_unlock(&mutex) ;
+}
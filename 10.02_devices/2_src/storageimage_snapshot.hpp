@@ -0,0 +1,105 @@
+/* storageimage_snapshot.hpp: point-in-time snapshots of a storage image
+
+ Copyright (c) 2026, agent
+ agent@local
+
+ Permission is hereby granted, free of charge, to any person obtaining a
+ copy of this software and associated documentation files (the "Software"),
+ to deal in the Software without restriction, including without limitation
+ the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ and/or sell copies of the Software, and to permit persons to whom the
+ Software is furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in
+ all copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ THE AUTHOR BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+ 16-oct-2026	agent   created
+
+ take() records a snapshot in O(1): from then on, before a 4KB block
+ is written the first time, its original content is kept in memory.
+ A writer thread saves the snapshot as plain binary image file,
+ from the kept blocks and the unchanged blocks of the image.
+ After save, only the numbers of changed blocks are tracked.
+
+ rollback() writes back the changed blocks only, from memory or the
+ snapshot file. Snapshot files not tracked (after close()) are copied completely.
+ The image size is never reduced by rollback.
+ */
+#ifndef _STORAGEIMAGE_SNAPSHOT_HPP_
+#define _STORAGEIMAGE_SNAPSHOT_HPP_
+
+#include <stdint.h>
+#include <pthread.h>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "storageimage.hpp"
+
+class storageimage_snapshot_c: public storageimage_base_c {
+public:
+    static const unsigned block_size = 4096 ;
+
+private:
+    struct snapshot_t {
+        std::string fname ;
+        uint64_t image_size ; // at take()
+        // original content of changed blocks, until saved
+        std::unordered_map<uint64_t, uint8_t *> kept_blocks ;
+        // blocks different from snapshot
+        std::unordered_set<uint64_t> changed_blocks ;
+        bool saved ; // writer done
+        bool file_valid ; // saved without error, else blocks are kept
+    } ;
+
+    storageimage_base_c *backend ; // owned
+
+    pthread_mutex_t mutex ; // drive worker, writer thread and menu
+    pthread_cond_t cond ; // snapshot taken or saved
+    std::map<std::string, snapshot_t *> snapshots ; // by fname
+
+    pthread_t writer_pthread ;
+    volatile bool writer_terminate ;
+
+    void snapshot_free(snapshot_t *snapshot) ;
+    void snapshots_clear(void) ;
+    void wait_saved_locked(void) ;
+    void copy_on_write(uint64_t position, unsigned len) ;
+    void write_locked(uint8_t *buffer, uint64_t position, unsigned len) ;
+    bool save(snapshot_t *snapshot) ;
+    bool rollback_from_file(std::string fname) ;
+
+public:
+    storageimage_snapshot_c(storageimage_base_c *backend) ;
+    virtual ~storageimage_snapshot_c() override ;
+
+    bool take(std::string fname) ;
+    bool rollback(std::string fname) ;
+    void wait_saved(void) ;
+    storageimage_base_c *release_backend(void) ;
+    void writer_worker(void) ;
+
+    virtual bool is_readonly() override ;
+    virtual bool open(storagedrive_c *drive, bool create) override;
+    virtual bool is_open(	void) override;
+    virtual bool truncate(void) override;
+    virtual void read(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual void write(uint8_t *buffer, uint64_t position, unsigned len) override;
+    virtual uint64_t size(void) override;
+    virtual void flush(void) override;
+    virtual void close(void) override;
+    virtual void get_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset, uint32_t data_size) override;
+    virtual void set_bytes(byte_buffer_c *byte_buffer, uint64_t byte_offset) override ;
+    virtual void save_to_file(std::string host_filename) override ;
+} ;
+
+void *storageimage_snapshot_writer_pthread_wrapper(void *context) ;
+
+#endif
@@ -36,7 +36,7 @@ tmscp_server::~tmscp_server()
 }
 
 
-uint32_t tmscp_server::DispatchCommand(const std::shared_ptr<Message> message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError)
+uint32_t tmscp_server::DispatchCommand(Message* message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError)
 {
      /* 21     4.3  Tape Specific MSCP Commands And Responses
 
@@ -115,7 +115,7 @@ GetDrive(
 }
 
 uint32_t 
-tmscp_server::Access(std::shared_ptr<Message> message, uint16_t unitNumber) 
+tmscp_server::Access(Message* message, uint16_t unitNumber) 
 {
     return 0;
 }
@@ -127,49 +127,49 @@ tmscp_server::Available(uint16_t unitNumber, uint16_t modifiers)
 }
 
 uint32_t 
-tmscp_server::CompareHostData(std::shared_ptr<Message> message, uint16_t unitNumber)
+tmscp_server::CompareHostData(Message* message, uint16_t unitNumber)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::Erase(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers)
+tmscp_server::Erase(Message* message, uint16_t unitNumber, uint16_t modifiers)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::GetUnitStatus(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers)
+tmscp_server::GetUnitStatus(Message* message, uint16_t unitNumber, uint16_t modifiers)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::Online(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers)
+tmscp_server::Online(Message* message, uint16_t unitNumber, uint16_t modifiers)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::Read(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers)
+tmscp_server::Read(Message* message, uint16_t unitNumber, uint16_t modifiers)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::SetControllerCharacteristics(std::shared_ptr<Message> message)
+tmscp_server::SetControllerCharacteristics(Message* message)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::SetUnitCharacteristics(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers)
+tmscp_server::SetUnitCharacteristics(Message* message, uint16_t unitNumber, uint16_t modifiers)
 {
     return 0;
 }
 
 uint32_t 
-tmscp_server::Write(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers)
+tmscp_server::Write(Message* message, uint16_t unitNumber, uint16_t modifiers)
 {
     return 0;
 }
@@ -25,26 +25,26 @@ public:
     ~tmscp_server();
 
 protected:
-    uint32_t DispatchCommand(const std::shared_ptr<Message> message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError) override;
+    uint32_t DispatchCommand(Message* message, const ControlMessageHeader* header, uint16_t modifiers, bool *protocolError) override;
 
 private:
     // TMSCP-specific implementations:
-    uint32_t Access(std::shared_ptr<Message> message, uint16_t unitNumber) override;
+    uint32_t Access(Message* message, uint16_t unitNumber) override;
     uint32_t Available(uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t CompareHostData(std::shared_ptr<Message> message, uint16_t unitNumber) override;
-    uint32_t Erase(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t GetUnitStatus(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t Online(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t Read(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t SetControllerCharacteristics(std::shared_ptr<Message> message) override;
-    uint32_t SetUnitCharacteristics(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
-    uint32_t Write(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t CompareHostData(Message* message, uint16_t unitNumber) override;
+    uint32_t Erase(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t GetUnitStatus(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t Online(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t Read(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t SetControllerCharacteristics(Message* message) override;
+    uint32_t SetUnitCharacteristics(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
+    uint32_t Write(Message* message, uint16_t unitNumber, uint16_t modifiers) override;
 
 private:
     // Commands unique to TMSCP
-    uint32_t EraseGap(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers);
-    uint32_t Reposition(std::shared_ptr<Message> message, uint16_t unitNumber);
-    uint32_t WriteTapeMark(std::shared_ptr<Message> message, uint16_t unitNumber, uint16_t modifiers);
+    uint32_t EraseGap(Message* message, uint16_t unitNumber, uint16_t modifiers);
+    uint32_t Reposition(Message* message, uint16_t unitNumber);
+    uint32_t WriteTapeMark(Message* message, uint16_t unitNumber, uint16_t modifiers);
 
 private:
     tmscp_drive_c* GetDrive(uint32_t unitNumber);
@@ -35,11 +35,87 @@
 
 namespace mscp {
 
+MessagePool::MessagePool() :
+    _freeList(nullptr),
+    _capacity(0),
+    _allocated(0)
+{
+    pthread_mutex_init(&_mutex, NULL);
+}
+
+MessagePool::~MessagePool()
+{
+    // buffers in use belong to a dead server now, not reclaimed
+    while (_freeList)
+    {
+        Entry* entry = _freeList;
+        _freeList = entry->next;
+        delete entry;
+    }
+    pthread_mutex_destroy(&_mutex);
+}
+
+void MessagePool::SetCapacity(size_t capacity)
+{
+    pthread_mutex_lock(&_mutex);
+    _capacity = capacity;
+    while (_allocated > _capacity && _freeList)
+    {
+        Entry* entry = _freeList;
+        _freeList = entry->next;
+        delete entry;
+        _allocated--;
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
+//
+// Allocate():
+//  Takes a buffer from the free list, or creates a new one
+//  if capacity allows.
+//
+Message* MessagePool::Allocate(void)
+{
+    Entry* entry = nullptr;
+    pthread_mutex_lock(&_mutex);
+    if (_freeList)
+    {
+        entry = _freeList;
+        _freeList = entry->next;
+    }
+    else if (_allocated < _capacity)
+    {
+        entry = new Entry;
+        _allocated++;
+    }
+    pthread_mutex_unlock(&_mutex);
+    return entry ? &entry->message : nullptr;
+}
+
+void MessagePool::Release(Message* message)
+{
+    Entry* entry = reinterpret_cast<Entry*>(message);
+    pthread_mutex_lock(&_mutex);
+    if (_allocated > _capacity)
+    {
+        delete entry;
+        _allocated--;
+    }
+    else
+    {
+        entry->next = _freeList;
+        _freeList = entry;
+    }
+    pthread_mutex_unlock(&_mutex);
+}
+
 uda_c::uda_c(PortType portType) :
         storagecontroller_c(),
         _controllerType(UDA50),
         _portType(portType),
         _22bitDMA(false),
+        _dmaMutex(PTHREAD_MUTEX_INITIALIZER),
+        _intrMutex(PTHREAD_MUTEX_INITIALIZER),
         _server(nullptr),
         _ringBase(0),
         _commandRingLength(0),
@@ -446,6 +522,7 @@ uda_c::on_after_register_access(
                     _interruptEnable = !!(value & 0x80);
                     _responseRingLength = (1 << ((value & 0x700) >> 8));
                     _commandRingLength = (1 << ((value & 0x3800) >> 11));
+                    _messagePool.SetCapacity(_commandRingLength);
 
                     DEBUG_FAST("Step1: 0x%x", value); 
                     DEBUG_FAST("resp ring 0x%x", _responseRingLength);
@@ -571,8 +648,8 @@ uda_c::update_SA(uint16_t value)
 // GetNextCommand():
 //  Attempts to pull the next command from the command ring, if any
 //  are available.
-//  If successful, returns a pointer to a Message struct; this pointer
-//  is owned by the caller.
+//  If successful, returns a pointer to a Message struct from the message
+//  pool; the caller returns it with ReleaseCommand().
 //  On failure, nullptr is returned.  This indicates that the ring is
 //  empty or that an attempt to access non-existent memory occurred.
 //  The error pointer is set to true if an error occurred during the 
@@ -638,15 +715,21 @@ uda_c::GetNextCommand(bool* error)
             return nullptr;
         }     
    
-        std::unique_ptr<Message> cmdMessage(
-            reinterpret_cast<Message*>(
-                DMARead(
-                    messageAddress - 4,
-                    messageLength + 4, 
-                    sizeof(Message)))); 
-
+        // All buffers busy: leave the command in the ring,
+        // the server picks it up after releasing some.
+        Message* cmdMessage = _messagePool.Allocate();
         if (!cmdMessage)
         {
+            DEBUG_FAST("No free message buffer.");
+            return nullptr;
+        }
+
+        if (!DMARead(
+                messageAddress - 4,
+                messageLength + 4,
+                reinterpret_cast<uint8_t*>(cmdMessage)))
+        {
+            _messagePool.Release(cmdMessage);
             PortError(PORT_ERROR_RING_READ);
             *error = true;
             return nullptr;
@@ -685,6 +768,7 @@ uda_c::GetNextCommand(bool* error)
 
                 if (!previousDescriptor)
                 {
+                    _messagePool.Release(cmdMessage);
                     PortError(PORT_ERROR_RING_READ);
                     *error = true;
                     return nullptr;
@@ -711,6 +795,7 @@ uda_c::GetNextCommand(bool* error)
             sizeof(Descriptor),
             reinterpret_cast<uint8_t*>(cmdDescriptor.get())))
         {
+            _messagePool.Release(cmdMessage);
             PortError(PORT_ERROR_RING_WRITE);
             *error = true;
             return nullptr;
@@ -730,7 +815,7 @@ uda_c::GetNextCommand(bool* error)
             Interrupt();
         }
 
-        return cmdMessage.release();
+        return cmdMessage;
     }
    
     DEBUG_FAST("No descriptor found.  0x%x 0x%x", cmdDescriptor->Word0.Word0, cmdDescriptor->Word1.Word1);  
@@ -973,7 +1058,10 @@ uda_c::Interrupt(void)
 {
     if ((_interruptEnable || _initStep == InitializationStep::Complete) && _interruptVector != 0)
     {
+        // raised by the polling thread and by unit threads
+        pthread_mutex_lock(&_intrMutex);
         qunibusadapter->INTR(intr_request, NULL, 0); 
+        pthread_mutex_unlock(&_intrMutex);
     }
 }
 
@@ -1091,6 +1179,26 @@ uda_c::DMAReadWord(
 }
 
 
+//
+// TransferBenchmark():
+//  Runs the 64 KB transfer benchmark of the MSCP server on a unit.
+//  Returns false for a TMSCP port.
+//
+bool
+uda_c::TransferBenchmark(
+    uint16_t unitNumber,
+    uint32_t address,
+    unsigned count)
+{
+    mscp_server* server = dynamic_cast<mscp_server*>(_server.get());
+    if (nullptr == server)
+    {
+        return false;
+    }
+    server->TransferBenchmark(unitNumber, address, count);
+    return true;
+}
+
 //
 // DMAWrite():
 //  Write data from the provided buffer to Qbus/Unibus memory.  Returns true
@@ -1107,12 +1215,15 @@ uda_c::DMAWrite(
     assert((lengthInBytes % 2) == 0);
     assert(address < 2 * qunibus->addr_space_word_count); // exceeds address space? test for IOpage too?
 
+    pthread_mutex_lock(&_dmaMutex);
     qunibusadapter->DMA(dma_request, true,
             QUNIBUS_CYCLE_DATO,
             address,
             reinterpret_cast<uint16_t*>(buffer),
             lengthInBytes >> 1);
-	return dma_request.success ;
+    bool success = dma_request.success;
+    pthread_mutex_unlock(&_dmaMutex);
+	return success ;
 }
 
 //
@@ -1137,13 +1248,16 @@ uda_c::DMARead(
 
     assert(buffer);
 
+    pthread_mutex_lock(&_dmaMutex);
     qunibusadapter->DMA(dma_request, true,
                 QUNIBUS_CYCLE_DATI,
                 address,
                 buffer,
                 lengthInBytes >> 1);
+    bool success = dma_request.success;
+    pthread_mutex_unlock(&_dmaMutex);
 
-    if (dma_request.success)
+    if (success)
     { 
 	    return reinterpret_cast<uint8_t*>(buffer);
     }
@@ -1153,4 +1267,129 @@ uda_c::DMARead(
     }
 } 
 
+
+//
+// DMARead():
+// Read data from Qbus/Unibus memory into the provided buffer.
+// Returns false if memory could not be read.
+//
+bool
+uda_c::DMARead(
+    uint32_t address,
+    size_t lengthInBytes,
+    uint8_t* buffer)
+{
+    assert((lengthInBytes % 2) == 0);
+    assert(address < 2 * qunibus->addr_space_word_count); // exceeds address space? test for IOpage too?
+
+    pthread_mutex_lock(&_dmaMutex);
+    qunibusadapter->DMA(dma_request, true,
+                QUNIBUS_CYCLE_DATI,
+                address,
+                reinterpret_cast<uint16_t*>(buffer),
+                lengthInBytes >> 1);
+    bool success = dma_request.success;
+    pthread_mutex_unlock(&_dmaMutex);
+    return success;
+}
+
+//
+// DMAWrite():
+//  Scatter-gather version: writes each segment's buffer to its Qbus/Unibus
+//  address, with a single DMA request.  Returns false on NXM.
+//
+bool
+uda_c::DMAWrite(
+    const dma_segment_t* segments,
+    unsigned segmentCount)
+{
+    pthread_mutex_lock(&_dmaMutex);
+    qunibusadapter->DMA(dma_request, true,
+            QUNIBUS_CYCLE_DATO,
+            segments,
+            segmentCount);
+    bool success = dma_request.success;
+    pthread_mutex_unlock(&_dmaMutex);
+    return success;
+}
+
+//
+// DMARead():
+//  Scatter-gather version: reads each segment from its Qbus/Unibus
+//  address into its buffer, with a single DMA request.  Returns false on NXM.
+//
+bool
+uda_c::DMARead(
+    const dma_segment_t* segments,
+    unsigned segmentCount)
+{
+    pthread_mutex_lock(&_dmaMutex);
+    qunibusadapter->DMA(dma_request, true,
+            QUNIBUS_CYCLE_DATI,
+            segments,
+            segmentCount);
+    bool success = dma_request.success;
+    pthread_mutex_unlock(&_dmaMutex);
+    return success;
+}
+
+//
+// DMAWriteAsync():
+//  Start a write of the provided buffer to Qbus/Unibus memory and return
+//  immediately.  Completion and result are obtained with DMAWait();
+//  the buffer must not be touched until then.
+//  Transfers of other threads wait until then.
+//
+void
+uda_c::DMAWriteAsync(
+    uint32_t address,
+    size_t lengthInBytes,
+    uint8_t* buffer)
+{
+    assert((lengthInBytes % 2) == 0);
+    assert(address < 2 * qunibus->addr_space_word_count); // exceeds address space? test for IOpage too?
+
+    pthread_mutex_lock(&_dmaMutex); // until DMAWait()
+    qunibusadapter->DMA(dma_request, false,
+            QUNIBUS_CYCLE_DATO,
+            address,
+            reinterpret_cast<uint16_t*>(buffer),
+            lengthInBytes >> 1);
+}
+
+//
+// DMAReadAsync():
+//  Start a read from Qbus/Unibus memory into the provided buffer and return
+//  immediately.  Buffer contents are valid after DMAWait() returned true.
+//
+void
+uda_c::DMAReadAsync(
+    uint32_t address,
+    size_t lengthInBytes,
+    uint8_t* buffer)
+{
+    assert((lengthInBytes % 2) == 0);
+    assert(address < 2 * qunibus->addr_space_word_count); // exceeds address space? test for IOpage too?
+
+    pthread_mutex_lock(&_dmaMutex); // until DMAWait()
+    qunibusadapter->DMA(dma_request, false,
+            QUNIBUS_CYCLE_DATI,
+            address,
+            reinterpret_cast<uint16_t*>(buffer),
+            lengthInBytes >> 1);
+}
+
+//
+// DMAWait():
+//  Wait for the transfer started by DMAWriteAsync() or DMAReadAsync().
+//  Returns true on success, false on an NXM condition.
+//
+bool
+uda_c::DMAWait(void)
+{
+    bool success = dma_request.wait();
+    pthread_mutex_unlock(&_dmaMutex);
+    return success;
+}
+
 } // end namespace
\ No newline at end of file
@@ -31,10 +31,6 @@ namespace mscp {
 #define UDA50_ID 0x0063
 #define RQDX3_ID 0x0133
 
-// The maximum message length we can handle.  This is provided as a sanity check
-// to prevent parsing clearly invalid commands.
-#define MAX_MESSAGE_LENGTH 0x1000
-
 #define STEP1    0x0800
 #define STEP2    0x1000
 #define STEP3    0x2000
@@ -74,6 +70,38 @@ struct Message
 };
 #pragma pack(pop)
 
+/*
+  Command message buffers, recycled through an intrusive free list.
+  A buffer holds the largest message the port accepts, and at most
+  one buffer per command ring slot is ever allocated:
+  no heap traffic per command after the first ring cycle.
+*/
+class MessagePool
+{
+public:
+    MessagePool();
+    ~MessagePool();
+
+    // Buffers beyond a new smaller capacity are freed when released.
+    void SetCapacity(size_t capacity);
+
+    // Returns nullptr if all buffers are in use.
+    Message* Allocate(void);
+    void Release(Message* message);
+
+private:
+    union Entry
+    {
+        Message message;
+        Entry* next;
+    };
+
+    Entry* _freeList;
+    size_t _capacity;
+    size_t _allocated;
+    pthread_mutex_t _mutex;
+};
+
 /*
   This implements the Transport layer for a Qbus/Unibus MSCP controller.
 
@@ -107,15 +135,25 @@ public:
     // Configuration parameter for 22-bit DMA
     parameter_bool_c twenty_two_bit_DMA = parameter_bool_c(this, "22_bit_dma", "dma22",
         false, "Enable 22-bit DMA"); 
+
+    // MSCP command scheduler
+    parameter_bool_c seek_order = parameter_bool_c(this, "seek_order", "so", /*readonly*/
+        false, "Execute READ/WRITE of a unit in LBN order (elevator), merge adjacent transfers");
+    parameter_unsigned_c merged_transfers = parameter_unsigned_c(this, "merged_transfers", "mt", /*readonly*/
+            true, "", "%d", "Commands merged into the transfer of another command", 32, 10);
+    parameter_double_c transfer_size = parameter_double_c(this, "transfer_size", "ts", /*readonly*/
+            true, "blocks", "%0.1f", "Average blocks per image access of READ/WRITE");
    	
 public:
 
     //
     // Returns the next command message from the command ring, if any.
-    // Returns NULL if the ring is empty.  error is set to true if
-    // an error occurred while reading the message.
+    // Returns NULL if the ring is empty or no message buffer is free.
+    // error is set to true if an error occurred while reading the message.
+    // The message must be returned with ReleaseCommand().
     //
     Message* GetNextCommand(bool* error);
+    void ReleaseCommand(Message* message) { _messagePool.Release(message); }
 
     //
     // Posts a response message to the response ring and memory
@@ -131,6 +169,9 @@ public:
 
     PortType GetPortType(void) { return _portType; }
 
+    // 64 KB transfer throughput of an MSCP unit, see mscp_server
+    bool TransferBenchmark(uint16_t unitNumber, uint32_t address, unsigned count);
+
 private:
     // TODO: consolidate these private/public groups here 
     void Reset(void);
@@ -157,6 +198,23 @@ public:
 
     bool DMAWrite(uint32_t address, size_t lengthInBytes, uint8_t* buffer);
     uint8_t* DMARead(uint32_t address, size_t lengthInBytes, size_t bufferSize);
+    bool DMARead(uint32_t address, size_t lengthInBytes, uint8_t* buffer);
+
+    // Non-blocking transfers: one in flight, buffer must be valid until DMAWait()
+    void DMAWriteAsync(uint32_t address, size_t lengthInBytes, uint8_t* buffer);
+    void DMAReadAsync(uint32_t address, size_t lengthInBytes, uint8_t* buffer);
+    bool DMAWait(void);
+
+    // Scatter-gather transfers, one bus request for all segments
+    bool DMAWrite(const dma_segment_t* segments, unsigned segmentCount);
+    bool DMARead(const dma_segment_t* segments, unsigned segmentCount);
+
+private:
+    // The MSCP unit threads share dma_request: a transfer locks it
+    // until complete, for async transfers until DMAWait().
+    pthread_mutex_t _dmaMutex;
+    // Serializes ring interrupts of polling and unit threads
+    pthread_mutex_t _intrMutex;
 
 private:
     void update_SA(uint16_t value);
@@ -165,6 +223,9 @@ private:
     qunibusdevice_register_t *IP_reg;
     qunibusdevice_register_t *SA_reg;
 
+    // before _server: server threads return messages on destruction
+    MessagePool _messagePool;
+
     std::shared_ptr<mscp_server_base> _server;
 
     uint32_t _ringBase;
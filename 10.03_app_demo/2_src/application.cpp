@@ -31,6 +31,7 @@
  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+ 16-oct-2026  agent   option "virtualpru"
  12-nov-2018  JH      entered beta phase
  14-May-2018 	JH      created
 
@@ -111,6 +112,9 @@ void application_c::help()
     std::cout << "sudo ./" PROGNAME "\n";
     std::cout << "    Show interactive menus.\n";
     std::cout << "\n";
+    std::cout << "./" PROGNAME " -vpru -cf testseq\n";
+    std::cout << "    Run a command file on a Linux host, with virtual PRU and bus.\n";
+    std::cout << "\n";
 
     exit(1);
 }
@@ -179,6 +183,11 @@ void application_c::parse_commandline(int argc, char **argv)
                          "Mandatory address width of QBUS CPU: 16, 18, 22.\nCan not be auto-probed from backplane address width.", "",
                          "", "", "");
 #endif
+    getopt_parser.define("vpru", "virtualpru", "", "", "",
+                         "Run without BeagleBone hardware: PRU and " QUNIBUS_NAME " are emulated\n"
+                         "by a thread in this process. No physical bus, no timing.\n"
+                         "For profiling and regression tests of device emulation.", "",
+                         "", "", "");
     getopt_parser.define("leds", "leds", "ledcode", "", "",
                          "<decimal number>: Display number 0..15 on 4 binary LEDs.\n"
                          "\"debug\": LEDs not used, free for internal debugging.", "",
@@ -215,6 +224,8 @@ void application_c::parse_commandline(int argc, char **argv)
             qunibus->set_addr_width(aw) ;
             // now iopageregisters_init() possible
 #endif
+        } else if (getopt_parser.isoption("virtualpru")) {
+            pru->backend = pru_c::BACKEND_VIRTUAL;
         } else if (getopt_parser.isoption("leds")) {
             std::string s ;
             // Option "debug" ?
@@ -311,7 +322,7 @@ int application_c::run(int argc, char *argv[])
     DEBUG("Printing DEBUG output. Log file = \"%s\"", logger->default_filepath.c_str());
 
     /* prussdrv_init() will segfault if called with EUID != 0 */
-    if (geteuid()) {
+    if (!pru->is_virtual() && geteuid()) {
         FATAL("%s must be run as root to use prussdrv\n", argv[0]);
     }
 
@@ -23,6 +23,18 @@
  16-Nov-2018  JH      created
  16-Oct-2022  MR      Copied the "m lt file" option from other menu to here
  27-Feb-2023  JD/JH   RS11/RF11 new. KE11 EAE for UNIBUS.
+ 16-Oct-2026  agent   "vb": virtual bus benchmark
+ 16-Oct-2026  agent   "rqs": request scheduling statistics
+ 16-Oct-2026  agent   bus timeout address from DMA request, not PRU mailbox
+ 16-Oct-2026  agent   "vb" with DATO value
+ 16-Oct-2026  agent   "ret", "rep": register event trace and replay
+ 16-Oct-2026  agent   "fsbench": RT-11 parse benchmark
+ 16-Oct-2026  agent   "snapshot", "rollback": storage drive image snapshots
+ 16-Oct-2026  agent   "commit", "discard": storage drive image overlays
+ 16-Oct-2026  agent   "flush": write back storage drive image caches
+ 16-Oct-2026  agent   "diag": third run with instrumented bus access
+ 16-Oct-2026  agent   "diag": MAINDEC run on CPU20, reference and predecoded
+ 16-Oct-2026  agent   "mscpbench": MSCP 64 KB transfer benchmark
  */
 
 #include <stdio.h>
@@ -38,6 +50,7 @@
 #include "application.hpp" // own
 
 #include "pru.hpp"
+#include "pru_virtual.hpp"
 #include "gpios.hpp"
 #include "buslatches.hpp"
 #include "mailbox.h"
@@ -50,6 +63,8 @@
 #include "qunibusdevice.hpp"
 
 #include "storagedrive.hpp"
+#include "sharedfilesystem/storageimage_partition.hpp"
+#include "sharedfilesystem/filesystem_rt11.hpp"
 #include "panel.hpp"
 #include "blinkenbone.hpp"
 #include "demo_io.hpp"
@@ -119,6 +134,92 @@ static void load_memory(memory_fileformat_t format, char *fname, const char *ent
     }
 }
 
+#if defined(UNIBUS)
+// Run a MAINDEC paper tape diagnostic (ZKAA..ZKAM) on CPU20 from 200 for "run_ms".
+// These loop endlessly, a HALT is an error.
+// "cycle_trace": run with instrumented bus access (trigger, cycle trace buffer)
+static void cpu_diag_run(cpu_c *cpu, char *fname, bool predecode, bool cycle_trace, unsigned run_ms)
+{
+    timeout_c timeout;
+    bool error_halt;
+    const char *label = predecode ? "Predecoded" : "Reference ";
+
+    load_memory(fileformat_papertape, fname, NULL);
+    cpu->halt_switch.value = false;
+    cpu->predecode.value = predecode;
+    // only set, the trace file is written on trigger halt
+    cpu->cycle_tracefilepath.set(cycle_trace ? "cpu20_diag_cycletrace.csv" : "");
+    if (cycle_trace)
+        label = "Instrumented" ;
+    cpu->pc.value = 0200;
+    cpu->cycle_count.value = 0;
+    // worker resets and starts. It clears the momentary switch on every loop,
+    // so repeat until CPU has started.
+    for (unsigned i = 0; i < 100 && !cpu->runmode.value && cpu->cycle_count.value == 0; i++) {
+        cpu->start_switch.value = true;
+        timeout.wait_ms(10);
+    }
+    timeout.wait_ms(run_ms);
+    error_halt = !cpu->runmode.value;
+    cpu->halt_switch.value = true;
+    while (cpu->runmode.value)
+        timeout.wait_ms(1);
+    cpu->halt_switch.value = false;
+    printf("%-12s: %llu instructions in %u ms = %llu per second. ", label,
+           (unsigned long long) cpu->cycle_count.value, run_ms,
+           (unsigned long long) cpu->cycle_count.value * 1000 / (run_ms ? run_ms : 1));
+    if (error_halt)
+        printf("ERROR: HALT at %06o\n", (unsigned) cpu->pc.value);
+    else
+        printf("OK, stopped at %06o\n", (unsigned) cpu->pc.value);
+}
+#endif
+
+// Parse the RT-11 filesystem in the image file of "drive" "count" times.
+// Once with file I/O into buffers, once on views of the memory mapped image.
+static void rt11_parse_benchmark(storagedrive_c *drive, unsigned count)
+{
+    std::string image_path = drive->image_filepath.value ;
+    for (std::string prefix : { "mmap:", "chunked:" })
+        if (image_path.compare(0, prefix.size(), prefix) == 0)
+            image_path = image_path.substr(prefix.size()) ;
+    // partition like a shared filesystem: until bad sector file
+    uint64_t partition_size = drive->geometry.get_raw_capacity() - drive->geometry.filesystem_offset ;
+    if (drive->geometry.bad_sector_file_offset)
+        partition_size = drive->geometry.bad_sector_file_offset ;
+
+    for (int mapped = 0; mapped <= 1; mapped++) {
+        storageimage_base_c *image ;
+        if (mapped)
+            image = new storageimage_mmap_c(image_path, storageimage_mmap_c::sync_close) ;
+        else
+            image = new storageimage_binfile_c(image_path) ;
+        if (!image->open(drive, false)) {
+            printf("Can not open image \"%s\".\n", image_path.c_str()) ;
+            delete image ;
+            return ;
+        }
+        unsigned file_count ;
+        uint64_t start_ns ;
+        uint64_t elapsed_ns ;
+        {
+            sharedfilesystem::storageimage_partition_c partition(image, drive->geometry.filesystem_offset, partition_size,
+                    sharedfilesystem::fst_rt11) ;
+            sharedfilesystem::filesystem_rt11_c filesystem(&partition) ;
+            start_ns = timeout_c::abstime_ns() ;
+            for (unsigned i = 0; i < count; i++)
+                filesystem.parse() ;
+            elapsed_ns = timeout_c::abstime_ns() - start_ns ;
+            file_count = filesystem.rootdir->file_count() ;
+        }
+        image->close() ;
+        delete image ;
+        printf("%-8s: %u files, %u parses in %llu ms = %llu us per parse\n", mapped ? "mmap" : "binfile",
+               file_count, count, (unsigned long long)elapsed_ns / 1000000,
+               (unsigned long long)elapsed_ns / 1000 / (count ? count : 1)) ;
+    }
+}
+
 static void print_device(device_c *device)
 {
     qunibusdevice_c *ubdevice = dynamic_cast<qunibusdevice_c *>(device);
@@ -324,6 +425,30 @@ void application_c::menu_devices(const char *menu_code, bool with_emulated_CPU)
                     "dl11 wait <timeout_ms> <string>	wait time until DL11 was ordered to transmit <string>.\n");
                 printf("                     On timeout, script execution is terminated.\n");
             }
+            if (pru->is_virtual()) {
+                printf("vb <addr> [<count> [<val>]]  Virtual bus: <count> DATI cycles to <addr>, show latency\n");
+                printf("                     With <val>: DATO cycles writing <val>.\n");
+                printf("vb                   Show virtual PRU statistics\n");
+            }
+            printf("rqs [c]              Show (and clear) DMA/INTR request scheduling statistics\n");
+            printf("flush                Write changed image cache blocks of all storage drives\n");
+            printf("commit <drive>       Write changes in image overlay of <drive> to its image\n");
+            printf("discard <drive>      Drop changes in image overlay of <drive>\n");
+            printf("snapshot <drive> <name>  Save image of <drive> as \"<image>.<name>.snap\" in background\n");
+            printf("rollback <drive> <name>  Restore image of <drive> to snapshot <name>\n");
+            printf("fsbench <drive> [<count>]  Parse RT-11 filesystem in image of <drive>, from file and mapped\n");
+            printf("mscpbench <uda> <unit> <addr> [<count>]  Time 64 KB READs+WRITEs of MSCP <unit> via memory\n");
+            printf("                     at <addr>, buffers allocated and direct. Memory is overwritten.\n");
+#if defined(UNIBUS)
+            if (cpu && cpu->enabled.value) {
+                printf("diag <file> [<ms>]   Run MAINDEC paper tape diagnostic on CPU20 from 200 for <ms>,\n");
+                printf("                     with reference decoder, predecoded, and predecoded with\n");
+                printf("                     bus cycle trace. Check for HALT.\n");
+            }
+#endif
+            printf("ret [<count>]        Record trace of next <count> device register events\n");
+            printf("rep [<loops>]        Replay register event trace <loops> times, show ARM time per event.\n");
+            printf("                     Device logic executes the events again! Bus should be idle.\n");
             printf("dbg c|s|f            Debug log: Clear, Show on console, dump to File.\n");
             printf("                       (file = %s)\n", logger->default_filepath.c_str());
             printf("init                 Pulse " QUNIBUS_NAME " INIT\n");
@@ -548,7 +673,7 @@ void application_c::menu_devices(const char *menu_code, bool with_emulated_CPU)
                 } else
                     printf("DEPOSIT %s <- %06o\n", qunibus->addr2text(addr), wordbuffer);
                 if (timeout)
-                    printf("Bus timeout at %s.\n", qunibus->addr2text(mailbox->dma.cur_addr));
+                    printf("Bus timeout at %s.\n", qunibus->addr2text(qunibus->dma_request->qunibus_end_addr));
             } else if (!strcasecmp(s_opcode, "e") && n_fields <= 2) {
                 bool timeout = false;
                 uint32_t addr;
@@ -570,7 +695,7 @@ void application_c::menu_devices(const char *menu_code, bool with_emulated_CPU)
                     unsigned wordcount = unibuscontroller->register_count;
                     if (wordcount) {
                         timeout = !qunibus->dma(true, QUNIBUS_CYCLE_DATI, addr, wordbuffer, wordcount);
-                        for (unsigned i = 0; addr <= mailbox->dma.cur_addr; i++, addr += 2) {
+                        for (unsigned i = 0; addr <= qunibus->dma_request->qunibus_end_addr; i++, addr += 2) {
                             reg = unibuscontroller->register_by_unibus_address(addr);
                             assert(reg);
                             printf("EXAM reg #%d %s %s -> %06o\n", reg->index, reg->name,
@@ -585,8 +710,145 @@ void application_c::menu_devices(const char *menu_code, bool with_emulated_CPU)
                     show_help = true;
                 }
                 if (timeout)
-                    printf("Bus timeout at %s.\n", qunibus->addr2text(mailbox->dma.cur_addr));
+                    printf("Bus timeout at %s.\n", qunibus->addr2text(qunibus->dma_request->qunibus_end_addr));
                 // cur_addr now on last address in block
+            } else if (pru->is_virtual() && !strcasecmp(s_opcode, "vb") && n_fields <= 4) {
+                // a foreign bus master accesses registers or memory,
+                // device logic on ARM processes the register events.
+                if (n_fields >= 2) {
+                    uint32_t addr;
+                    unsigned count = 1000;
+                    uint16_t wordbuffer = 0;
+                    bool dato = false;
+                    uint64_t cycle_ns, max_ns = 0;
+                    bool timeout = false;
+                    timeout_c cycle_timer, total_timer;
+                    qunibus->parse_addr(s_param[0], &addr);
+                    if (n_fields >= 3)
+                        count = strtol(s_param[1], NULL, 10);
+                    if (n_fields == 4) {
+                        qunibus->parse_word(s_param[2], &wordbuffer);
+                        dato = true;
+                    }
+                    total_timer.start_ns(0);
+                    for (unsigned i = 0; !timeout && i < count; i++) {
+                        cycle_timer.start_ns(0);
+                        if (dato)
+                            timeout = !pru->virtual_pru->dato(addr, wordbuffer);
+                        else
+                            timeout = !pru->virtual_pru->dati(addr, &wordbuffer);
+                        cycle_ns = cycle_timer.elapsed_ns();
+                        if (cycle_ns > max_ns)
+                            max_ns = cycle_ns;
+                    }
+                    if (timeout)
+                        printf("Bus timeout at %s.\n", qunibus->addr2text(addr));
+                    else
+                        printf("%u * %s %s %s %06o: avg %llu ns, max %llu ns per cycle.\n",
+                               count, dato ? "DATO" : "DATI", qunibus->addr2text(addr),
+                               dato ? "<-" : "->", wordbuffer,
+                               (unsigned long long) (total_timer.elapsed_ns() / (count ? count : 1)),
+                               (unsigned long long) max_ns);
+                }
+                pru->virtual_pru->print_statistics();
+            } else if (!strcasecmp(s_opcode, "rqs") && n_fields <= 2) {
+                qunibusadapter->print_request_statistics();
+                if (n_fields == 2 && !strcasecmp(s_param[0], "c"))
+                    qunibusadapter->clear_request_statistics();
+#if defined(UNIBUS)
+            } else if (cpu && cpu->enabled.value && !strcasecmp(s_opcode, "diag")
+                       && (n_fields == 2 || n_fields == 3)) {
+                // diag <file> [<ms>]
+                unsigned run_ms = 3000;
+                if (n_fields == 3)
+                    run_ms = strtol(s_param[1], NULL, 10);
+                std::string cycle_tracefilepath = cpu->cycle_tracefilepath.value;
+                cpu_diag_run(cpu, s_param[0], false, false, run_ms);
+                cpu_diag_run(cpu, s_param[0], true, false, run_ms);
+                cpu_diag_run(cpu, s_param[0], true, true, run_ms);
+                cpu->cycle_tracefilepath.set(cycle_tracefilepath);
+#endif
+            } else if (!strcasecmp(s_opcode, "flush") && n_fields == 1) {
+                std::list<device_c *>::iterator it;
+                for (it = device_c::mydevices.begin(); it != device_c::mydevices.end(); ++it) {
+                    storagedrive_c *drive = dynamic_cast<storagedrive_c *>(*it);
+                    if (drive && drive->cache_blocks.value > 0) {
+                        drive->image_flush();
+                        printf("%s: image cache flushed in %u us.\n", drive->name.value.c_str(),
+                               drive->cache_flush_latency.value);
+                    }
+                }
+            } else if ((!strcasecmp(s_opcode, "commit") || !strcasecmp(s_opcode, "discard"))
+                       && n_fields == 2) {
+                storagedrive_c *drive = dynamic_cast<storagedrive_c *>(device_c::find_by_name(s_param[0]));
+                if (!drive) {
+                    std::cout << "Storage drive \"" << s_param[0] << "\" not found.\n";
+                    show_help = true;
+                } else if (drive->image_overlay_filepath.value.empty() || !drive->image_is_open())
+                    printf("%s: no image overlay in use.\n", drive->name.value.c_str());
+                else if (!strcasecmp(s_opcode, "commit")) {
+                    if (drive->image_overlay_commit())
+                        printf("%s: image overlay committed.\n", drive->name.value.c_str());
+                } else if (drive->image_overlay_discard())
+                    printf("%s: image overlay discarded.\n", drive->name.value.c_str());
+            } else if ((!strcasecmp(s_opcode, "snapshot") || !strcasecmp(s_opcode, "rollback"))
+                       && n_fields == 3) {
+                storagedrive_c *drive = dynamic_cast<storagedrive_c *>(device_c::find_by_name(s_param[0]));
+                if (!drive) {
+                    std::cout << "Storage drive \"" << s_param[0] << "\" not found.\n";
+                    show_help = true;
+                } else if (!drive->image_is_open())
+                    printf("%s: no image in use.\n", drive->name.value.c_str());
+                else if (!strcasecmp(s_opcode, "snapshot")) {
+                    if (drive->image_snapshot_take(s_param[1]))
+                        printf("%s: snapshot \"%s\" taken.\n", drive->name.value.c_str(), s_param[1]);
+                } else if (drive->image_snapshot_rollback(s_param[1]))
+                    printf("%s: rolled back to snapshot \"%s\".\n", drive->name.value.c_str(), s_param[1]);
+            } else if (!strcasecmp(s_opcode, "fsbench") && (n_fields == 2 || n_fields == 3)) {
+                storagedrive_c *drive = dynamic_cast<storagedrive_c *>(device_c::find_by_name(s_param[0]));
+                unsigned count = 100;
+                if (n_fields == 3)
+                    count = strtol(s_param[1], NULL, 10);
+                if (!drive) {
+                    std::cout << "Storage drive \"" << s_param[0] << "\" not found.\n";
+                    show_help = true;
+                } else if (drive->image_filepath.value.empty())
+                    printf("%s: no image file.\n", drive->name.value.c_str());
+                else
+                    rt11_parse_benchmark(drive, count);
+            } else if (!strcasecmp(s_opcode, "mscpbench") && (n_fields == 4 || n_fields == 5)) {
+                uda_c *uda = dynamic_cast<uda_c *>(device_c::find_by_name(s_param[0]));
+                unsigned unit = strtol(s_param[1], NULL, 10);
+                uint32_t addr;
+                unsigned count = 100;
+                if (n_fields == 5)
+                    count = strtol(s_param[3], NULL, 10);
+                if (!uda) {
+                    std::cout << "MSCP controller \"" << s_param[0] << "\" not found.\n";
+                    show_help = true;
+                } else if (!qunibus->parse_addr(s_param[2], &addr)
+                           || addr + 64 * 1024 > qunibus->addr_space_byte_count)
+                    printf("No 64 KB memory at %s.\n", s_param[2]);
+                else if (!uda->TransferBenchmark(unit, addr, count))
+                    printf("%s is no MSCP disk controller.\n", uda->name.value.c_str());
+            } else if (!strcasecmp(s_opcode, "ret") && n_fields <= 2) {
+                unsigned count = 1000;
+                if (n_fields == 2)
+                    count = strtol(s_param[0], NULL, 10);
+                qunibusadapter->register_event_trace_start(count);
+                printf("Recording next %u register events.\n", count);
+            } else if (!strcasecmp(s_opcode, "rep") && n_fields <= 2) {
+                unsigned loops = 100;
+                unsigned count = qunibusadapter->register_event_trace_recorded();
+                if (n_fields == 2)
+                    loops = strtol(s_param[0], NULL, 10);
+                if (count == 0)
+                    printf("No register events recorded, use \"ret\" first.\n");
+                else {
+                    uint64_t event_ns = qunibusadapter->register_event_trace_replay(loops);
+                    printf("%u * %u register events replayed: avg %llu ns per event.\n", loops,
+                           count, (unsigned long long) event_ns);
+                }
             } else if (DL11->enabled.value && !strcasecmp(s_opcode, "dl11")) {
                 if ((n_fields == 3 || n_fields == 4) && !strcasecmp(s_param[0], "rcv")) {
                     // dl11 rcv [<wait_ms>] <string>
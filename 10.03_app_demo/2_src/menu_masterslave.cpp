@@ -23,6 +23,7 @@ IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 16-Nov-2018  JH      created
+16-Oct-2026  agent   bus timeout address from DMA request, not PRU mailbox
 */
 #include <stdio.h>
 #include <stdlib.h>
@@ -263,7 +264,7 @@ void application_c::menu_masterslave(const char * menu_code, bool with_cpu_arbit
                 printf("EXAM %s -> %06o\n", qunibus->addr2text(cur_addr), wordbuffer[i]);
             cur_addr = qunibus->dma_request->qunibus_end_addr;
             if (timeout)
-                printf("Bus timeout at %s.\n", qunibus->addr2text(mailbox->dma.cur_addr));
+                printf("Bus timeout at %s.\n", qunibus->addr2text(qunibus->dma_request->qunibus_end_addr));
 
             // cur_addr now on last address in block
         }